@@ -0,0 +1,640 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BATCH_VALIDATION_H
+#define BATCH_VALIDATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Container.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+#if !defined(PACO_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define PACO_SIMD_X86
+    #include <immintrin.h>
+#endif
+
+namespace paco
+{
+
+namespace simd
+{
+
+/**
+ * @brief The Level enum names the instruction sets the batch validation has kernels for.
+ */
+enum Level
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief detected returns the best instruction set of the running CPU, checked once.
+ * Without GCC or Clang on x86, or with PACO_NO_SIMD defined, it is always Scalar.
+ * @return the instruction set used by default.
+ */
+inline Level detected()
+{
+#ifdef PACO_SIMD_X86
+    static const Level level = __builtin_cpu_supports("avx512f") ? AVX512
+                             : __builtin_cpu_supports("avx2") ? AVX2
+                             : __builtin_cpu_supports("sse2") ? SSE2
+                             : Scalar;
+    return level;
+#else
+    return Scalar;
+#endif
+}
+
+/**
+ * @brief name returns the name of an instruction set.
+ * @param level the instruction set.
+ * @return the name.
+ */
+inline const char* name(Level level)
+{
+    switch(level)
+    {
+    case SSE2: return "sse2";
+    case AVX2: return "avx2";
+    case AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+/**
+ * @brief popcount returns the number of set bits of a word.
+ */
+inline int popcount(std::uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int bits = 0;
+    for(; word != 0; word &= word - 1)
+    {
+        bits++;
+    }
+    return bits;
+#endif
+}
+
+/**
+ * @brief lowestBit returns the index of the lowest set bit of a word that is not 0.
+ */
+inline int lowestBit(std::uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    for(; (word & 1) == 0; word >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * @brief The Kernels struct holds the comparisons for every instruction set.
+ * matchWords sets bit i of the output words if values[i] == value, equalIds compares two arrays of type ids.
+ */
+struct Kernels
+{
+    static void matchWordsScalar(const std::uint64_t* values, std::size_t first, std::size_t count, std::uint64_t value, std::uint64_t* words)
+    {
+        for(std::size_t i = first; i < count; i++)
+        {
+            words[i / 64] |= (std::uint64_t)(values[i] == value) << (i % 64);
+        }
+    }
+
+    static bool equalIdsScalar(const std::int32_t* lhs, const std::int32_t* rhs, std::size_t count)
+    {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            if(lhs[i] != rhs[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+#ifdef PACO_SIMD_X86
+    __attribute__((target("sse2")))
+    static void matchWordsSSE2(const std::uint64_t* values, std::size_t count, std::uint64_t value, std::uint64_t* words)
+    {
+        const __m128i target = _mm_set1_epi64x((long long)value);
+        std::size_t i = 0;
+
+        for(; i + 2 <= count; i += 2)
+        {
+            // SSE2 has no 64 bit compare, both 32 bit halves have to be equal
+            __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), target);
+            equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            words[i / 64] |= (std::uint64_t)_mm_movemask_pd(_mm_castsi128_pd(equal)) << (i % 64);
+        }
+
+        matchWordsScalar(values, i, count, value, words);
+    }
+
+    __attribute__((target("sse2")))
+    static bool equalIdsSSE2(const std::int32_t* lhs, const std::int32_t* rhs, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i)));
+
+            if(_mm_movemask_epi8(equal) != 0xffff)
+            {
+                return false;
+            }
+        }
+
+        return equalIdsScalar(lhs + i, rhs + i, count - i);
+    }
+
+    __attribute__((target("avx2")))
+    static void matchWordsAVX2(const std::uint64_t* values, std::size_t count, std::uint64_t value, std::uint64_t* words)
+    {
+        const __m256i target = _mm256_set1_epi64x((long long)value);
+        std::size_t i = 0;
+
+        for(; i + 4 <= count; i += 4)
+        {
+            __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), target);
+
+            words[i / 64] |= (std::uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal)) << (i % 64);
+        }
+
+        matchWordsScalar(values, i, count, value, words);
+    }
+
+    __attribute__((target("avx2")))
+    static bool equalIdsAVX2(const std::int32_t* lhs, const std::int32_t* rhs, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i)));
+
+            if(_mm256_movemask_epi8(equal) != -1)
+            {
+                return false;
+            }
+        }
+
+        return equalIdsScalar(lhs + i, rhs + i, count - i);
+    }
+
+    __attribute__((target("avx512f")))
+    static void matchWordsAVX512(const std::uint64_t* values, std::size_t count, std::uint64_t value, std::uint64_t* words)
+    {
+        const __m512i target = _mm512_set1_epi64((long long)value);
+        std::size_t i = 0;
+
+        for(; i + 8 <= count; i += 8)
+        {
+            __mmask8 equal = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(values + i), target);
+
+            words[i / 64] |= (std::uint64_t)equal << (i % 64);
+        }
+
+        matchWordsScalar(values, i, count, value, words);
+    }
+
+    __attribute__((target("avx512f")))
+    static bool equalIdsAVX512(const std::int32_t* lhs, const std::int32_t* rhs, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for(; i + 16 <= count; i += 16)
+        {
+            if(_mm512_cmpneq_epi32_mask(_mm512_loadu_si512(lhs + i), _mm512_loadu_si512(rhs + i)) != 0)
+            {
+                return false;
+            }
+        }
+
+        // the masked loads of the tail do not touch memory behind the arrays
+        __mmask16 tail = (__mmask16)((1u << (count - i)) - 1);
+
+        return _mm512_mask_cmpneq_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, lhs + i), _mm512_maskz_loadu_epi32(tail, rhs + i)) == 0;
+    }
+#endif
+
+    /**
+     * @brief matchWords dispatches to the kernel of an instruction set. Vectors never straddle two words,
+     * because 64 is a multiple of every vector width. Levels the CPU does not support fall back to detected().
+     */
+    static void matchWords(Level level, const std::uint64_t* values, std::size_t count, std::uint64_t value, std::uint64_t* words)
+    {
+#ifdef PACO_SIMD_X86
+        switch(level <= detected() ? level : detected())
+        {
+        case AVX512: matchWordsAVX512(values, count, value, words); return;
+        case AVX2: matchWordsAVX2(values, count, value, words); return;
+        case SSE2: matchWordsSSE2(values, count, value, words); return;
+        default: break;
+        }
+#else
+        (void)level;
+#endif
+        matchWordsScalar(values, 0, count, value, words);
+    }
+
+    /**
+     * @brief EqualIds compares two arrays of type ids.
+     */
+    typedef bool (*EqualIds)(const std::int32_t* lhs, const std::int32_t* rhs, std::size_t count);
+
+    /**
+     * @brief equalIds returns the id comparison of an instruction set, resolved once per batch.
+     */
+    static EqualIds equalIds(Level level)
+    {
+#ifdef PACO_SIMD_X86
+        switch(level <= detected() ? level : detected())
+        {
+        case AVX512: return &equalIdsAVX512;
+        case AVX2: return &equalIdsAVX2;
+        case SSE2: return &equalIdsSSE2;
+        default: break;
+        }
+#else
+        (void)level;
+#endif
+        return &equalIdsScalar;
+    }
+};
+
+}
+
+
+/**
+ * @brief The MatchMask class is the result of a batch validation, bit i is set if the i-th container matches.
+ */
+class MatchMask
+{
+public:
+
+    /**
+     * @brief MatchMask constructor.
+     * @param size the number of containers, all bits are cleared.
+     */
+    explicit MatchMask(std::size_t size = 0)
+        : mWords((size + 63) / 64, 0), mSize(size)
+    {
+    }
+
+    /**
+     * @brief size returns the number of containers.
+     * @return the number of bits.
+     */
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief test checks if a container matches.
+     * @param index the index of the container.
+     * @return true if the bit is set.
+     */
+    bool test(std::size_t index) const
+    {
+        return (mWords[index / 64] >> (index % 64)) & 1;
+    }
+
+    /**
+     * @brief count returns the number of matching containers.
+     * @return the number of set bits.
+     */
+    std::size_t count() const
+    {
+        std::size_t bits = 0;
+
+        for(std::size_t i = 0; i < mWords.size(); i++)
+        {
+            bits += paco::simd::popcount(mWords[i]);
+        }
+
+        return bits;
+    }
+
+    /**
+     * @brief all checks if all containers match.
+     * @return true if all bits are set.
+     */
+    bool all() const
+    {
+        return count() == mSize;
+    }
+
+    /**
+     * @brief words returns the bits, 64 containers per word, the first container in the lowest bit.
+     * @return the words.
+     */
+    const std::vector<std::uint64_t>& words() const
+    {
+        return mWords;
+    }
+
+    std::vector<std::uint64_t>& words()
+    {
+        return mWords;
+    }
+
+private:
+
+    std::vector<std::uint64_t> mWords;
+    std::size_t mSize;
+};
+
+
+/**
+ * @brief The SignatureBatch class stores the compact type signatures of many containers in packed arrays:
+ * one fingerprint per container and the type ids of all containers back to back.
+ * A batch is validated against a specification by comparing all fingerprints with vector instructions first;
+ * only containers with the same fingerprint have their type ids compared.
+ */
+class SignatureBatch
+{
+public:
+
+    /**
+     * @brief reserve reserves memory for signatures.
+     * @param signatures the number of signatures.
+     * @param ids the total number of type ids.
+     */
+    void reserve(std::size_t signatures, std::size_t ids)
+    {
+        mFingerprints.reserve(signatures);
+        mOffsets.reserve(signatures + 1);
+        mIds.reserve(ids);
+    }
+
+    /**
+     * @brief append adds the signature of a specification.
+     * @param specification the specification.
+     */
+    void append(const paco::Specification& specification)
+    {
+        for(int i = 0; i < specification.size(); i++)
+        {
+            mIds.push_back(specification.mPacketTypes[i].typeId());
+        }
+
+        close(specification.fingerprint());
+    }
+
+    /**
+     * @brief append adds the signature of a container.
+     * @param container the container.
+     */
+    void append(const paco::Container& container)
+    {
+        append(container.specification());
+    }
+
+    /**
+     * @brief append adds a signature given as type ids, e.g. received with a message.
+     * Throws std::out_of_range if a type id is not registered.
+     * @param ids the type ids.
+     * @param count the number of type ids.
+     */
+    void append(const paco::TypeId* ids, std::size_t count)
+    {
+        std::uint64_t fingerprint = 0;
+        std::uint64_t power = 1;
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            const paco::PacketTypeDescriptor* descriptor = paco::PacketTypeRegistry::instance().find(ids[i]);
+
+            if(descriptor == nullptr)
+            {
+                throw std::out_of_range("paco::SignatureBatch: unknown type id");
+            }
+
+            mIds.push_back(ids[i]);
+            fingerprint += descriptor->hash() * power;
+            power *= paco::Specification::FingerprintBase;
+        }
+
+        close(fingerprint);
+    }
+
+    /**
+     * @brief size returns the number of signatures.
+     * @return the number of signatures.
+     */
+    std::size_t size() const
+    {
+        return mFingerprints.size();
+    }
+
+    /**
+     * @brief clear removes all signatures and keeps the memory.
+     */
+    void clear()
+    {
+        mFingerprints.clear();
+        mOffsets.assign(1, 0);
+        mIds.clear();
+    }
+
+    /**
+     * @brief validate checks all signatures against a specification.
+     * @param specification the expected specification.
+     * @param level the instruction set, the best one of the CPU by default.
+     * @return the mask of the matching signatures.
+     */
+    paco::MatchMask validate(const paco::Specification& specification, paco::simd::Level level = paco::simd::detected()) const
+    {
+        paco::MatchMask mask(size());
+        paco::simd::Kernels::matchWords(level, mFingerprints.data(), size(), specification.fingerprint(), mask.words().data());
+
+        std::vector<std::uint64_t>& words = mask.words();
+        std::size_t first = 0;
+
+        while(first < words.size() && words[first] == 0)
+        {
+            first++;
+        }
+
+        if(first == words.size())
+        {
+            return mask;
+        }
+
+        // equal fingerprints are confirmed by comparing the type ids, like Specification::equals()
+        paco::simd::Kernels::EqualIds equalIds = paco::simd::Kernels::equalIds(level);
+        std::vector<std::int32_t> expected;
+        expected.reserve(specification.size());
+
+        for(int i = 0; i < specification.size(); i++)
+        {
+            expected.push_back(specification.mPacketTypes[i].typeId());
+        }
+
+        for(std::size_t w = first; w < words.size(); w++)
+        {
+            for(std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1)
+            {
+                std::size_t i = w * 64 + paco::simd::lowestBit(bits);
+                std::size_t count = mOffsets[i + 1] - mOffsets[i];
+
+                if(count != expected.size() || !equalIds(mIds.data() + mOffsets[i], expected.data(), count))
+                {
+                    words[w] &= ~(1ull << (i % 64));
+                }
+            }
+        }
+
+        return mask;
+    }
+
+    /**
+     * @brief validate checks all signatures against several specifications.
+     * @param specifications the expected specifications.
+     * @param level the instruction set, the best one of the CPU by default.
+     * @return one mask per specification.
+     */
+    std::vector<paco::MatchMask> validate(const std::vector<paco::Specification>& specifications,
+                                          paco::simd::Level level = paco::simd::detected()) const
+    {
+        std::vector<paco::MatchMask> masks;
+        masks.reserve(specifications.size());
+
+        for(std::size_t s = 0; s < specifications.size(); s++)
+        {
+            masks.push_back(validate(specifications[s], level));
+        }
+
+        return masks;
+    }
+
+private:
+
+    void close(std::uint64_t fingerprint)
+    {
+        if(mOffsets.empty())
+        {
+            mOffsets.push_back(0);
+        }
+
+        mFingerprints.push_back(fingerprint);
+        mOffsets.push_back(mIds.size());
+    }
+
+private:
+
+    /**
+     * @brief mFingerprints the fingerprint of every signature.
+     */
+    std::vector<std::uint64_t> mFingerprints;
+
+    /**
+     * @brief mOffsets the first type id of every signature in mIds, followed by the end of the last one.
+     */
+    std::vector<std::uint32_t> mOffsets;
+
+    /**
+     * @brief mIds the type ids of all signatures.
+     */
+    std::vector<std::int32_t> mIds;
+};
+
+
+/**
+ * @brief validateBatch checks many containers against a specification.
+ * The fingerprints of the containers are packed and compared with vector instructions,
+ * containers with an equal fingerprint are confirmed with Container::matches().
+ * @param containers the containers.
+ * @param count the number of containers.
+ * @param specification the expected specification.
+ * @param level the instruction set, the best one of the CPU by default.
+ * @return the mask of the matching containers.
+ */
+inline paco::MatchMask validateBatch(const paco::Container* const* containers, std::size_t count,
+                                     const paco::Specification& specification, paco::simd::Level level = paco::simd::detected())
+{
+    paco::MatchMask mask(count);
+    std::vector<std::uint64_t>& words = mask.words();
+    std::uint64_t fingerprints[64];
+
+    for(std::size_t w = 0; w < words.size(); w++)
+    {
+        std::size_t first = w * 64;
+        std::size_t block = count - first < 64 ? count - first : 64;
+
+        for(std::size_t i = 0; i < block; i++)
+        {
+            fingerprints[i] = containers[first + i]->specification().fingerprint();
+        }
+
+        paco::simd::Kernels::matchWords(level, fingerprints, block, specification.fingerprint(), &words[w]);
+
+        for(std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1)
+        {
+            std::size_t i = paco::simd::lowestBit(bits);
+
+            if(!containers[first + i]->matches(specification))
+            {
+                words[w] &= ~(1ull << i);
+            }
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * @brief validateBatch checks many containers against several specifications.
+ * @param containers the containers.
+ * @param count the number of containers.
+ * @param specifications the expected specifications.
+ * @param level the instruction set, the best one of the CPU by default.
+ * @return one mask per specification.
+ */
+inline std::vector<paco::MatchMask> validateBatch(const paco::Container* const* containers, std::size_t count,
+                                                  const std::vector<paco::Specification>& specifications,
+                                                  paco::simd::Level level = paco::simd::detected())
+{
+    paco::SignatureBatch batch;
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        batch.append(*containers[i]);
+    }
+
+    return batch.validate(specifications, level);
+}
+
+}
+
+#endif // BATCH_VALIDATION_H
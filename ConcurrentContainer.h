@@ -0,0 +1,327 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CONCURRENT_CONTAINER_H
+#define CONCURRENT_CONTAINER_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "Instrumentation.h"
+#include "Packet.h"
+#include "PacketSlot.h"
+#include "PacketType.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The ConcurrentContainer class is a container that many threads can append to at the same time without locks.
+ *
+ * The elements live in segments that are allocated on demand and never move, segment k holding SegmentBase * 2^k
+ * elements. An append constructs the packet, makes sure the segment of the next index exists, reserves the index
+ * with a compare-and-swap and publishes the packet. Nothing can throw once an index is reserved, so every reserved
+ * index is published eventually. Published packets keep their address for the lifetime of the container.
+ *
+ * Reading is wait-free: at(i) returns the packet at index i if it has been published and nullptr otherwise.
+ * publishedSize() is the length of the prefix in which every element is published, so a reader can iterate
+ * [0, publishedSize()) without any checks. specification() takes a snapshot of that prefix.
+ *
+ * Elements cannot be removed or replaced. Destroying the container requires that no other thread uses it.
+ */
+class ConcurrentContainer
+{
+private:
+
+    /**
+     * template_type_must_be_specified_when_calling_append is a helper to force the programmer
+     * to use angle brackets <type> in append<type>(value). If not specified the compiler will not be able to compile.
+     */
+    template <typename T>
+    struct template_type_must_be_specified_when_calling_append
+    {
+        using type = T;
+    };
+
+    /**
+     * @brief The Element struct is a slot plus its publication flag.
+     */
+    struct Element
+    {
+        Element()
+            : published(false)
+        {
+        }
+
+        paco::PacketSlot slot;
+        std::atomic<bool> published;
+    };
+
+public:
+
+    /**
+     * @brief SegmentBase is the number of elements of the first segment.
+     */
+    static const std::size_t SegmentBase = 64;
+
+    /**
+     * @brief MaxSegments is the number of segments, enough for SegmentBase * (2^MaxSegments - 1) elements.
+     */
+    static const int MaxSegments = 40;
+
+    /**
+     * @brief ConcurrentContainer default constructor.
+     */
+    ConcurrentContainer()
+        : mReserved(0), mPublished(0)
+    {
+        for(int i = 0; i < MaxSegments; i++)
+        {
+            mSegments[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief ~ConcurrentContainer destructor.
+     */
+    ~ConcurrentContainer()
+    {
+        for(int i = 0; i < MaxSegments; i++)
+        {
+            delete[] mSegments[i].load(std::memory_order_acquire);
+        }
+    }
+
+    ConcurrentContainer(const ConcurrentContainer&) = delete;
+    ConcurrentContainer& operator=(const ConcurrentContainer&) = delete;
+
+    /**
+     * @brief append appends an object, may be called from many threads at the same time.
+     * The object is constructed and its segment allocated before an index is reserved, so a throwing constructor,
+     * a failed allocation or an exceeded capacity leaves no gap.
+     * @return the index of the object.
+     */
+    template <class T>
+    std::size_t append(typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        return emplace<T>(std::move(value));
+    }
+
+    /**
+     * @brief emplace constructs an object from args and appends it, may be called from many threads at the same time.
+     * @param args the constructor arguments of the object.
+     * @return the index of the object.
+     */
+    template <class T, class... Args>
+    std::size_t emplace(Args&&... args)
+    {
+        paco::PacketSlot slot(paco::PacketSlot::InPlace_T<T>(), std::forward<Args>(args)...);
+
+        // allocate may throw, so the index is only reserved once its element exists
+        std::size_t index = mReserved.load(std::memory_order_relaxed);
+        Element* element;
+
+        // the reservation is sequentially consistent like the published flag below and the loads in advancePublished(),
+        // a relaxed increment could let the thread publishing index - 1 miss it and stop the prefix before this element
+        do
+        {
+            element = &allocate(index);
+        }
+        while(!mReserved.compare_exchange_weak(index, index + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+        element->slot = std::move(slot);
+
+        // sequentially consistent, so that either this thread or the one publishing the previous index advances the prefix:
+        // in the single total order either its load of mReserved sees this reservation or this thread sees its flag
+        element->published.store(true);
+
+        advancePublished();
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+
+        return index;
+    }
+
+    /**
+     * @brief size returns the number of reserved indices, including elements that are not yet published.
+     * @return the number of reserved indices.
+     */
+    std::size_t size() const
+    {
+        return mReserved.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief publishedSize returns the length of the prefix in which all elements are published.
+     * @return the number of elements that can be read without checks.
+     */
+    std::size_t publishedSize() const
+    {
+        return mPublished.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief at returns the packet at an index, wait-free.
+     * @param index the index of the packet.
+     * @return the packet, or nullptr if the index has not been published yet.
+     */
+    paco::Packet* at(std::size_t index) const
+    {
+        const Element* element = find(index);
+
+        if(element == nullptr || !element->published.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return element->slot.packet();
+    }
+
+    /**
+     * @brief specification returns a snapshot of the specification of the published prefix.
+     * @return the specification of the elements [0, publishedSize()).
+     */
+    paco::Specification specification() const
+    {
+        paco::Specification specification;
+        std::size_t published = publishedSize();
+
+        for(std::size_t i = 0; i < published; i++)
+        {
+            specification.append_friend_class_only(find(i)->slot.packet()->packetType());
+        }
+
+        return specification;
+    }
+
+private:
+
+    /**
+     * @brief locate computes the segment and the offset inside the segment of an index.
+     */
+    static void locate(std::size_t index, int* segment, std::size_t* offset)
+    {
+        std::size_t n = index / SegmentBase + 1;
+        int k;
+
+#if __GNUC__
+        k = 63 - __builtin_clzll((unsigned long long)n);
+#else
+        k = 0;
+        while(n >>= 1)
+        {
+            k++;
+        }
+#endif
+
+        *segment = k;
+        *offset = index - SegmentBase * ((std::size_t(1) << k) - 1);
+    }
+
+    /**
+     * @brief find returns the element of an index, or nullptr if its segment has not been allocated yet.
+     */
+    const Element* find(std::size_t index) const
+    {
+        int segment;
+        std::size_t offset;
+        locate(index, &segment, &offset);
+
+        if(segment >= MaxSegments)
+        {
+            return nullptr;
+        }
+
+        Element* elements = mSegments[segment].load(std::memory_order_acquire);
+
+        return elements != nullptr ? elements + offset : nullptr;
+    }
+
+    /**
+     * @brief allocate returns the element of a reserved index and allocates its segment if needed.
+     */
+    Element& allocate(std::size_t index)
+    {
+        int segment;
+        std::size_t offset;
+        locate(index, &segment, &offset);
+
+        if(segment >= MaxSegments)
+        {
+            throw std::length_error("paco::ConcurrentContainer: capacity exceeded");
+        }
+
+        Element* elements = mSegments[segment].load(std::memory_order_acquire);
+
+        if(elements == nullptr)
+        {
+            Element* allocated = new Element[SegmentBase << segment];
+
+            if(mSegments[segment].compare_exchange_strong(elements, allocated, std::memory_order_acq_rel))
+            {
+                elements = allocated;
+            }
+            else
+            {
+                // another thread installed the segment first, elements holds its segment now
+                delete[] allocated;
+            }
+        }
+
+        return elements[offset];
+    }
+
+    /**
+     * @brief advancePublished moves the published prefix over all consecutive published elements.
+     */
+    void advancePublished()
+    {
+        std::size_t published = mPublished.load();
+
+        while(published < mReserved.load())
+        {
+            const Element* element = find(published);
+
+            if(element == nullptr || !element->published.load())
+            {
+                return;
+            }
+
+            // on failure published is reloaded and the loop continues from the new prefix
+            if(mPublished.compare_exchange_weak(published, published + 1))
+            {
+                published++;
+            }
+        }
+    }
+
+private:
+
+    /**
+     * @brief mSegments the segments, allocated on demand.
+     */
+    std::atomic<Element*> mSegments[MaxSegments];
+
+    /**
+     * @brief mReserved the number of reserved indices.
+     */
+    std::atomic<std::size_t> mReserved;
+
+    /**
+     * @brief mPublished the length of the published prefix.
+     */
+    std::atomic<std::size_t> mPublished;
+};
+
+}
+
+#endif // CONCURRENT_CONTAINER_H
@@ -12,10 +12,19 @@
 #define CONTAINER_H
 
 #include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
 
+#include "Instrumentation.h"
+#include "MemoryResource.h"
 #include "Packet.h"
+#include "PacketSlot.h"
 #include "PacketType.h"
+#include "PacketVisitor.h"
+#include "SlotKey.h"
 #include "Specification.h"
+#include "TypeIndex.h"
 
 
 namespace paco
@@ -37,10 +46,32 @@ namespace paco
  * - etc.
  *
  * The type in the angle brackets has to match the type of the value, or otherwise the compiler will not proceed.
+ *
+ * Small trivially copyable objects (int, double, pointers, ...) are stored inline in the contiguous storage of the
+ * container, all other objects in a package on the heap, see PacketSlot. Like iterators of a std::vector,
+ * the package returned by at() is only valid until the container is modified.
+ *
+ * Elements can also be named by a key, which is stored as the description of the element in the specification:
+ *
+ *  container.append<double>("speed", 4.2);
+ *  double speed = container.get<double>("speed");
+ *
+ * Keys are unique within a container. They are kept in a small hash index (SlotKeyIndex) that follows inserts and
+ * removals, so a keyed access costs one hash lookup more than an indexed one.
+ *
+ * A container constructed with a std::pmr::memory_resource allocates its packets and its storage from it, e.g. from
+ * a std::pmr::monotonic_buffer_resource per request, which releases everything at once when the request is done:
+ *
+ *  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+ *  paco::Container container(&arena);
  */
 
 class Container
 {
+    friend class ContainerCodec;
+    friend class SharedContainer;
+    friend class SlotMapContainer;
+
 public:
 
     /**
@@ -51,6 +82,21 @@ public:
 
     }
 
+    /**
+     * @brief Container constructor that allocates from a memory resource, e.g. a per request arena.
+     * The packets stored on the heap, the contiguous storage, the specification, the type index and the key index
+     * come from the resource, which has to outlive the container. The resource moves along when the container is moved.
+     * @param resource the memory resource, nullptr for the global operator new.
+     */
+    explicit Container(std::pmr::memory_resource* resource)
+        : mSlots(paco::ResourceAllocator_T<paco::PacketSlot>(resource)),
+          mSpecification(resource),
+          mKeys(resource),
+          mTypes(resource)
+    {
+
+    }
+
     /**
      * @brief ~Container destructor.
      */
@@ -59,6 +105,28 @@ public:
         this->clear();
     }
 
+    /**
+     * @brief Container move constructor.
+     * @param other the container to move from, empty afterwards.
+     */
+    Container(Container&& other) = default;
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the container to move from, empty afterwards.
+     * @return this container.
+     */
+    Container& operator=(Container&& other) = default;
+
+    /**
+     * @brief resource returns the memory resource of this container.
+     * @return the memory resource, or nullptr if the container allocates with the global operator new.
+     */
+    std::pmr::memory_resource* resource() const
+    {
+        return mSlots.get_allocator().resource();
+    }
+
 private:
 
     /**
@@ -77,19 +145,56 @@ public:
      * @brief size
      * @return the number of elements in the container.
      */
-    int size()
+    int size() const
     {
-        return mPackets.size();
+        return mSlots.size();
     }
 
     /**
      * @brief append the method for appending objects into the container.
-     * The object is automatically wrapped into a package.
+     * The object is automatically wrapped into a package. Pass an rvalue to move the object into the container.
      */
     template <class T>
     void append(typename template_type_must_be_specified_when_calling_append<T>::type value)
     {
-        mPackets.push_back(new paco::Packet_T<T>(value));
+        mSlots.emplace_back(paco::PacketSlot::InPlace_T<T>(resource()), std::move(value));
+        mSpecification.append_friend_class_only(mSlots.back().packet()->packetType());
+        mTypes.append(paco::PacketTypeRegistry::id<T>(), mSlots.size() - 1, mSpecification);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+    }
+
+    /**
+     * @brief append appends an object named by a key.
+     * Throws std::invalid_argument if the key is null or already used, the container is unchanged then.
+     * @param key the key of the object, see SlotKey.
+     */
+    template <class T>
+    void append(const paco::SlotKey& key, typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        checkKey(key);
+
+        mSlots.emplace_back(paco::PacketSlot::InPlace_T<T>(resource()), std::move(value));
+        mSpecification.append_friend_class_only(paco::PacketType(paco::PacketTypeRegistry::descriptor<T>(), key.interned()));
+        mKeys.insert(key, mSlots.size() - 1);
+        mTypes.append(paco::PacketTypeRegistry::id<T>(), mSlots.size() - 1, mSpecification);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+    }
+
+    /**
+     * @brief emplace the method for constructing objects directly inside the container.
+     * The object of type T is constructed from args at the end of the container without any copy or move.
+     * @param args the constructor arguments of the object.
+     * @return a reference to the new object, valid until the container is modified.
+     */
+    template <class T, class... Args>
+    T& emplace(Args&&... args)
+    {
+        mSlots.emplace_back(paco::PacketSlot::InPlace_T<T>(resource()), std::forward<Args>(args)...);
+        mSpecification.append_friend_class_only(mSlots.back().packet()->packetType());
+        mTypes.append(paco::PacketTypeRegistry::id<T>(), mSlots.size() - 1, mSpecification);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+
+        return static_cast<paco::Packet_T<T>*>(mSlots.back().packet())->dataRef();
     }
 
     /**
@@ -100,7 +205,32 @@ public:
     template <class T>
     void insert(int index, typename template_type_must_be_specified_when_calling_append<T>::type value)
     {
-        mPackets.insert(mPackets.begin() + index, new paco::Packet_T<T>(value));
+        SlotVector::iterator it = mSlots.emplace(mSlots.begin() + index, paco::PacketSlot::InPlace_T<T>(resource()), std::move(value));
+        mSpecification.insert_friend_class_only(index, it->packet()->packetType());
+        mKeys.shift(index, 1);
+        mTypes.shift(index, 1);
+        mTypes.insert(paco::PacketTypeRegistry::id<T>(), index, mSpecification);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+    }
+
+    /**
+     * @brief insert inserts an object named by a key.
+     * Throws std::invalid_argument if the key is null or already used, the container is unchanged then.
+     * @param index the desired index.
+     * @param key the key of the object, see SlotKey.
+     */
+    template <class T>
+    void insert(int index, const paco::SlotKey& key, typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        checkKey(key);
+
+        mSlots.emplace(mSlots.begin() + index, paco::PacketSlot::InPlace_T<T>(resource()), std::move(value));
+        mSpecification.insert_friend_class_only(index, paco::PacketType(paco::PacketTypeRegistry::descriptor<T>(), key.interned()));
+        mKeys.shift(index, 1);
+        mKeys.insert(key, index);
+        mTypes.shift(index, 1);
+        mTypes.insert(paco::PacketTypeRegistry::id<T>(), index, mSpecification);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
     }
     
     /**
@@ -110,11 +240,15 @@ public:
      */
     void removeAt(int index)
     {
-        if(index >= 0 && index < mPackets.size())
+        if(index >= 0 && index < mSlots.size())
         {
-            paco::Packet* packet = mPackets.at(index);
-            mPackets.erase(mPackets.begin()+index);
-            delete packet;
+            mKeys.erase(mSpecification.mPacketTypes[index].key());
+            mKeys.shift(index + 1, -1);
+            mTypes.erase(mSpecification.mPacketTypes[index].typeId(), index);
+            mTypes.shift(index + 1, -1);
+
+            mSlots.erase(mSlots.begin()+index);
+            mSpecification.removeAt(index);
         }
     }
 
@@ -124,25 +258,75 @@ public:
      */
     void clear()
     {
-        for(int i = 0; i < mPackets.size(); i++)
+        mSlots.clear();
+        mSpecification.clear_friend_class_only();
+        mKeys.clear();
+        mTypes.clear();
+    }
+
+    /**
+     * @brief replace replaces an object from the container at a certain index position.
+     * Pass an rvalue to move the object into the container. The key of the object is kept.
+     * @param index the index of the object that has to be replaced.
+     */
+    template <class T>
+    void replace(int i, T value)
+    {
+        paco::PacketSlot& slot = mSlots.at(i);
+        slot = paco::PacketSlot(paco::PacketSlot::InPlace_T<T>(resource()), std::move(value));
+
+        if(mSpecification.mPacketTypes[i].typeId() != paco::PacketTypeRegistry::id<T>())
         {
-            paco::Packet* packet = mPackets.at(i);
-            delete packet;
+            mTypes.erase(mSpecification.mPacketTypes[i].typeId(), i);
+            mTypes.insert(paco::PacketTypeRegistry::id<T>(), i, mSpecification);
         }
 
-        mPackets.clear();
+        mSpecification.replace_friend_class_only(i, paco::PacketType(paco::PacketTypeRegistry::descriptor<T>(),
+                                                                     mSpecification.mPacketTypes[i].key().interned()));
+        paco::Instrumentation::countReplace(paco::PacketTypeRegistry::descriptor<T>());
     }
 
     /**
-     * @brief replace replaces an object from the container at a certain index position.
-     * @param index the index of the object that has to be replaced.
+     * @brief replace replaces the object named by a key, keeping the key.
+     * Throws std::out_of_range if no object has the key.
+     * @param key the key of the object that has to be replaced.
+     */
+    template <class T>
+    void replace(const paco::SlotKey& key, T value)
+    {
+        replace<T>(checkedIndexOf(key), std::move(value));
+    }
+
+    /**
+     * @brief replace replaces the object named by a UTF-8 name, keeping the key. The name is not interned.
+     * Throws std::out_of_range if no object has the key.
+     * @param name the name of the key of the object that has to be replaced.
+     */
+    template <class T, class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    void replace(const Name& name, T value)
+    {
+        replace<T>(checkedIndexOf(std::string_view(name)), std::move(value));
+    }
+
+    /**
+     * @brief take moves an object out of the container and removes it from the container.
+     * @param index the index of the object that has to be taken.
+     * @return the object. If T and the object do not match then a std::bad_cast is thrown and the container is unchanged.
      */
     template <class T>
-    void replace(int i, const T value)
+    T take(int index)
     {
-        paco::Packet* old = mPackets.at(i);
-        std::replace(mPackets.begin(), mPackets.end(), old, dynamic_cast<Packet*>(new paco::Packet_T<T>(value)));
-        delete old;
+        T value = mSlots.at(index).packet()->take<T>();
+
+        mKeys.erase(mSpecification.mPacketTypes[index].key());
+        mKeys.shift(index + 1, -1);
+        mTypes.erase(mSpecification.mPacketTypes[index].typeId(), index);
+        mTypes.shift(index + 1, -1);
+
+        mSlots.erase(mSlots.begin() + index);
+        mSpecification.removeAt(index);
+
+        return value;
     }
 
     /**
@@ -152,32 +336,494 @@ public:
      */
     paco::Packet* at(int index)
     {
-        return mPackets.at(index);
+        return mSlots.at(index).packet();
+    }
+
+    /**
+     * @brief at
+     * @param index the index of the package with the object.
+     * @return returns the package carrying the object at position i.
+     */
+    const paco::Packet* at(int index) const
+    {
+        return mSlots.at(index).packet();
+    }
+
+    /**
+     * @brief get_if returns a pointer to the object at a certain index position if it has type T.
+     * Never throws, so it can be used to probe elements speculatively.
+     * @param index the index of the object.
+     * @return a pointer to the object, or nullptr if the index is out of range or the object is not a T.
+     */
+    template <class T>
+    T* get_if(int index)
+    {
+        if(index >= 0 && index < mSlots.size())
+        {
+            return mSlots[index].packet()->get_if<T>();
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief get returns a reference to the object at a certain index position.
+     * Throws std::out_of_range if the index is out of range and std::bad_cast if the object is not a T.
+     * @param index the index of the object.
+     * @return a reference to the object, valid until the container is modified.
+     */
+    template <class T>
+    T& get(int index)
+    {
+        return mSlots.at(index).packet()->get_ref<T>();
+    }
+
+    /**
+     * @brief get returns a const reference to the object at a certain index position.
+     * Throws std::out_of_range if the index is out of range and std::bad_cast if the object is not a T.
+     * @param index the index of the object.
+     * @return a const reference to the object, valid until the container is modified.
+     */
+    template <class T>
+    const T& get(int index) const
+    {
+        return mSlots.at(index).packet()->get_cref<T>();
+    }
+
+    /**
+     * @brief indexOf<T> returns the index of the first object of type T, without looking at other objects.
+     * @return the index of the first T, or -1 if the container has no T.
+     */
+    template <class T>
+    int indexOf() const
+    {
+        return mTypes.first(paco::PacketTypeRegistry::id<T>(), mSpecification);
+    }
+
+    /**
+     * @brief count<T> returns the number of objects of type T in O(1).
+     * @return the number of objects of type T.
+     */
+    template <class T>
+    int count() const
+    {
+        return mTypes.count(paco::PacketTypeRegistry::id<T>(), mSpecification);
+    }
+
+    /**
+     * @brief range<T> returns all objects of type T in order, without scanning the container.
+     * The range yields T& without further type checks and is invalidated when the container is modified.
+     *
+     * Example:
+     *
+     *  for(QList<QString>* list : container.range<QList<QString>*>()) { ... }
+     *
+     * @return the range of the objects of type T.
+     */
+    template <class T>
+    paco::TypedRange_T<T> range()
+    {
+        paco::TypeId id = paco::PacketTypeRegistry::id<T>();
+
+        if(!mTypes.isBuilt())
+        {
+            return paco::TypedRange_T<T>(mSlots.data(), mSpecification, id);
+        }
+
+        return paco::TypedRange_T<T>(mSlots.data(), mTypes.positions(id));
+    }
+
+    /**
+     * @brief range<T> returns all objects of type T in order, without scanning the container.
+     * @return the range of the objects of type T, yielding const T&.
+     */
+    template <class T>
+    paco::TypedRange_T<const T> range() const
+    {
+        paco::TypeId id = paco::PacketTypeRegistry::id<T>();
+
+        if(!mTypes.isBuilt())
+        {
+            return paco::TypedRange_T<const T>(mSlots.data(), mSpecification, id);
+        }
+
+        return paco::TypedRange_T<const T>(mSlots.data(), mTypes.positions(id));
+    }
+
+    /**
+     * @brief contains checks if an object is named by a key.
+     * @param key the key.
+     * @return true if an object has the key.
+     */
+    bool contains(const paco::SlotKey& key) const
+    {
+        return mKeys.find(key) >= 0;
+    }
+
+    /**
+     * @brief contains checks if an object is named by a UTF-8 name, without interning it, see SlotKey::find().
+     * @param name the name of the key.
+     * @return true if an object has the key.
+     */
+    template <class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    bool contains(const Name& name) const
+    {
+        return mKeys.find(paco::SlotKey::find(name)) >= 0;
+    }
+
+    /**
+     * @brief indexOf returns the index of the object named by a key.
+     * @param key the key.
+     * @return the index of the object, or -1 if no object has the key.
+     */
+    int indexOf(const paco::SlotKey& key) const
+    {
+        return mKeys.find(key);
+    }
+
+    /**
+     * @brief indexOf returns the index of the object named by a UTF-8 name, without interning it.
+     * @param name the name of the key.
+     * @return the index of the object, or -1 if no object has the key.
+     */
+    template <class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    int indexOf(const Name& name) const
+    {
+        return mKeys.find(paco::SlotKey::find(name));
+    }
+
+    /**
+     * @brief key returns the key of the object at a certain index position.
+     * @param index the index of the object.
+     * @return the key, the null key if the object has none.
+     */
+    paco::SlotKey key(int index) const
+    {
+        return mSpecification.mPacketTypes.at(index).key();
+    }
+
+    /**
+     * @brief at returns the package carrying the object named by a key.
+     * Throws std::out_of_range if no object has the key.
+     * @param key the key of the object.
+     * @return the package, valid until the container is modified.
+     */
+    paco::Packet* at(const paco::SlotKey& key)
+    {
+        return mSlots[checkedIndexOf(key)].packet();
+    }
+
+    /**
+     * @brief at returns the package carrying the object named by a key.
+     * Throws std::out_of_range if no object has the key.
+     * @param key the key of the object.
+     * @return the package, valid until the container is modified.
+     */
+    const paco::Packet* at(const paco::SlotKey& key) const
+    {
+        return mSlots[checkedIndexOf(key)].packet();
+    }
+
+    /**
+     * @brief at returns the package carrying the object named by a UTF-8 name, without interning it.
+     * Throws std::out_of_range if no object has the key.
+     * @param name the name of the key of the object.
+     * @return the package, valid until the container is modified.
+     */
+    template <class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    paco::Packet* at(const Name& name)
+    {
+        return mSlots[checkedIndexOf(std::string_view(name))].packet();
+    }
+
+    /**
+     * @brief at returns the package carrying the object named by a UTF-8 name, without interning it.
+     * Throws std::out_of_range if no object has the key.
+     * @param name the name of the key of the object.
+     * @return the package, valid until the container is modified.
+     */
+    template <class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    const paco::Packet* at(const Name& name) const
+    {
+        return mSlots[checkedIndexOf(std::string_view(name))].packet();
+    }
+
+    /**
+     * @brief get returns a reference to the object named by a key.
+     * Throws std::out_of_range if no object has the key and std::bad_cast if the object is not a T.
+     * @param key the key of the object.
+     * @return a reference to the object, valid until the container is modified.
+     */
+    template <class T>
+    T& get(const paco::SlotKey& key)
+    {
+        return mSlots[checkedIndexOf(key)].packet()->get_ref<T>();
     }
 
+    /**
+     * @brief get returns a const reference to the object named by a key.
+     * Throws std::out_of_range if no object has the key and std::bad_cast if the object is not a T.
+     * @param key the key of the object.
+     * @return a const reference to the object, valid until the container is modified.
+     */
+    template <class T>
+    const T& get(const paco::SlotKey& key) const
+    {
+        return mSlots[checkedIndexOf(key)].packet()->get_cref<T>();
+    }
+
+    /**
+     * @brief get returns a reference to the object named by a UTF-8 name, without interning it.
+     * Throws std::out_of_range if no object has the key and std::bad_cast if the object is not a T.
+     * @param name the name of the key of the object.
+     * @return a reference to the object, valid until the container is modified.
+     */
+    template <class T, class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    T& get(const Name& name)
+    {
+        return mSlots[checkedIndexOf(std::string_view(name))].packet()->get_ref<T>();
+    }
+
+    /**
+     * @brief get returns a const reference to the object named by a UTF-8 name, without interning it.
+     * Throws std::out_of_range if no object has the key and std::bad_cast if the object is not a T.
+     * @param name the name of the key of the object.
+     * @return a const reference to the object, valid until the container is modified.
+     */
+    template <class T, class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    const T& get(const Name& name) const
+    {
+        return mSlots[checkedIndexOf(std::string_view(name))].packet()->get_cref<T>();
+    }
+
+    /**
+     * @brief get_if returns a pointer to the object named by a key if it has type T. Never throws.
+     * @param key the key of the object.
+     * @return a pointer to the object, or nullptr if no object has the key or the object is not a T.
+     */
+    template <class T>
+    T* get_if(const paco::SlotKey& key)
+    {
+        int index = mKeys.find(key);
+
+        return index >= 0 ? mSlots[index].packet()->get_if<T>() : nullptr;
+    }
+
+    /**
+     * @brief get_if returns a pointer to the object named by a UTF-8 name if it has type T, without interning the name.
+     * @param name the name of the key of the object.
+     * @return a pointer to the object, or nullptr if no object has the key or the object is not a T.
+     */
+    template <class T, class Name, typename = typename std::enable_if<paco::IsSlotKeyName_T<Name>::value>::type>
+    T* get_if(const Name& name)
+    {
+        return get_if<T>(paco::SlotKey::find(name));
+    }
+
+
+    /**
+     * @brief visit calls the handler matching the type of every object of the container, in order.
+     * Dispatching is a single table lookup per object, independent of the number of handlers, see PacketVisitor_T.
+     *
+     * Example:
+     *
+     *  container.visit([](QList<int>* list){ ... },
+     *                  [](int value){ ... },
+     *                  [](paco::Packet& other){ ... }); // optional fallback for all other types
+     *
+     * @param handlers lambdas taking one typed parameter, and optionally a fallback taking a paco::Packet&.
+     * @return the number of objects a handler has been called for.
+     */
+    template <class... Fs>
+    int visit(Fs&&... handlers)
+    {
+        paco::PacketVisitor_T<typename std::remove_reference<Fs>::type...> visitor(handlers...);
+        int visited = 0;
+
+        for(std::size_t i = 0; i < mSlots.size(); i++)
+        {
+            paco::Packet* packet = mSlots[i].packet();
+
+            if(visitor.visit(packet->typeId(), packet))
+            {
+                visited++;
+            }
+        }
+
+        return visited;
+    }
 
     /**
      * @brief getSpecification returns a specification of the objects of this container.
+     * The specification is maintained while the container is modified, so this is a plain copy.
      * @return the current specification of the container.
      */
-    Specification getSpecification()
+    Specification getSpecification() const
+    {
+        return mSpecification;
+    }
+
+    /**
+     * @brief specification returns the specification of the objects of this container without copying it.
+     * @return the current specification of the container, valid until the container is modified.
+     */
+    const Specification& specification() const
     {
-        Specification specification;
+        return mSpecification;
+    }
 
-        for(int i = 0; i < mPackets.size(); i++)
+    /**
+     * @brief matches checks if the objects of this container match an expected specification.
+     * Containers with a different specification fingerprint are rejected in O(1),
+     * only on equal fingerprints the packet types are compared element by element.
+     * @param specification the expected specification.
+     * @return true if the container matches the specification.
+     */
+    bool matches(const Specification& specification) const
+    {
+        return mSpecification.equals(specification);
+    }
+
+    /**
+     * @brief matchesKeys checks the keyed objects of this container against an expected specification, ignoring positions.
+     * Every element of the specification that has a description must name an object of this container
+     * with the same packet type. Elements without a description are not checked.
+     * @param specification the expected specification, with the keys as descriptions.
+     * @return true if all keyed elements of the specification are found.
+     */
+    bool matchesKeys(const Specification& specification) const
+    {
+        for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
         {
-            specification.append_friend_class_only(mPackets.at(i)->packetType());
+            const paco::PacketType& expected = specification.mPacketTypes[i];
+            paco::SlotKey key = expected.key();
+
+            if(key.isNull())
+            {
+                continue;
+            }
+
+            int index = mKeys.find(key);
+
+            if(index < 0 || mSpecification.mPacketTypes[index] != expected)
+            {
+                return false;
+            }
         }
 
-        return specification;
+        return true;
+    }
+
+    /**
+     * @brief memoryUsage returns the memory held by this container, with a breakdown per type.
+     * Heap memory owned by the objects is included for types with a paco::dynamicMemoryUsage() overload,
+     * e.g. std::string, QString and std::vector. Objects referenced through pointers are not included.
+     * Available regardless of PACO_INSTRUMENTATION.
+     * @return the memory usage of this container.
+     */
+    paco::MemoryUsage memoryUsage() const
+    {
+        paco::MemoryUsage usage;
+        usage.storage = sizeof(Container)
+                + mSlots.capacity() * sizeof(paco::PacketSlot)
+                + mSpecification.mPacketTypes.capacity() * sizeof(paco::PacketType)
+                + mKeys.memoryUsage()
+                + mTypes.memoryUsage();
+
+        std::map<paco::TypeId, paco::TypeMemoryUsage> types;
+
+        for(std::size_t i = 0; i < mSlots.size(); i++)
+        {
+            const paco::Packet* packet = mSlots[i].packet();
+            paco::TypeMemoryUsage& type = types[packet->typeId()];
+
+            type.id = packet->typeId();
+            type.count++;
+            type.bytes += (mSlots[i].isInline() ? 0 : packet->packetSize()) + packet->dataMemoryUsage();
+        }
+
+        usage.total = usage.storage;
+
+        for(std::map<paco::TypeId, paco::TypeMemoryUsage>::const_iterator it = types.begin(); it != types.end(); ++it)
+        {
+            usage.types.push_back(it->second);
+            usage.total += it->second.bytes;
+        }
+
+        return usage;
     }
 
 private:
 
     /**
-     * @brief mPackets the actual container.
+     * @brief checkKey throws std::invalid_argument if a key cannot name a new object.
+     */
+    void checkKey(const paco::SlotKey& key) const
+    {
+        if(key.isNull())
+        {
+            throw std::invalid_argument("paco::Container: the key of an object must not be empty");
+        }
+
+        if(mKeys.find(key) >= 0)
+        {
+            throw std::invalid_argument("paco::Container: duplicate key " + paco::toStdString(key.name()));
+        }
+    }
+
+    /**
+     * @brief checkedIndexOf returns the index of the object named by a key, throws std::out_of_range if there is none.
+     */
+    int checkedIndexOf(const paco::SlotKey& key) const
+    {
+        int index = mKeys.find(key);
+
+        if(index < 0)
+        {
+            throw std::out_of_range("paco::Container: no object with key " + paco::toStdString(key.name()));
+        }
+
+        return index;
+    }
+
+    /**
+     * @brief checkedIndexOf returns the index of the object named by a UTF-8 name, throws std::out_of_range if there is none.
+     */
+    int checkedIndexOf(std::string_view name) const
+    {
+        int index = mKeys.find(paco::SlotKey::find(name));
+
+        if(index < 0)
+        {
+            throw std::out_of_range("paco::Container: no object with key " + std::string(name));
+        }
+
+        return index;
+    }
+
+private:
+
+    typedef std::vector<paco::PacketSlot, paco::ResourceAllocator_T<paco::PacketSlot> > SlotVector;
+
+    /**
+     * @brief mSlots the actual container.
+     */
+    SlotVector mSlots;
+
+    /**
+     * @brief mSpecification the specification of mSlots, updated on every modification.
+     */
+    Specification mSpecification;
+
+    /**
+     * @brief mKeys the positions of the keyed objects, kept consistent with mSpecification.
+     */
+    paco::SlotKeyIndex mKeys;
+
+    /**
+     * @brief mTypes the positions of the objects per type, kept consistent with mSpecification.
      */
-    std::vector<paco::Packet*> mPackets;
+    paco::TypeIndex mTypes;
 
 };
 
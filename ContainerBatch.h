@@ -0,0 +1,622 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CONTAINER_BATCH_H
+#define CONTAINER_BATCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "Container.h"
+#include "Packet.h"
+#include "PacketType.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The ColumnSpan_T template class is a view on one contiguous column of a ContainerBatch.
+ * Use ColumnSpan_T<const T> for read only access.
+ */
+template <class T>
+class ColumnSpan_T
+{
+public:
+
+    /**
+     * @brief ColumnSpan_T constructor.
+     * @param data the first element.
+     * @param size the number of elements.
+     */
+    ColumnSpan_T(T* data = nullptr, std::size_t size = 0)
+    {
+        mData = data;
+        mSize = size;
+    }
+
+    T* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    T* begin() const { return mData; }
+    T* end() const { return mData + mSize; }
+    T& operator[](std::size_t index) const { return mData[index]; }
+
+private:
+
+    T* mData;
+    std::size_t mSize;
+};
+
+
+/**
+ * @brief The ContainerColumn class is the type erased interface of one column of a ContainerBatch.
+ */
+class ContainerColumn
+{
+public:
+
+    /**
+     * @brief ~ContainerColumn destructor.
+     */
+    virtual ~ContainerColumn()
+    {
+    }
+
+    /**
+     * @brief packetType returns the packet type of the values of this column.
+     * @return the packet type of the values of this column.
+     */
+    virtual paco::PacketType packetType() const = 0;
+
+    /**
+     * @brief append appends the value of a packet. The packet must carry the type of this column.
+     * @param packet the packet.
+     * @param move true to move the value out of the packet, false to copy it.
+     */
+    virtual void append(paco::Packet* packet, bool move) = 0;
+
+    /**
+     * @brief size returns the number of values of this column.
+     * @return the number of values.
+     */
+    virtual std::size_t size() const = 0;
+
+    /**
+     * @brief isCopyable checks if the values of this column can be copied.
+     * @return true if append() can copy a value.
+     */
+    virtual bool isCopyable() const = 0;
+
+    /**
+     * @brief isNothrowMovable checks if moving a value into this column cannot throw once reserveNext() succeeded.
+     * @return true if the move constructor of the values is noexcept.
+     */
+    virtual bool isNothrowMovable() const = 0;
+
+    /**
+     * @brief reserveNext makes sure the next append() does not allocate, growing the storage geometrically.
+     */
+    virtual void reserveNext() = 0;
+
+    /**
+     * @brief appendTo copies the value of a row to the end of a container.
+     * @param container the destination container.
+     * @param row the row.
+     */
+    virtual void appendTo(paco::Container& container, std::size_t row) const = 0;
+
+    /**
+     * @brief removeAt removes the value of a row.
+     * @param row the row.
+     */
+    virtual void removeAt(std::size_t row) = 0;
+
+    /**
+     * @brief removeLast removes the value of the last row.
+     */
+    virtual void removeLast() = 0;
+
+    /**
+     * @brief reserve reserves storage for a number of rows.
+     * @param rows the number of rows.
+     */
+    virtual void reserve(std::size_t rows) = 0;
+
+    /**
+     * @brief clear removes all values.
+     */
+    virtual void clear() = 0;
+};
+
+
+/**
+ * @brief The ContainerColumn_T template class is a column storing values of type T in one contiguous array.
+ */
+template <class T>
+class ContainerColumn_T : public ContainerColumn
+{
+private:
+
+    /**
+     * @brief The Bool struct stores a bool, because std::vector<bool> is not contiguous.
+     */
+    struct Bool
+    {
+        Bool(bool v = false) : value(v) {}
+        bool value;
+    };
+
+    typedef typename std::conditional<std::is_same<T, bool>::value, Bool, T>::type Stored;
+
+public:
+
+    /**
+     * @brief ContainerColumn_T constructor.
+     * @param packetType the packet type of the column, including its description.
+     */
+    explicit ContainerColumn_T(const paco::PacketType& packetType)
+        : mPacketType(packetType)
+    {
+    }
+
+    /**
+     * @brief values returns the values of the column.
+     * @return a span over all values of the column.
+     */
+    paco::ColumnSpan_T<T> values()
+    {
+        return paco::ColumnSpan_T<T>(reinterpret_cast<T*>(mValues.data()), mValues.size());
+    }
+
+    /**
+     * @brief values returns the values of the column.
+     * @return a read only span over all values of the column.
+     */
+    paco::ColumnSpan_T<const T> values() const
+    {
+        return paco::ColumnSpan_T<const T>(reinterpret_cast<const T*>(mValues.data()), mValues.size());
+    }
+
+    virtual paco::PacketType packetType() const
+    {
+        return mPacketType;
+    }
+
+    virtual void append(paco::Packet* packet, bool move)
+    {
+        T& value = static_cast<paco::Packet_T<T>*>(packet)->dataRef();
+
+        if(move)
+        {
+            mValues.emplace_back(std::move(value));
+        }
+        else
+        {
+            copy(std::integral_constant<bool, std::is_copy_constructible<T>::value>(), value);
+        }
+    }
+
+    virtual std::size_t size() const
+    {
+        return mValues.size();
+    }
+
+    virtual bool isCopyable() const
+    {
+        return std::is_copy_constructible<T>::value;
+    }
+
+    virtual bool isNothrowMovable() const
+    {
+        return std::is_nothrow_move_constructible<Stored>::value;
+    }
+
+    virtual void reserveNext()
+    {
+        if(mValues.size() == mValues.capacity())
+        {
+            mValues.reserve(std::max<std::size_t>(8, 2 * mValues.capacity()));
+        }
+    }
+
+    virtual void appendTo(paco::Container& container, std::size_t row) const
+    {
+        copyTo(std::integral_constant<bool, std::is_copy_constructible<T>::value>(), container, row);
+    }
+
+    virtual void removeAt(std::size_t row)
+    {
+        mValues.erase(mValues.begin() + row);
+    }
+
+    virtual void removeLast()
+    {
+        mValues.pop_back();
+    }
+
+    virtual void reserve(std::size_t rows)
+    {
+        mValues.reserve(rows);
+    }
+
+    virtual void clear()
+    {
+        mValues.clear();
+    }
+
+private:
+
+    /**
+     * @brief copy appends a copy of a value.
+     */
+    void copy(std::true_type, const T& value)
+    {
+        mValues.emplace_back(value);
+    }
+
+    /**
+     * @brief copy fails for types that cannot be copied.
+     */
+    void copy(std::false_type, const T&)
+    {
+        throw std::runtime_error("paco::ContainerBatch: type cannot be copied, append the container as rvalue");
+    }
+
+    /**
+     * @brief copyTo appends a copy of the value of a row to a container.
+     */
+    void copyTo(std::true_type, paco::Container& container, std::size_t row) const
+    {
+        container.append<T>(reinterpret_cast<const T&>(mValues[row]));
+    }
+
+    /**
+     * @brief copyTo fails for types that cannot be copied.
+     */
+    void copyTo(std::false_type, paco::Container&, std::size_t) const
+    {
+        throw std::runtime_error("paco::ContainerBatch: type cannot be copied into a container");
+    }
+
+private:
+
+    /**
+     * @brief mPacketType the packet type of the column.
+     */
+    paco::PacketType mPacketType;
+
+    /**
+     * @brief mValues the values of the column, one per row.
+     */
+    std::vector<Stored> mValues;
+};
+
+
+/**
+ * @brief The ContainerBatch class stores many records with the same specification as columns (struct of arrays).
+ *
+ * Every element of the specification is a column, and the values of a column are stored in one contiguous array.
+ * A loop over column<T>(i) therefore reads plain memory without any pointer chasing or type checks,
+ * and can be vectorized by the compiler:
+ *
+ *  paco::ContainerBatch batch = paco::ContainerBatch::create<int, double>();
+ *  batch.append(std::move(container)); // one specification check per record
+ *  ...
+ *  double sum = 0;
+ *  for(double value : batch.column<double>(1)) sum += value;
+ *
+ * The columns are defined with addColumn<T>() or create<Ts...>() before the first record is added.
+ * Records are added from containers with append() and converted back with container().
+ */
+class ContainerBatch
+{
+public:
+
+    /**
+     * @brief ContainerBatch default constructor, creates a batch without columns.
+     */
+    ContainerBatch()
+        : mRows(0)
+    {
+    }
+
+    /**
+     * @brief ContainerBatch move constructor.
+     * @param other the batch to move from.
+     */
+    ContainerBatch(ContainerBatch&& other) = default;
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the batch to move from.
+     * @return this batch.
+     */
+    ContainerBatch& operator=(ContainerBatch&& other) = default;
+
+    /**
+     * @brief create creates a batch with one column per type.
+     * @return the new batch.
+     */
+    template <class... Ts>
+    static ContainerBatch create()
+    {
+        ContainerBatch batch;
+
+        int expand[] = {0, (batch.addColumn<Ts>(), 0)...};
+        (void)expand;
+
+        return batch;
+    }
+
+    /**
+     * @brief addColumn<T> adds a column for objects of type T. Columns can only be added to an empty batch.
+     * @param description the description of the column.
+     */
+    template <class T>
+    void addColumn(paco::String description = "")
+    {
+        if(mRows > 0)
+        {
+            throw std::logic_error("paco::ContainerBatch: columns can only be added to an empty batch");
+        }
+
+        paco::PacketType_T<T> packetType(description);
+        mColumns.push_back(std::unique_ptr<paco::ContainerColumn>(new paco::ContainerColumn_T<T>(packetType)));
+        mSpecification.append<T>(description);
+    }
+
+    /**
+     * @brief rows returns the number of records.
+     * @return the number of records.
+     */
+    std::size_t rows() const
+    {
+        return mRows;
+    }
+
+    /**
+     * @brief columns returns the number of columns, the size of the specification.
+     * @return the number of columns.
+     */
+    int columns() const
+    {
+        return mColumns.size();
+    }
+
+    /**
+     * @brief specification returns the specification of the records.
+     * @return the specification of the records.
+     */
+    const paco::Specification& specification() const
+    {
+        return mSpecification;
+    }
+
+    /**
+     * @brief append copies the objects of a container into a new record.
+     * @param container the container, it must match the specification of the batch.
+     */
+    void append(const paco::Container& container)
+    {
+        appendRecord(const_cast<paco::Container&>(container), false);
+    }
+
+    /**
+     * @brief append moves the objects of a container into a new record.
+     * Objects whose move constructor may throw are copied, so the container is unchanged if the append fails.
+     * @param container the container, it must match the specification of the batch. Its objects are moved from.
+     */
+    void append(paco::Container&& container)
+    {
+        appendRecord(container, true);
+    }
+
+    /**
+     * @brief container copies a record into a new container.
+     * @param row the index of the record.
+     * @return the new container.
+     */
+    paco::Container container(std::size_t row) const
+    {
+        if(row >= mRows)
+        {
+            throw std::out_of_range("paco::ContainerBatch: row out of range");
+        }
+
+        paco::Container container;
+
+        for(std::size_t i = 0; i < mColumns.size(); i++)
+        {
+            mColumns[i]->appendTo(container, row);
+        }
+
+        return container;
+    }
+
+    /**
+     * @brief column<T> returns the values of a column.
+     * @param index the index of the column.
+     * @return a span over the values of all records. If T does not match the column then a std::bad_cast is thrown.
+     */
+    template <class T>
+    paco::ColumnSpan_T<T> column(int index)
+    {
+        return typedColumn<T>(index)->values();
+    }
+
+    /**
+     * @brief column<T> returns the values of a column.
+     * @param index the index of the column.
+     * @return a read only span over the values of all records. If T does not match the column then a std::bad_cast is thrown.
+     */
+    template <class T>
+    paco::ColumnSpan_T<const T> column(int index) const
+    {
+        const paco::ContainerColumn_T<T>* column = typedColumn<T>(index);
+        return column->values();
+    }
+
+    /**
+     * @brief removeAt removes a record.
+     * @param row the index of the record.
+     */
+    void removeAt(std::size_t row)
+    {
+        if(row < mRows)
+        {
+            for(std::size_t i = 0; i < mColumns.size(); i++)
+            {
+                mColumns[i]->removeAt(row);
+            }
+
+            mRows--;
+        }
+    }
+
+    /**
+     * @brief reserve reserves storage for a number of records in every column.
+     * @param rows the number of records.
+     */
+    void reserve(std::size_t rows)
+    {
+        for(std::size_t i = 0; i < mColumns.size(); i++)
+        {
+            mColumns[i]->reserve(rows);
+        }
+    }
+
+    /**
+     * @brief clear removes all records, the columns are kept.
+     */
+    void clear()
+    {
+        for(std::size_t i = 0; i < mColumns.size(); i++)
+        {
+            mColumns[i]->clear();
+        }
+
+        mRows = 0;
+    }
+
+private:
+
+    /**
+     * @brief appendRecord appends the objects of a container to the columns with the strong guarantee:
+     * if anything throws, the batch and the container are unchanged.
+     *
+     * Non-copyable columns are rejected and every column reserves its next value before any value is appended.
+     * The copied values are appended first, with a rollback if a copy throws, and the moved values last, when
+     * nothing can throw anymore. Like std::move_if_noexcept, a value whose move may throw is copied instead;
+     * only a value that can neither be copied nor moved without throwing weakens this to the basic guarantee.
+     */
+    void appendRecord(paco::Container& container, bool move)
+    {
+        if(!container.matches(mSpecification))
+        {
+            throw std::bad_cast();
+        }
+
+        for(std::size_t i = 0; i < mColumns.size(); i++)
+        {
+            if(!movesValue(i, move) && !mColumns[i]->isCopyable())
+            {
+                throw std::runtime_error("paco::ContainerBatch: type cannot be copied, append the container as rvalue");
+            }
+        }
+
+        for(std::size_t i = 0; i < mColumns.size(); i++)
+        {
+            mColumns[i]->reserveNext();
+        }
+
+        try
+        {
+            for(std::size_t i = 0; i < mColumns.size(); i++)
+            {
+                if(!movesValue(i, move))
+                {
+                    mColumns[i]->append(container.at(i), false);
+                }
+            }
+
+            for(std::size_t i = 0; i < mColumns.size(); i++)
+            {
+                if(movesValue(i, move))
+                {
+                    mColumns[i]->append(container.at(i), true);
+                }
+            }
+        }
+        catch(...)
+        {
+            for(std::size_t i = 0; i < mColumns.size(); i++)
+            {
+                if(mColumns[i]->size() > mRows)
+                {
+                    mColumns[i]->removeLast();
+                }
+            }
+
+            throw;
+        }
+
+        mRows++;
+    }
+
+    /**
+     * @brief movesValue checks if appendRecord() moves the value of a column instead of copying it.
+     */
+    bool movesValue(std::size_t column, bool move) const
+    {
+        return move && (mColumns[column]->isNothrowMovable() || !mColumns[column]->isCopyable());
+    }
+
+    /**
+     * @brief typedColumn returns a column with a checked type, out_of_range is thrown for invalid indices.
+     */
+    template <class T>
+    paco::ContainerColumn_T<T>* typedColumn(int index) const
+    {
+        if(!mSpecification.at(index).equals<T>())
+        {
+            throw std::bad_cast();
+        }
+
+        return static_cast<paco::ContainerColumn_T<T>*>(mColumns[index].get());
+    }
+
+private:
+
+    /**
+     * @brief mColumns the columns, one per element of the specification.
+     */
+    std::vector<std::unique_ptr<paco::ContainerColumn> > mColumns;
+
+    /**
+     * @brief mSpecification the specification of every record.
+     */
+    paco::Specification mSpecification;
+
+    /**
+     * @brief mRows the number of records.
+     */
+    std::size_t mRows;
+};
+
+}
+
+#endif // CONTAINER_BATCH_H
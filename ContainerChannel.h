@@ -0,0 +1,613 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CONTAINER_CHANNEL_H
+#define CONTAINER_CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "Container.h"
+
+namespace paco
+{
+
+/**
+ * @brief CacheLineSize is used to keep atomics written by different threads on different cache lines.
+ */
+static const std::size_t CacheLineSize = 64;
+
+
+/**
+ * @brief The SpscRing_T template class is a bounded lock-free ring buffer for a single producer and a single consumer.
+ * Each side caches the position of the other side and only reloads it when the ring looks full or empty,
+ * and a batch is published with a single store.
+ */
+template <class T>
+class SpscRing_T
+{
+public:
+
+    /**
+     * @brief SpscRing_T constructor.
+     * @param capacity the minimum capacity, rounded up to a power of two.
+     */
+    explicit SpscRing_T(std::size_t capacity)
+        : mHead(0), mTail(0)
+    {
+        mCapacity = 1;
+        while(mCapacity < capacity)
+        {
+            mCapacity <<= 1;
+        }
+
+        mMask = mCapacity - 1;
+        mBuffer.reset(new T[mCapacity]);
+        mHeadCache = 0;
+        mTailCache = 0;
+    }
+
+    /**
+     * @brief tryPush pushes up to count items, only called by the producer.
+     * @return the number of pushed items.
+     */
+    std::size_t tryPush(const T* items, std::size_t count)
+    {
+        std::size_t tail = mTail.load(std::memory_order_relaxed);
+
+        if(mCapacity - (tail - mHeadCache) < count)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+        }
+
+        std::size_t pushed = std::min(count, mCapacity - (tail - mHeadCache));
+
+        for(std::size_t i = 0; i < pushed; i++)
+        {
+            mBuffer[(tail + i) & mMask] = items[i];
+        }
+
+        mTail.store(tail + pushed, std::memory_order_release);
+
+        return pushed;
+    }
+
+    /**
+     * @brief tryPop pops up to count items, only called by the consumer.
+     * @return the number of popped items.
+     */
+    std::size_t tryPop(T* items, std::size_t count)
+    {
+        std::size_t head = mHead.load(std::memory_order_relaxed);
+
+        if(mTailCache - head < count)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+        }
+
+        std::size_t popped = std::min(count, mTailCache - head);
+
+        for(std::size_t i = 0; i < popped; i++)
+        {
+            items[i] = mBuffer[(head + i) & mMask];
+        }
+
+        mHead.store(head + popped, std::memory_order_release);
+
+        return popped;
+    }
+
+    /**
+     * @brief capacity returns the capacity of the ring.
+     * @return the capacity of the ring.
+     */
+    std::size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    /**
+     * @brief size returns the approximate number of items in the ring.
+     * @return the approximate number of items in the ring.
+     */
+    std::size_t size() const
+    {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+private:
+
+    std::unique_ptr<T[]> mBuffer;
+    std::size_t mCapacity;
+    std::size_t mMask;
+
+    /**
+     * @brief mHead the consumer position and the consumer's cache of the producer position.
+     */
+    alignas(CacheLineSize) std::atomic<std::size_t> mHead;
+    std::size_t mTailCache;
+
+    /**
+     * @brief mTail the producer position and the producer's cache of the consumer position.
+     */
+    alignas(CacheLineSize) std::atomic<std::size_t> mTail;
+    std::size_t mHeadCache;
+};
+
+
+/**
+ * @brief The MpmcRing_T template class is a bounded lock-free ring buffer for many producers and many consumers.
+ * Every cell carries a sequence number that tells producers and consumers whose turn it is (Vyukov's bounded queue),
+ * so a push or pop is a single compare and swap on the uncontended path.
+ */
+template <class T>
+class MpmcRing_T
+{
+public:
+
+    /**
+     * @brief MpmcRing_T constructor.
+     * @param capacity the minimum capacity, rounded up to a power of two.
+     */
+    explicit MpmcRing_T(std::size_t capacity)
+        : mEnqueuePosition(0), mDequeuePosition(0)
+    {
+        mCapacity = 2;
+        while(mCapacity < capacity)
+        {
+            mCapacity <<= 1;
+        }
+
+        mMask = mCapacity - 1;
+        mCells.reset(new Cell[mCapacity]);
+
+        for(std::size_t i = 0; i < mCapacity; i++)
+        {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief tryPush pushes up to count items.
+     * @return the number of pushed items.
+     */
+    std::size_t tryPush(const T* items, std::size_t count)
+    {
+        std::size_t pushed = 0;
+
+        while(pushed < count && tryPushOne(items[pushed]))
+        {
+            pushed++;
+        }
+
+        return pushed;
+    }
+
+    /**
+     * @brief tryPop pops up to count items.
+     * @return the number of popped items.
+     */
+    std::size_t tryPop(T* items, std::size_t count)
+    {
+        std::size_t popped = 0;
+
+        while(popped < count && tryPopOne(items[popped]))
+        {
+            popped++;
+        }
+
+        return popped;
+    }
+
+    /**
+     * @brief capacity returns the capacity of the ring.
+     * @return the capacity of the ring.
+     */
+    std::size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    /**
+     * @brief size returns the approximate number of items in the ring.
+     * @return the approximate number of items in the ring.
+     */
+    std::size_t size() const
+    {
+        std::size_t enqueued = mEnqueuePosition.load(std::memory_order_acquire);
+        std::size_t dequeued = mDequeuePosition.load(std::memory_order_acquire);
+
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+
+    /**
+     * @brief tryPushOne pushes a single item.
+     */
+    bool tryPushOne(const T& item)
+    {
+        std::size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        for(;;)
+        {
+            cell = &mCells[position & mMask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t difference = (std::intptr_t)sequence - (std::intptr_t)position;
+
+            if(difference == 0)
+            {
+                if(mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief tryPopOne pops a single item.
+     */
+    bool tryPopOne(T& item)
+    {
+        std::size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        for(;;)
+        {
+            cell = &mCells[position & mMask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t difference = (std::intptr_t)sequence - (std::intptr_t)(position + 1);
+
+            if(difference == 0)
+            {
+                if(mDequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = mDequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = cell->data;
+        cell->sequence.store(position + mMask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief The Cell struct is one slot of the ring.
+     */
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    std::size_t mCapacity;
+    std::size_t mMask;
+
+    alignas(CacheLineSize) std::atomic<std::size_t> mEnqueuePosition;
+    alignas(CacheLineSize) std::atomic<std::size_t> mDequeuePosition;
+};
+
+
+/**
+ * @brief The ContainerChannel_T template class hands containers from one pipeline stage to the next.
+ *
+ * The channel is a bounded lock-free ring of Container pointers, either SpscRing_T for one producer and one consumer
+ * or MpmcRing_T for many of each, see SpscContainerChannel and MpmcContainerChannel. It offers non-blocking try*
+ * and blocking variants of push and pop, for single containers and for batches. Blocking calls spin briefly and then
+ * yield the thread until the operation succeeds or the channel is closed.
+ *
+ * Containers are owned by the channel while they are queued. To avoid allocations in steady state a producer
+ * takes a container with acquire(), fills and pushes it, and the consumer hands it back with recycle() after
+ * processing. Recycled containers are cleared and kept in a free list for the next acquire().
+ */
+template <class Ring>
+class ContainerChannel_T
+{
+public:
+
+    /**
+     * @brief ContainerChannel_T constructor.
+     * @param capacity the minimum number of queued containers, rounded up to a power of two.
+     * @param poolCapacity the number of recycled containers kept for reuse, 0 for the same as capacity.
+     */
+    explicit ContainerChannel_T(std::size_t capacity, std::size_t poolCapacity = 0)
+        : mRing(capacity), mPool(poolCapacity > 0 ? poolCapacity : capacity), mClosed(false)
+    {
+    }
+
+    /**
+     * @brief ~ContainerChannel_T destructor, deletes all queued and recycled containers.
+     */
+    ~ContainerChannel_T()
+    {
+        paco::Container* container = nullptr;
+
+        while(mRing.tryPop(&container, 1) == 1)
+        {
+            delete container;
+        }
+
+        while(mPool.tryPop(&container, 1) == 1)
+        {
+            delete container;
+        }
+    }
+
+    ContainerChannel_T(const ContainerChannel_T&) = delete;
+    ContainerChannel_T& operator=(const ContainerChannel_T&) = delete;
+
+    /**
+     * @brief acquire returns an empty container, recycled if possible.
+     * @return an empty container owned by the caller.
+     */
+    paco::Container* acquire()
+    {
+        paco::Container* container = nullptr;
+
+        if(mPool.tryPop(&container, 1) == 1)
+        {
+            return container;
+        }
+
+        return new paco::Container();
+    }
+
+    /**
+     * @brief recycle clears a container and keeps it for the next acquire(). Deletes it if the free list is full.
+     * @param container a container owned by the caller.
+     */
+    void recycle(paco::Container* container)
+    {
+        container->clear();
+
+        if(mPool.tryPush(&container, 1) == 0)
+        {
+            delete container;
+        }
+    }
+
+    /**
+     * @brief tryPush pushes a container if there is space.
+     * @param container the container, owned by the channel on success.
+     * @return true if the container has been pushed.
+     */
+    bool tryPush(paco::Container* container)
+    {
+        return !isClosed() && mRing.tryPush(&container, 1) == 1;
+    }
+
+    /**
+     * @brief push pushes a container and waits for space.
+     * @param container the container, owned by the channel on success.
+     * @return true if the container has been pushed, false if the channel has been closed.
+     */
+    bool push(paco::Container* container)
+    {
+        return pushBatch(&container, 1) == 1;
+    }
+
+    /**
+     * @brief tryPushBatch pushes as many containers of a batch as there is space for.
+     * @param containers the containers, the pushed ones are owned by the channel.
+     * @param count the number of containers.
+     * @return the number of pushed containers, always a prefix of the batch.
+     */
+    std::size_t tryPushBatch(paco::Container* const* containers, std::size_t count)
+    {
+        if(isClosed())
+        {
+            return 0;
+        }
+
+        return mRing.tryPush(containers, count);
+    }
+
+    /**
+     * @brief pushBatch pushes all containers of a batch and waits for space.
+     * @param containers the containers, the pushed ones are owned by the channel.
+     * @param count the number of containers.
+     * @return the number of pushed containers, less than count only if the channel has been closed.
+     */
+    std::size_t pushBatch(paco::Container* const* containers, std::size_t count)
+    {
+        std::size_t pushed = 0;
+        int spins = 0;
+
+        while(pushed < count && !isClosed())
+        {
+            std::size_t n = mRing.tryPush(containers + pushed, count - pushed);
+            pushed += n;
+
+            if(n == 0)
+            {
+                backoff(spins);
+            }
+            else
+            {
+                spins = 0;
+            }
+        }
+
+        return pushed;
+    }
+
+    /**
+     * @brief tryPop pops a container if there is one.
+     * @param container receives the container, owned by the caller.
+     * @return true if a container has been popped.
+     */
+    bool tryPop(paco::Container*& container)
+    {
+        return mRing.tryPop(&container, 1) == 1;
+    }
+
+    /**
+     * @brief pop pops a container and waits for one.
+     * @param container receives the container, owned by the caller.
+     * @return true if a container has been popped, false if the channel has been closed and is empty.
+     */
+    bool pop(paco::Container*& container)
+    {
+        return popBatch(&container, 1) == 1;
+    }
+
+    /**
+     * @brief tryPopBatch pops up to count containers.
+     * @param containers receives the containers, owned by the caller.
+     * @param count the maximum number of containers.
+     * @return the number of popped containers.
+     */
+    std::size_t tryPopBatch(paco::Container** containers, std::size_t count)
+    {
+        return mRing.tryPop(containers, count);
+    }
+
+    /**
+     * @brief popBatch pops up to count containers and waits until there is at least one.
+     * @param containers receives the containers, owned by the caller.
+     * @param count the maximum number of containers.
+     * @return the number of popped containers, 0 only if the channel has been closed and is empty.
+     */
+    std::size_t popBatch(paco::Container** containers, std::size_t count)
+    {
+        int spins = 0;
+
+        for(;;)
+        {
+            std::size_t popped = mRing.tryPop(containers, count);
+
+            if(popped > 0)
+            {
+                return popped;
+            }
+
+            if(isClosed())
+            {
+                // a push may have completed right before closing
+                return mRing.tryPop(containers, count);
+            }
+
+            backoff(spins);
+        }
+    }
+
+    /**
+     * @brief close closes the channel. Pushing fails afterwards, popping drains the remaining containers.
+     */
+    void close()
+    {
+        mClosed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief isClosed checks if the channel has been closed.
+     * @return true if the channel has been closed.
+     */
+    bool isClosed() const
+    {
+        return mClosed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief size returns the approximate number of queued containers.
+     * @return the approximate number of queued containers.
+     */
+    std::size_t size() const
+    {
+        return mRing.size();
+    }
+
+    /**
+     * @brief capacity returns the maximum number of queued containers.
+     * @return the maximum number of queued containers.
+     */
+    std::size_t capacity() const
+    {
+        return mRing.capacity();
+    }
+
+private:
+
+    /**
+     * @brief backoff spins for the first attempts and yields the thread afterwards.
+     */
+    static void backoff(int& spins)
+    {
+        if(spins < 64)
+        {
+            spins++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+
+    /**
+     * @brief mRing the queued containers.
+     */
+    Ring mRing;
+
+    /**
+     * @brief mPool the recycled containers, shared by producers and consumers.
+     */
+    paco::MpmcRing_T<paco::Container*> mPool;
+
+    /**
+     * @brief mClosed true after close().
+     */
+    std::atomic<bool> mClosed;
+};
+
+/**
+ * @brief SpscContainerChannel is a channel for exactly one producer and one consumer thread.
+ */
+typedef ContainerChannel_T<paco::SpscRing_T<paco::Container*> > SpscContainerChannel;
+
+/**
+ * @brief MpmcContainerChannel is a channel for any number of producer and consumer threads.
+ */
+typedef ContainerChannel_T<paco::MpmcRing_T<paco::Container*> > MpmcContainerChannel;
+
+}
+
+#endif // CONTAINER_CHANNEL_H
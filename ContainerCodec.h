@@ -0,0 +1,936 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CONTAINER_CODEC_H
+#define CONTAINER_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef PACO_NO_QT
+    #include <QByteArray>
+    #include <QString>
+#endif
+
+#include "Container.h"
+#include "Packet.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The PacketWriter class collects the encoded bytes of a container as a list of spans (scatter-gather output).
+ * Small writes are copied into an internal buffer, large payloads are only referenced, so they are never
+ * copied into an intermediate buffer. The spans can be passed to writev() or copied into one buffer with copyTo().
+ *
+ * Referenced payloads must stay alive and unmodified until the output has been consumed.
+ *
+ * A writer constructed with a destination buffer instead writes everything, referenced payloads included, straight
+ * into that buffer, and a writer with a null destination only counts the bytes. Together they encode a container
+ * in place with a single copy of each payload: measure it first, then encode into the reserved space.
+ */
+class PacketWriter
+{
+public:
+
+    /**
+     * @brief The Span struct is one contiguous piece of the output, similar to struct iovec.
+     */
+    struct Span
+    {
+        const char* data;
+        std::size_t size;
+    };
+
+    /**
+     * @brief ReferenceThreshold payloads of at least this size are referenced instead of copied.
+     */
+    static const std::size_t ReferenceThreshold = 256;
+
+    /**
+     * @brief PacketWriter default constructor.
+     */
+    PacketWriter()
+        : mDestination(nullptr), mCapacity(0), mDirect(false), mSize(0)
+    {
+    }
+
+    /**
+     * @brief PacketWriter constructor, writes straight into a buffer.
+     * Writes past the capacity throw std::length_error.
+     * @param destination the buffer, or nullptr to only count the bytes.
+     * @param capacity the size of the buffer in bytes, ignored if destination is nullptr.
+     */
+    PacketWriter(char* destination, std::size_t capacity)
+        : mDestination(destination), mCapacity(capacity), mDirect(true), mSize(0)
+    {
+    }
+
+    /**
+     * @brief write copies bytes into the output.
+     * @param data the bytes.
+     * @param size the number of bytes.
+     */
+    void write(const void* data, std::size_t size)
+    {
+        if(size == 0)
+        {
+            return;
+        }
+
+        if(mDirect)
+        {
+            if(mDestination != nullptr)
+            {
+                std::memcpy(directSpace(size), data, size);
+            }
+
+            mSize += size;
+            return;
+        }
+
+        std::size_t offset = mScratch.size();
+        mScratch.append((const char*)data, size);
+
+        if(!mSegments.empty() && mSegments.back().external == nullptr
+                && mSegments.back().offset + mSegments.back().size == offset)
+        {
+            mSegments.back().size += size;
+        }
+        else
+        {
+            Segment segment = { nullptr, offset, size };
+            mSegments.push_back(segment);
+        }
+
+        mSize += size;
+    }
+
+    /**
+     * @brief reference adds bytes to the output without copying them, small payloads are copied anyway.
+     * @param data the bytes, they have to stay alive until the output has been consumed.
+     * @param size the number of bytes.
+     */
+    void reference(const void* data, std::size_t size)
+    {
+        if(size < ReferenceThreshold || mDirect)
+        {
+            write(data, size);
+            return;
+        }
+
+        Segment segment = { (const char*)data, 0, size };
+        mSegments.push_back(segment);
+        mSize += size;
+    }
+
+    /**
+     * @brief writeValue copies a trivially copyable value into the output.
+     * @param value the value.
+     */
+    template <class T>
+    void writeValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "writeValue requires a trivially copyable type");
+        write(&value, sizeof(T));
+    }
+
+    /**
+     * @brief pad writes zero bytes until the output size is a multiple of alignment.
+     * @param alignment the alignment in bytes.
+     */
+    void pad(std::size_t alignment)
+    {
+        static const char zeros[16] = { 0 };
+
+        std::size_t padding = (alignment - mSize % alignment) % alignment;
+        while(padding > 0)
+        {
+            std::size_t chunk = padding < sizeof(zeros) ? padding : sizeof(zeros);
+            write(zeros, chunk);
+            padding -= chunk;
+        }
+    }
+
+    /**
+     * @brief reserve writes size zero bytes that can be overwritten later with patch().
+     * @param size the number of bytes.
+     * @return the handle to pass to patch().
+     */
+    std::size_t reserve(std::size_t size)
+    {
+        if(mDirect)
+        {
+            std::size_t offset = mSize;
+
+            if(mDestination != nullptr)
+            {
+                std::memset(directSpace(size), 0, size);
+            }
+
+            mSize += size;
+
+            return offset;
+        }
+
+        std::size_t offset = mScratch.size();
+        std::string zeros(size, '\0');
+        write(zeros.data(), size);
+
+        return offset;
+    }
+
+    /**
+     * @brief patch overwrites bytes previously reserved with reserve().
+     * @param handle the handle returned by reserve().
+     * @param data the bytes.
+     * @param size the number of bytes.
+     */
+    void patch(std::size_t handle, const void* data, std::size_t size)
+    {
+        if(mDirect)
+        {
+            if(mDestination != nullptr)
+            {
+                std::memcpy(mDestination + handle, data, size);
+            }
+
+            return;
+        }
+
+        std::memcpy(&mScratch[handle], data, size);
+    }
+
+    /**
+     * @brief size returns the total number of bytes written.
+     * @return the total number of bytes written.
+     */
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief spans returns the output as a list of spans, valid until the writer is modified.
+     * @return the output spans.
+     */
+    std::vector<Span> spans() const
+    {
+        std::vector<Span> spans;
+
+        if(mDirect)
+        {
+            Span span = { mDestination, mSize };
+            spans.push_back(span);
+
+            return spans;
+        }
+
+        spans.reserve(mSegments.size());
+
+        for(std::size_t i = 0; i < mSegments.size(); i++)
+        {
+            const Segment& segment = mSegments[i];
+            Span span = { segment.external != nullptr ? segment.external : mScratch.data() + segment.offset, segment.size };
+            spans.push_back(span);
+        }
+
+        return spans;
+    }
+
+    /**
+     * @brief copyTo gathers the output into one buffer.
+     * @param destination a buffer of at least size() bytes.
+     */
+    void copyTo(char* destination) const
+    {
+        if(mDirect)
+        {
+            std::memcpy(destination, mDestination, mSize);
+            return;
+        }
+
+        std::vector<Span> spans = this->spans();
+
+        for(std::size_t i = 0; i < spans.size(); i++)
+        {
+            std::memcpy(destination, spans[i].data, spans[i].size);
+            destination += spans[i].size;
+        }
+    }
+
+    /**
+     * @brief clear removes all output, the internal buffer keeps its capacity.
+     */
+    void clear()
+    {
+        mScratch.clear();
+        mSegments.clear();
+        mSize = 0;
+    }
+
+private:
+
+    /**
+     * @brief directSpace returns where the next size bytes go in the destination, throws if they do not fit.
+     */
+    char* directSpace(std::size_t size)
+    {
+        if(size > mCapacity - mSize)
+        {
+            throw std::length_error("paco::PacketWriter: the output is larger than the destination");
+        }
+
+        return mDestination + mSize;
+    }
+
+    /**
+     * @brief The Segment struct references either the internal buffer (external == nullptr) or external bytes.
+     */
+    struct Segment
+    {
+        const char* external;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    /**
+     * @brief mDestination the buffer of a direct writer, nullptr if it only counts.
+     */
+    char* mDestination;
+
+    /**
+     * @brief mCapacity the size of mDestination.
+     */
+    std::size_t mCapacity;
+
+    /**
+     * @brief mDirect true if the writer writes into mDestination instead of collecting spans.
+     */
+    bool mDirect;
+
+    /**
+     * @brief mScratch the internal buffer for copied bytes.
+     */
+    std::string mScratch;
+
+    /**
+     * @brief mSegments the output in order.
+     */
+    std::vector<Segment> mSegments;
+
+    /**
+     * @brief mSize the total number of bytes.
+     */
+    std::size_t mSize;
+};
+
+
+/**
+ * @brief The PacketReader class reads encoded bytes. All reads are bounds checked and throw std::runtime_error.
+ */
+class PacketReader
+{
+public:
+
+    /**
+     * @brief PacketReader constructor.
+     * @param data the encoded bytes, they have to stay alive while reading.
+     * @param size the number of bytes.
+     */
+    PacketReader(const char* data, std::size_t size)
+    {
+        mData = data;
+        mSize = size;
+        mPosition = 0;
+    }
+
+    /**
+     * @brief read copies bytes out of the input.
+     * @param destination the destination buffer.
+     * @param size the number of bytes.
+     */
+    void read(void* destination, std::size_t size)
+    {
+        std::memcpy(destination, view(size), size);
+    }
+
+    /**
+     * @brief readValue reads a trivially copyable value.
+     * @return the value.
+     */
+    template <class T>
+    T readValue()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "readValue requires a trivially copyable type");
+
+        T value;
+        read(&value, sizeof(T));
+
+        return value;
+    }
+
+    /**
+     * @brief view returns a pointer to the next bytes of the input without copying them and skips them.
+     * @param size the number of bytes.
+     * @return a pointer into the input.
+     */
+    const char* view(std::size_t size)
+    {
+        if(size > mSize - mPosition)
+        {
+            throw std::runtime_error("paco::PacketReader: read beyond the end of the input");
+        }
+
+        const char* data = mData + mPosition;
+        mPosition += size;
+
+        return data;
+    }
+
+    /**
+     * @brief remaining returns the number of unread bytes.
+     * @return the number of unread bytes.
+     */
+    std::size_t remaining() const
+    {
+        return mSize - mPosition;
+    }
+
+private:
+
+    /**
+     * @brief mData the input.
+     */
+    const char* mData;
+
+    /**
+     * @brief mSize the size of the input.
+     */
+    std::size_t mSize;
+
+    /**
+     * @brief mPosition the read position.
+     */
+    std::size_t mPosition;
+};
+
+
+/**
+ * @brief The PacketCodec class encodes and decodes packets of one type. Codecs are registered with the PacketTypeRegistry.
+ */
+class PacketCodec
+{
+public:
+
+    /**
+     * @brief ~PacketCodec destructor.
+     */
+    virtual ~PacketCodec()
+    {
+
+    }
+
+    /**
+     * @brief encode writes the data of a packet.
+     * @param packet the packet, its type matches the type of the codec.
+     * @param writer the output.
+     */
+    virtual void encode(const paco::Packet* packet, paco::PacketWriter& writer) const = 0;
+
+    /**
+     * @brief decode reads one value and appends it to a container.
+     * @param reader the input, limited to the bytes of this value.
+     * @param container the container to append to.
+     */
+    virtual void decode(paco::PacketReader& reader, paco::Container& container) const = 0;
+};
+
+
+/**
+ * @brief The PacketCodec_T template class is a codec built from an encode and a decode function.
+ */
+template <class T>
+class PacketCodec_T : public PacketCodec
+{
+public:
+
+    typedef void (*EncodeFunction)(const T& value, paco::PacketWriter& writer);
+    typedef T (*DecodeFunction)(paco::PacketReader& reader);
+
+    /**
+     * @brief PacketCodec_T constructor.
+     * @param encode the encode function.
+     * @param decode the decode function.
+     */
+    PacketCodec_T(EncodeFunction encode, DecodeFunction decode)
+    {
+        mEncode = encode;
+        mDecode = decode;
+    }
+
+    virtual void encode(const paco::Packet* packet, paco::PacketWriter& writer) const
+    {
+        mEncode(*packet->get_if<T>(), writer);
+    }
+
+    virtual void decode(paco::PacketReader& reader, paco::Container& container) const
+    {
+        container.append<T>(mDecode(reader));
+    }
+
+private:
+
+    EncodeFunction mEncode;
+    DecodeFunction mDecode;
+};
+
+
+/**
+ * @brief encodeFlat writes the bytes of a flat value.
+ */
+template <class T>
+void encodeFlat(const T& value, paco::PacketWriter& writer)
+{
+    writer.reference(&value, sizeof(T));
+}
+
+/**
+ * @brief decodeFlat reads the bytes of a flat value.
+ */
+template <class T>
+T decodeFlat(paco::PacketReader& reader)
+{
+    return reader.readValue<T>();
+}
+
+/**
+ * @brief encodeVector writes a std::vector of flat values, the elements are referenced in bulk.
+ */
+template <class T>
+void encodeVector(const std::vector<T>& value, paco::PacketWriter& writer)
+{
+    writer.writeValue<std::uint64_t>(value.size());
+    writer.reference(value.data(), value.size() * sizeof(T));
+}
+
+/**
+ * @brief decodeVector reads a std::vector of flat values.
+ */
+template <class T>
+std::vector<T> decodeVector(paco::PacketReader& reader)
+{
+    std::uint64_t count = reader.readValue<std::uint64_t>();
+
+    if(count > reader.remaining() / sizeof(T))
+    {
+        throw std::runtime_error("paco::decodeVector: element count exceeds the input");
+    }
+
+    std::vector<T> value(count);
+    reader.read(value.data(), count * sizeof(T));
+
+    return value;
+}
+
+/**
+ * @brief encodeString writes a std::string, the characters are referenced in bulk.
+ */
+inline void encodeString(const std::string& value, paco::PacketWriter& writer)
+{
+    writer.writeValue<std::uint64_t>(value.size());
+    writer.reference(value.data(), value.size());
+}
+
+/**
+ * @brief decodeString reads a std::string.
+ */
+inline std::string decodeString(paco::PacketReader& reader)
+{
+    std::uint64_t size = reader.readValue<std::uint64_t>();
+    const char* data = reader.view(size);
+
+    return std::string(data, size);
+}
+
+#ifndef PACO_NO_QT
+/**
+ * @brief encodeQString writes a QString as UTF-8.
+ */
+inline void encodeQString(const QString& value, paco::PacketWriter& writer)
+{
+    QByteArray utf8 = value.toUtf8();
+
+    writer.writeValue<std::uint64_t>(utf8.size());
+    writer.write(utf8.constData(), utf8.size());
+}
+
+/**
+ * @brief decodeQString reads a QString from UTF-8.
+ */
+inline QString decodeQString(paco::PacketReader& reader)
+{
+    std::uint64_t size = reader.readValue<std::uint64_t>();
+    const char* data = reader.view(size);
+
+    return QString::fromUtf8(data, size);
+}
+#endif
+
+
+/**
+ * @brief registerCodec<T> registers encode and decode functions for packets of type T.
+ * Registering a type again replaces its codec.
+ * @param encode the encode function.
+ * @param decode the decode function.
+ */
+template <class T>
+void registerCodec(typename paco::PacketCodec_T<T>::EncodeFunction encode, typename paco::PacketCodec_T<T>::DecodeFunction decode)
+{
+    paco::PacketTypeRegistry::instance().setCodec(paco::PacketTypeRegistry::descriptor<T>(),
+                                                  std::make_shared<paco::PacketCodec_T<T> >(encode, decode));
+}
+
+/**
+ * @brief registerCodec<T> registers the bulk copy codec for a flat type T, i.e. trivially copyable and not a pointer.
+ * Fundamental types, std::string and QString (unless PACO_NO_QT is defined) are registered by the ContainerCodec itself.
+ * Flat types without a registered codec are copied in bulk anyway, so this is only needed to replace another codec.
+ */
+template <class T>
+void registerCodec()
+{
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value,
+                  "registerCodec<T>() without functions requires a flat type, register encode and decode functions instead");
+
+    registerCodec<T>(&paco::encodeFlat<T>, &paco::decodeFlat<T>);
+}
+
+
+/**
+ * @brief The ContainerCodec class writes a container into a compact binary format and reads it back.
+ *
+ * The format is in native byte order and consists of
+ *
+ * - a 32 byte header: magic "PACO", version, element count, specification fingerprint and total size,
+ * - one 24 byte entry per element: the type name hash (PacketTypeDescriptor::hash()), offset and size of the payload,
+ * - the payloads, each aligned to 8 bytes.
+ *
+ * The header holds the specification of the container, so it can be checked without decoding any payload.
+ * Flat types, i.e. trivially copyable and not a pointer, are copied in bulk unless a codec is registered for them.
+ * All other types in the container need a registered codec, see paco::registerCodec<T>().
+ */
+class ContainerCodec
+{
+public:
+
+    /**
+     * @brief The Header struct is the header of an encoded container.
+     */
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t reserved;
+        std::uint32_t count;
+        std::uint32_t entrySize;
+        std::uint64_t fingerprint;
+        std::uint64_t size;
+    };
+
+    /**
+     * @brief The Entry struct describes one encoded element.
+     */
+    struct Entry
+    {
+        std::uint64_t typeHash;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    static const std::uint32_t Magic = 0x4f434150; // "PACO"
+    static const std::uint16_t Version = 1;
+    static const std::size_t Alignment = 8;
+
+    /**
+     * @brief encode writes a container. Large payloads are referenced by the writer, see PacketWriter.
+     * Throws std::runtime_error if the container holds a type that is neither flat nor has a registered codec.
+     * @param container the container.
+     * @param writer the output.
+     */
+    static void encode(const paco::Container& container, paco::PacketWriter& writer)
+    {
+        registerDefaultCodecs();
+
+        writer.pad(Alignment);
+
+        std::size_t start = writer.size();
+        std::size_t count = container.size();
+        std::size_t headerHandle = writer.reserve(sizeof(Header));
+        std::size_t entriesHandle = writer.reserve(count * sizeof(Entry));
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            const paco::Packet* packet = container.at(i);
+            const paco::PacketTypeDescriptor* descriptor = packet->packetType().descriptor();
+            const paco::PacketCodec* codec = descriptor->codec();
+
+            if(codec == nullptr && !descriptor->isFlat())
+            {
+                throw std::runtime_error("paco::ContainerCodec: no codec registered for " + std::string(descriptor->nameView()));
+            }
+
+            writer.pad(Alignment);
+
+            std::size_t offset = writer.size();
+
+            if(codec != nullptr)
+            {
+                codec->encode(packet, writer);
+            }
+            else
+            {
+                writer.reference(packet->rawData(), descriptor->size());
+            }
+
+            Entry entry;
+            entry.typeHash = descriptor->hash();
+            entry.offset = offset - start;
+            entry.size = writer.size() - offset;
+            writer.patch(entriesHandle + i * sizeof(Entry), &entry, sizeof(Entry));
+        }
+
+        writer.pad(Alignment);
+
+        Header header;
+        header.magic = Magic;
+        header.version = Version;
+        header.reserved = 0;
+        header.count = count;
+        header.entrySize = sizeof(Entry);
+        header.fingerprint = container.specification().fingerprint();
+        header.size = writer.size() - start;
+
+        writer.patch(headerHandle, &header, sizeof(Header));
+    }
+
+    /**
+     * @brief encodedSize returns the number of bytes encode() writes for a container into an empty writer.
+     * The codecs run without output, so a container can be measured before it is encoded in place.
+     * Throws like encode().
+     * @param container the container.
+     * @return the size of the encoded container.
+     */
+    static std::size_t encodedSize(const paco::Container& container)
+    {
+        paco::PacketWriter counter(nullptr, 0);
+        encode(container, counter);
+
+        return counter.size();
+    }
+
+    /**
+     * @brief encode writes a container into one contiguous buffer.
+     * @param container the container.
+     * @return the encoded container.
+     */
+    static std::vector<char> encode(const paco::Container& container)
+    {
+        paco::PacketWriter writer;
+        encode(container, writer);
+
+        std::vector<char> bytes(writer.size());
+        writer.copyTo(bytes.data());
+
+        return bytes;
+    }
+
+    /**
+     * @brief header reads and validates the header of an encoded container.
+     * Throws std::runtime_error if the data is not an encoded container.
+     * @param data the encoded container.
+     * @param size the number of available bytes.
+     * @return the header.
+     */
+    static Header header(const char* data, std::size_t size)
+    {
+        paco::PacketReader reader(data, size);
+        Header header = reader.readValue<Header>();
+
+        if(header.magic != Magic || header.version != Version || header.entrySize != sizeof(Entry))
+        {
+            throw std::runtime_error("paco::ContainerCodec: not an encoded container or unsupported version");
+        }
+
+        if(header.size < sizeof(Header) || header.size > size || header.count > (header.size - sizeof(Header)) / sizeof(Entry))
+        {
+            throw std::runtime_error("paco::ContainerCodec: encoded container is truncated");
+        }
+
+        return header;
+    }
+
+    /**
+     * @brief entry returns the entry of one element of an encoded container.
+     * @param data the encoded container, validated with header().
+     * @param index the index of the element.
+     * @return the entry.
+     */
+    static Entry entry(const char* data, std::size_t index)
+    {
+        Entry entry;
+        std::memcpy(&entry, data + sizeof(Header) + index * sizeof(Entry), sizeof(Entry));
+
+        return entry;
+    }
+
+    /**
+     * @brief specification reads the specification of an encoded container without decoding the payloads.
+     * Throws std::runtime_error if a type has never been used in this process.
+     * @param data the encoded container.
+     * @param size the number of available bytes.
+     * @return the specification.
+     */
+    static paco::Specification specification(const char* data, std::size_t size)
+    {
+        Header header = ContainerCodec::header(data, size);
+        paco::Specification specification;
+
+        for(std::size_t i = 0; i < header.count; i++)
+        {
+            specification.append_friend_class_only(paco::PacketType(descriptor(entry(data, i).typeHash)));
+        }
+
+        return specification;
+    }
+
+    /**
+     * @brief decode reads a container.
+     * Throws std::runtime_error if the data is invalid or holds a type that is neither flat nor has a registered codec.
+     * @param data the encoded container.
+     * @param size the number of available bytes, may be more than the encoded container.
+     * @return the decoded container.
+     */
+    static paco::Container decode(const char* data, std::size_t size)
+    {
+        registerDefaultCodecs();
+
+        Header header = ContainerCodec::header(data, size);
+        paco::Container container;
+
+        for(std::size_t i = 0; i < header.count; i++)
+        {
+            Entry entry = ContainerCodec::entry(data, i);
+
+            if(entry.offset > header.size || entry.size > header.size - entry.offset)
+            {
+                throw std::runtime_error("paco::ContainerCodec: payload outside of the encoded container");
+            }
+
+            const paco::PacketTypeDescriptor* descriptor = ContainerCodec::descriptor(entry.typeHash);
+            const paco::PacketCodec* codec = descriptor->codec();
+
+            if(codec == nullptr && !descriptor->isFlat())
+            {
+                throw std::runtime_error("paco::ContainerCodec: no codec registered for " + std::string(descriptor->nameView()));
+            }
+
+            paco::PacketReader reader(data + entry.offset, entry.size);
+
+            if(codec != nullptr)
+            {
+                codec->decode(reader, container);
+            }
+            else
+            {
+                appendFlat(container, descriptor, reader.view(descriptor->size()));
+            }
+        }
+
+        if(container.specification().fingerprint() != header.fingerprint)
+        {
+            throw std::runtime_error("paco::ContainerCodec: decoded specification does not match the header");
+        }
+
+        return container;
+    }
+
+    /**
+     * @brief registerDefaultCodecs registers the codecs of the fundamental types, std::string and QString once.
+     */
+    static void registerDefaultCodecs()
+    {
+        static const bool registered = registerDefaultCodecsOnce();
+        (void)registered;
+    }
+
+private:
+
+    /**
+     * @brief descriptor looks up a type by its name hash.
+     * Throws std::runtime_error if the type has never been used in this process.
+     */
+    static const paco::PacketTypeDescriptor* descriptor(std::uint64_t typeHash)
+    {
+        const paco::PacketTypeDescriptor* descriptor = paco::PacketTypeRegistry::instance().findByHash(typeHash);
+
+        if(descriptor == nullptr)
+        {
+            throw std::runtime_error("paco::ContainerCodec: unknown type hash, the type has not been registered in this process");
+        }
+
+        return descriptor;
+    }
+
+    /**
+     * @brief appendFlat appends a value of a flat type without registered codec, copying its bytes.
+     */
+    static void appendFlat(paco::Container& container, const paco::PacketTypeDescriptor* descriptor, const char* data)
+    {
+        container.mSlots.emplace_back(descriptor, data);
+        container.mSpecification.append_friend_class_only(container.mSlots.back().packet()->packetType());
+        container.mTypes.append(descriptor->id(), container.mSlots.size() - 1, container.mSpecification);
+        paco::Instrumentation::countAppend(descriptor);
+    }
+
+    static bool registerDefaultCodecsOnce()
+    {
+        paco::registerCodec<bool>();
+        paco::registerCodec<char>();
+        paco::registerCodec<signed char>();
+        paco::registerCodec<unsigned char>();
+        paco::registerCodec<short>();
+        paco::registerCodec<unsigned short>();
+        paco::registerCodec<int>();
+        paco::registerCodec<unsigned int>();
+        paco::registerCodec<long>();
+        paco::registerCodec<unsigned long>();
+        paco::registerCodec<long long>();
+        paco::registerCodec<unsigned long long>();
+        paco::registerCodec<float>();
+        paco::registerCodec<double>();
+        paco::registerCodec<std::string>(&paco::encodeString, &paco::decodeString);
+#ifndef PACO_NO_QT
+        paco::registerCodec<QString>(&paco::encodeQString, &paco::decodeQString);
+#endif
+
+        return true;
+    }
+};
+
+}
+
+#endif // CONTAINER_CODEC_H
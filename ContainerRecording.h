@@ -0,0 +1,572 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CONTAINER_RECORDING_H
+#define CONTAINER_RECORDING_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+#ifdef PACO_NO_QT
+    #error "ContainerRecording.h writes through QFile and is not part of the Qt-free core, undefine PACO_NO_QT"
+#endif
+
+#include <QFile>
+#include <QString>
+
+#include "Container.h"
+#include "ContainerCodec.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The ArrayView_T template class is a read only view on a contiguous array of T owned by someone else.
+ */
+template <class T>
+class ArrayView_T
+{
+public:
+
+    /**
+     * @brief ArrayView_T constructor.
+     * @param data the first element.
+     * @param size the number of elements.
+     */
+    ArrayView_T(const T* data = nullptr, std::size_t size = 0)
+    {
+        mData = data;
+        mSize = size;
+    }
+
+    const T* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    const T* begin() const { return mData; }
+    const T* end() const { return mData + mSize; }
+    const T& operator[](std::size_t index) const { return mData[index]; }
+
+private:
+
+    const T* mData;
+    std::size_t mSize;
+};
+
+
+/**
+ * @brief The ContainerRecording class holds the file format shared by ContainerRecordWriter and ContainerRecordReader.
+ *
+ * A recording consists of two append-only files:
+ *
+ * - the data file: a 16 byte file header followed by the containers, each encoded with ContainerCodec at an 8 byte aligned offset,
+ * - the index file "<data file>.index": a 16 byte file header followed by one Entry (offset, size, fingerprint) per container.
+ *
+ * The index is written after the data of a container, so after a crash the index never references incomplete data.
+ */
+class ContainerRecording
+{
+public:
+
+    /**
+     * @brief The FileHeader struct starts both files.
+     */
+    struct FileHeader
+    {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t reserved;
+    };
+
+    /**
+     * @brief The Entry struct is the index entry of one recorded container.
+     */
+    struct Entry
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint64_t fingerprint;
+    };
+
+    static const std::uint64_t DataMagic = 0x314345524f434150ull;  // "PACOREC1"
+    static const std::uint64_t IndexMagic = 0x31584449434f4150ull; // "PACOIDX1"
+    static const std::uint32_t Version = 1;
+
+    /**
+     * @brief indexPath returns the path of the index file of a recording.
+     * @param path the path of the data file.
+     * @return the path of the index file.
+     */
+    static QString indexPath(const QString& path)
+    {
+        return path + ".index";
+    }
+};
+
+
+/**
+ * @brief The ContainerRecordWriter class appends containers to a recording.
+ * Opening an existing recording continues it. A torn last index entry and entries beyond the data, which are left
+ * behind by an interrupted write, are removed from the index first.
+ * Every type in the recorded containers needs a codec or has to be flat, see ContainerCodec.
+ */
+class ContainerRecordWriter
+{
+public:
+
+    /**
+     * @brief ContainerRecordWriter opens or creates a recording.
+     * Throws std::runtime_error if the files cannot be opened or are not a recording.
+     * @param path the path of the data file.
+     */
+    explicit ContainerRecordWriter(const QString& path)
+        : mDataFile(path), mIndexFile(ContainerRecording::indexPath(path))
+    {
+        open(mDataFile, ContainerRecording::DataMagic);
+        open(mIndexFile, ContainerRecording::IndexMagic);
+
+        mDataSize = mDataFile.size();
+        mCount = (mIndexFile.size() - sizeof(ContainerRecording::FileHeader)) / sizeof(ContainerRecording::Entry);
+
+        // drop entries beyond the data like the reader does, and a torn last entry, so new entries stay aligned
+        while(mCount > 0)
+        {
+            ContainerRecording::Entry entry = readEntry(mCount - 1);
+
+            if(entry.offset <= mDataSize && entry.size <= mDataSize - entry.offset)
+            {
+                break;
+            }
+
+            mCount--;
+        }
+
+        qint64 indexSize = sizeof(ContainerRecording::FileHeader) + mCount * sizeof(ContainerRecording::Entry);
+        if(mIndexFile.size() != indexSize && !mIndexFile.resize(indexSize))
+        {
+            throw std::runtime_error("paco::ContainerRecordWriter: cannot truncate the index " + mIndexFile.errorString().toStdString());
+        }
+
+        // continue 8 byte aligned, even if the last write has been interrupted
+        std::size_t padding = (8 - mDataSize % 8) % 8;
+        if(padding > 0)
+        {
+            write(mDataFile, "\0\0\0\0\0\0\0", padding);
+            mDataSize += padding;
+        }
+    }
+
+    /**
+     * @brief append encodes a container and appends it to the recording.
+     * The payloads are written straight from the container without an intermediate copy.
+     * @param container the container.
+     */
+    void append(const paco::Container& container)
+    {
+        mWriter.clear();
+        paco::ContainerCodec::encode(container, mWriter);
+
+        std::vector<paco::PacketWriter::Span> spans = mWriter.spans();
+        for(std::size_t i = 0; i < spans.size(); i++)
+        {
+            write(mDataFile, spans[i].data, spans[i].size);
+        }
+
+        ContainerRecording::Entry entry;
+        entry.offset = mDataSize;
+        entry.size = mWriter.size();
+        entry.fingerprint = container.specification().fingerprint();
+
+        write(mIndexFile, (const char*)&entry, sizeof(entry));
+
+        mDataSize += mWriter.size();
+        mCount++;
+    }
+
+    /**
+     * @brief count returns the number of containers in the recording.
+     * @return the number of containers in the recording.
+     */
+    std::size_t count() const
+    {
+        return mCount;
+    }
+
+    /**
+     * @brief flush flushes both files.
+     */
+    void flush()
+    {
+        mDataFile.flush();
+        mIndexFile.flush();
+    }
+
+private:
+
+    /**
+     * @brief open opens a file for appending, writes the file header into new files and checks it in existing files.
+     */
+    static void open(QFile& file, std::uint64_t magic)
+    {
+        if(!file.open(QIODevice::ReadWrite | QIODevice::Append | QIODevice::Unbuffered))
+        {
+            throw std::runtime_error("paco::ContainerRecordWriter: cannot open " + file.errorString().toStdString());
+        }
+
+        ContainerRecording::FileHeader header;
+
+        if(file.size() == 0)
+        {
+            header.magic = magic;
+            header.version = ContainerRecording::Version;
+            header.reserved = 0;
+
+            write(file, (const char*)&header, sizeof(header));
+        }
+        else if(!read(file, 0, (char*)&header, sizeof(header)) || header.magic != magic || header.version != ContainerRecording::Version)
+        {
+            throw std::runtime_error("paco::ContainerRecordWriter: not a recording or unsupported version");
+        }
+    }
+
+    /**
+     * @brief read reads bytes at a position, writes still go to the end of the file.
+     * @return true if all bytes have been read.
+     */
+    static bool read(QFile& file, qint64 position, char* data, std::size_t size)
+    {
+        return file.seek(position) && file.read(data, size) == (qint64)size;
+    }
+
+    /**
+     * @brief readEntry reads an entry of the index file. Throws std::runtime_error if it cannot be read.
+     */
+    ContainerRecording::Entry readEntry(std::size_t n)
+    {
+        ContainerRecording::Entry entry;
+
+        if(!read(mIndexFile, sizeof(ContainerRecording::FileHeader) + n * sizeof(entry), (char*)&entry, sizeof(entry)))
+        {
+            throw std::runtime_error("paco::ContainerRecordWriter: cannot read the index " + mIndexFile.errorString().toStdString());
+        }
+
+        return entry;
+    }
+
+    /**
+     * @brief write writes all bytes or throws std::runtime_error.
+     */
+    static void write(QFile& file, const char* data, std::size_t size)
+    {
+        if(file.write(data, size) != (qint64)size)
+        {
+            throw std::runtime_error("paco::ContainerRecordWriter: write failed " + file.errorString().toStdString());
+        }
+    }
+
+private:
+
+    /**
+     * @brief mDataFile the data file.
+     */
+    QFile mDataFile;
+
+    /**
+     * @brief mIndexFile the index file.
+     */
+    QFile mIndexFile;
+
+    /**
+     * @brief mDataSize the size of the data file.
+     */
+    std::uint64_t mDataSize;
+
+    /**
+     * @brief mCount the number of recorded containers.
+     */
+    std::size_t mCount;
+
+    /**
+     * @brief mWriter the reused encoder output.
+     */
+    paco::PacketWriter mWriter;
+};
+
+
+/**
+ * @brief The ContainerRecordReader class gives random access to the containers of a recording.
+ * Both files are memory mapped. The index gives the offset and specification fingerprint of the n-th container in O(1),
+ * and flat payloads can be read in place as views into the mapping, without decoding the container.
+ *
+ * The reader sees the containers that were recorded when it was opened. Views are valid as long as the reader exists.
+ */
+class ContainerRecordReader
+{
+public:
+
+    /**
+     * @brief ContainerRecordReader opens and maps a recording. Throws std::runtime_error if it is not a valid recording.
+     * @param path the path of the data file.
+     */
+    explicit ContainerRecordReader(const QString& path)
+        : mDataFile(path), mIndexFile(ContainerRecording::indexPath(path))
+    {
+        mData = map(mDataFile, ContainerRecording::DataMagic, &mDataSize);
+
+        std::uint64_t indexSize;
+        const char* index = map(mIndexFile, ContainerRecording::IndexMagic, &indexSize);
+
+        mEntries = (const ContainerRecording::Entry*)(index + sizeof(ContainerRecording::FileHeader));
+        mCount = (indexSize - sizeof(ContainerRecording::FileHeader)) / sizeof(ContainerRecording::Entry);
+
+        // ignore index entries beyond the data, e.g. if the data file has been truncated
+        while(mCount > 0 && (mEntries[mCount - 1].offset > mDataSize || mEntries[mCount - 1].size > mDataSize - mEntries[mCount - 1].offset))
+        {
+            mCount--;
+        }
+    }
+
+    /**
+     * @brief count returns the number of containers in the recording.
+     * @return the number of containers in the recording.
+     */
+    std::size_t count() const
+    {
+        return mCount;
+    }
+
+    /**
+     * @brief fingerprint returns the specification fingerprint of the n-th container from the index.
+     * @param n the index of the container.
+     * @return the specification fingerprint.
+     */
+    std::uint64_t fingerprint(std::size_t n) const
+    {
+        return entry(n).fingerprint;
+    }
+
+    /**
+     * @brief record returns the encoded n-th container inside the mapping.
+     * @param n the index of the container.
+     * @param size receives the size of the encoded container.
+     * @return a pointer to the encoded container.
+     */
+    const char* record(std::size_t n, std::size_t* size = nullptr) const
+    {
+        const ContainerRecording::Entry& entry = this->entry(n);
+
+        if(size != nullptr)
+        {
+            *size = entry.size;
+        }
+
+        return mData + entry.offset;
+    }
+
+    /**
+     * @brief specification returns the specification of the n-th container without decoding it.
+     * @param n the index of the container.
+     * @return the specification.
+     */
+    paco::Specification specification(std::size_t n) const
+    {
+        std::size_t size;
+        const char* data = record(n, &size);
+
+        return paco::ContainerCodec::specification(data, size);
+    }
+
+    /**
+     * @brief container decodes the n-th container.
+     * @param n the index of the container.
+     * @return the decoded container.
+     */
+    paco::Container container(std::size_t n) const
+    {
+        std::size_t size;
+        const char* data = record(n, &size);
+
+        return paco::ContainerCodec::decode(data, size);
+    }
+
+    /**
+     * @brief flat<T> returns a pointer to a flat element of the n-th container inside the mapping, without any copy.
+     * Throws std::bad_cast if the element is not a T.
+     * @param n the index of the container.
+     * @param element the index of the element in the container.
+     * @return a pointer to the element.
+     */
+    template <class T>
+    const T* flat(std::size_t n, std::size_t element) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value && alignof(T) <= 8,
+                      "flat<T>() requires a flat type with an alignment of at most 8");
+
+        paco::ContainerCodec::Entry payload = this->payload<T>(n, element);
+
+        if(payload.size != sizeof(T))
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: payload size does not match the type");
+        }
+
+        return (const T*)(record(n) + payload.offset);
+    }
+
+    /**
+     * @brief vector<T> returns a view on the elements of a std::vector<T> element of the n-th container inside the mapping.
+     * The vector has to be encoded with paco::encodeVector<T>. Throws std::bad_cast if the element is not a std::vector<T>.
+     * @param n the index of the container.
+     * @param element the index of the element in the container.
+     * @return a view on the vector elements.
+     */
+    template <class T>
+    paco::ArrayView_T<T> vector(std::size_t n, std::size_t element) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value && alignof(T) <= 8,
+                      "vector<T>() requires a flat element type with an alignment of at most 8");
+
+        paco::ContainerCodec::Entry payload = this->payload<std::vector<T> >(n, element);
+        const char* data = record(n) + payload.offset;
+
+        std::uint64_t count;
+        if(payload.size < sizeof(count))
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: payload is too small for a vector");
+        }
+
+        std::memcpy(&count, data, sizeof(count));
+
+        if(count > (payload.size - sizeof(count)) / sizeof(T))
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: vector exceeds its payload");
+        }
+
+        return paco::ArrayView_T<T>((const T*)(data + sizeof(count)), count);
+    }
+
+private:
+
+    /**
+     * @brief entry returns the index entry of the n-th container, throws std::out_of_range for invalid n.
+     */
+    const ContainerRecording::Entry& entry(std::size_t n) const
+    {
+        if(n >= mCount)
+        {
+            throw std::out_of_range("paco::ContainerRecordReader: container index out of range");
+        }
+
+        return mEntries[n];
+    }
+
+    /**
+     * @brief payload returns the codec entry of an element after checking its type.
+     */
+    template <class T>
+    paco::ContainerCodec::Entry payload(std::size_t n, std::size_t element) const
+    {
+        std::size_t size;
+        const char* data = record(n, &size);
+        paco::ContainerCodec::Header header = paco::ContainerCodec::header(data, size);
+
+        if(element >= header.count)
+        {
+            throw std::out_of_range("paco::ContainerRecordReader: element index out of range");
+        }
+
+        paco::ContainerCodec::Entry entry = paco::ContainerCodec::entry(data, element);
+
+        if(entry.typeHash != paco::PacketTypeRegistry::descriptor<T>()->hash())
+        {
+            throw std::bad_cast();
+        }
+
+        if(entry.offset > header.size || entry.size > header.size - entry.offset)
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: payload outside of the encoded container");
+        }
+
+        return entry;
+    }
+
+    /**
+     * @brief map opens and maps a whole file and checks its header.
+     */
+    static const char* map(QFile& file, std::uint64_t magic, std::uint64_t* size)
+    {
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: cannot open " + file.errorString().toStdString());
+        }
+
+        *size = file.size();
+
+        if(*size < sizeof(ContainerRecording::FileHeader))
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: file is not a recording");
+        }
+
+        const char* data = (const char*)file.map(0, *size);
+
+        if(data == nullptr)
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: cannot map " + file.errorString().toStdString());
+        }
+
+        ContainerRecording::FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if(header.magic != magic || header.version != ContainerRecording::Version)
+        {
+            throw std::runtime_error("paco::ContainerRecordReader: file is not a recording or has an unsupported version");
+        }
+
+        return data;
+    }
+
+private:
+
+    /**
+     * @brief mDataFile the data file, mapped while the reader exists.
+     */
+    QFile mDataFile;
+
+    /**
+     * @brief mIndexFile the index file, mapped while the reader exists.
+     */
+    QFile mIndexFile;
+
+    /**
+     * @brief mData the mapping of the data file.
+     */
+    const char* mData;
+
+    /**
+     * @brief mDataSize the size of the data file.
+     */
+    std::uint64_t mDataSize;
+
+    /**
+     * @brief mEntries the index entries inside the mapping of the index file.
+     */
+    const ContainerRecording::Entry* mEntries;
+
+    /**
+     * @brief mCount the number of valid index entries.
+     */
+    std::size_t mCount;
+};
+
+}
+
+#endif // CONTAINER_RECORDING_H
@@ -0,0 +1,288 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PacketTypeRegistry.h"
+
+namespace paco
+{
+
+/**
+ * @brief The PacketTypeStatistics struct is a snapshot of the counters of one packet type.
+ */
+struct PacketTypeStatistics
+{
+    paco::TypeId id;
+    paco::String name;
+    std::uint64_t appends;
+    std::uint64_t gets;
+    std::uint64_t castFailures;
+    std::uint64_t replaces;
+    std::uint64_t allocations;
+    std::uint64_t allocationBytes;
+};
+
+
+/**
+ * @brief The TypeMemoryUsage struct is the memory held by the objects of one type in a container.
+ */
+struct TypeMemoryUsage
+{
+    TypeMemoryUsage()
+        : id(0), count(0), bytes(0)
+    {
+    }
+
+    /**
+     * @brief id the registry id of the type.
+     */
+    paco::TypeId id;
+
+    /**
+     * @brief count the number of objects of the type.
+     */
+    std::size_t count;
+
+    /**
+     * @brief bytes the heap packets of the type plus the heap memory owned by their data.
+     * Packets stored inline are part of MemoryUsage::storage instead.
+     */
+    std::size_t bytes;
+};
+
+/**
+ * @brief The MemoryUsage struct is the memory held by a container, see Container::memoryUsage().
+ */
+struct MemoryUsage
+{
+    MemoryUsage()
+        : total(0), storage(0)
+    {
+    }
+
+    /**
+     * @brief total all memory held by the container in bytes, storage plus the bytes of all types.
+     */
+    std::size_t total;
+
+    /**
+     * @brief storage the container object, its slot array and its specification in bytes.
+     */
+    std::size_t storage;
+
+    /**
+     * @brief types the memory per type, ordered by type id.
+     */
+    std::vector<paco::TypeMemoryUsage> types;
+};
+
+
+/**
+ * @brief The Instrumentation class counts hot path operations per packet type.
+ *
+ * Instrumentation is switched on at compile time by defining PACO_INSTRUMENTATION, e.g. with
+ * DEFINES += PACO_INSTRUMENTATION in the .pro file. Without it all count functions are empty inline functions
+ * and the counters do not exist, so disabled instrumentation costs nothing.
+ *
+ * When enabled, the counters live in the PacketTypeDescriptor of each type and are incremented with relaxed atomics:
+ *
+ * - appends: objects added to a Container with append, emplace or insert, or appended to a ConcurrentContainer,
+ * - gets: successful typed accesses through packet_cast, i.e. get, get_ref, get_cref and take,
+ * - castFailures: failed packet_casts, counted for the actual type of the packet,
+ * - replaces: Container::replace,
+ * - allocations and allocationBytes: packets allocated on the heap instead of inline.
+ *
+ * snapshot() returns the counters of all types and dump() writes them in a line based text format
+ * that can be scraped from a long running process.
+ */
+class Instrumentation
+{
+public:
+
+    /**
+     * @brief enabled checks if the instrumentation has been compiled in.
+     * @return true if PACO_INSTRUMENTATION is defined.
+     */
+    static constexpr bool enabled()
+    {
+#ifdef PACO_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief countAppend counts an object added to a container.
+     */
+    static void countAppend(const paco::PacketTypeDescriptor* descriptor)
+    {
+#ifdef PACO_INSTRUMENTATION
+        descriptor->counters().appends.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void)descriptor;
+#endif
+    }
+
+    /**
+     * @brief countGet counts a successful typed access.
+     */
+    static void countGet(const paco::PacketTypeDescriptor* descriptor)
+    {
+#ifdef PACO_INSTRUMENTATION
+        descriptor->counters().gets.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void)descriptor;
+#endif
+    }
+
+    /**
+     * @brief countCastFailure counts a failed packet_cast of a packet of this type.
+     */
+    static void countCastFailure(const paco::PacketTypeDescriptor* descriptor)
+    {
+#ifdef PACO_INSTRUMENTATION
+        descriptor->counters().castFailures.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void)descriptor;
+#endif
+    }
+
+    /**
+     * @brief countReplace counts an object replaced in a container, counted for the new type.
+     */
+    static void countReplace(const paco::PacketTypeDescriptor* descriptor)
+    {
+#ifdef PACO_INSTRUMENTATION
+        descriptor->counters().replaces.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void)descriptor;
+#endif
+    }
+
+    /**
+     * @brief countAllocation counts a heap allocated packet.
+     * @param bytes the size of the allocation.
+     */
+    static void countAllocation(const paco::PacketTypeDescriptor* descriptor, std::size_t bytes)
+    {
+#ifdef PACO_INSTRUMENTATION
+        descriptor->counters().allocations.fetch_add(1, std::memory_order_relaxed);
+        descriptor->counters().allocationBytes.fetch_add(bytes, std::memory_order_relaxed);
+#else
+        (void)descriptor;
+        (void)bytes;
+#endif
+    }
+
+    /**
+     * @brief snapshot returns the counters of all registered types. Empty if the instrumentation is disabled.
+     * The counters of different types are read one after another, not atomically as a whole.
+     * @return the statistics of every registered type, ordered by type id.
+     */
+    static std::vector<paco::PacketTypeStatistics> snapshot()
+    {
+        std::vector<paco::PacketTypeStatistics> statistics;
+
+#ifdef PACO_INSTRUMENTATION
+        paco::PacketTypeRegistry& registry = paco::PacketTypeRegistry::instance();
+        int count = registry.count();
+
+        for(paco::TypeId id = 0; id < count; id++)
+        {
+            const paco::PacketTypeDescriptor* descriptor = registry.find(id);
+            const paco::PacketTypeCounters& counters = descriptor->counters();
+
+            paco::PacketTypeStatistics entry;
+            entry.id = id;
+            entry.name = descriptor->name();
+            entry.appends = counters.appends.load(std::memory_order_relaxed);
+            entry.gets = counters.gets.load(std::memory_order_relaxed);
+            entry.castFailures = counters.castFailures.load(std::memory_order_relaxed);
+            entry.replaces = counters.replaces.load(std::memory_order_relaxed);
+            entry.allocations = counters.allocations.load(std::memory_order_relaxed);
+            entry.allocationBytes = counters.allocationBytes.load(std::memory_order_relaxed);
+
+            statistics.push_back(entry);
+        }
+#endif
+
+        return statistics;
+    }
+
+    /**
+     * @brief reset sets all counters to zero.
+     */
+    static void reset()
+    {
+#ifdef PACO_INSTRUMENTATION
+        paco::PacketTypeRegistry& registry = paco::PacketTypeRegistry::instance();
+        int count = registry.count();
+
+        for(paco::TypeId id = 0; id < count; id++)
+        {
+            paco::PacketTypeCounters& counters = registry.find(id)->counters();
+
+            counters.appends.store(0, std::memory_order_relaxed);
+            counters.gets.store(0, std::memory_order_relaxed);
+            counters.castFailures.store(0, std::memory_order_relaxed);
+            counters.replaces.store(0, std::memory_order_relaxed);
+            counters.allocations.store(0, std::memory_order_relaxed);
+            counters.allocationBytes.store(0, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    /**
+     * @brief dump writes a snapshot with one line per counter and type, e.g.
+     *
+     *  paco_appends_total{type="<int>"} 42
+     *
+     * Types whose counters are all zero are skipped.
+     * @param stream the destination.
+     */
+    static void dump(std::ostream& stream)
+    {
+        std::vector<paco::PacketTypeStatistics> statistics = snapshot();
+
+        for(std::size_t i = 0; i < statistics.size(); i++)
+        {
+            const paco::PacketTypeStatistics& entry = statistics[i];
+
+            if(entry.appends == 0 && entry.gets == 0 && entry.castFailures == 0 && entry.replaces == 0 && entry.allocations == 0)
+            {
+                continue;
+            }
+
+            std::string label = "{type=\"" + paco::toStdString(entry.name) + "\"} ";
+
+            stream << "paco_appends_total" << label << entry.appends << "\n";
+            stream << "paco_gets_total" << label << entry.gets << "\n";
+            stream << "paco_cast_failures_total" << label << entry.castFailures << "\n";
+            stream << "paco_replaces_total" << label << entry.replaces << "\n";
+            stream << "paco_allocations_total" << label << entry.allocations << "\n";
+            stream << "paco_allocation_bytes_total" << label << entry.allocationBytes << "\n";
+        }
+
+        stream.flush();
+    }
+};
+
+}
+
+#endif // INSTRUMENTATION_H
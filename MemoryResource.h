@@ -0,0 +1,123 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace paco
+{
+
+/**
+ * @brief The ResourceAllocator_T template class is an allocator handle for a std::pmr::memory_resource.
+ * A null resource allocates with the global operator new, like std::allocator, without a virtual call.
+ *
+ * Unlike std::pmr::polymorphic_allocator the handle propagates on move assignment and swap, so a container
+ * that is moved takes its memory resource along, which keeps the default move operations of Container correct.
+ * Copies allocate with the global operator new, because a copy, e.g. of the specification of a container,
+ * may outlive a request scoped arena.
+ * @tparam T the type of the allocated objects.
+ */
+template <class T>
+class ResourceAllocator_T
+{
+public:
+
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    /**
+     * @brief ResourceAllocator_T constructor.
+     * @param resource the memory resource, or nullptr for the global operator new.
+     */
+    ResourceAllocator_T(std::pmr::memory_resource* resource = nullptr) noexcept
+        : mResource(resource)
+    {
+    }
+
+    template <class U>
+    ResourceAllocator_T(const ResourceAllocator_T<U>& other) noexcept
+        : mResource(other.resource())
+    {
+    }
+
+    ResourceAllocator_T select_on_container_copy_construction() const noexcept
+    {
+        return ResourceAllocator_T();
+    }
+
+    T* allocate(std::size_t count)
+    {
+        if(mResource == nullptr)
+        {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        return static_cast<T*>(mResource->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept
+    {
+        if(mResource == nullptr)
+        {
+            ::operator delete(pointer);
+        }
+        else
+        {
+            mResource->deallocate(pointer, count * sizeof(T), alignof(T));
+        }
+    }
+
+    /**
+     * @brief resource returns the memory resource.
+     * @return the memory resource, or nullptr for the global operator new.
+     */
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return mResource;
+    }
+
+private:
+
+    std::pmr::memory_resource* mResource;
+};
+
+template <class T, class U>
+bool operator==(const ResourceAllocator_T<T>& lhs, const ResourceAllocator_T<U>& rhs) noexcept
+{
+    return lhs.resource() == rhs.resource();
+}
+
+template <class T, class U>
+bool operator!=(const ResourceAllocator_T<T>& lhs, const ResourceAllocator_T<U>& rhs) noexcept
+{
+    return lhs.resource() != rhs.resource();
+}
+
+/**
+ * @brief threadLocalPool returns a pool resource of the calling thread.
+ * The pool is not synchronized: containers using it have to be created and destroyed on the same thread,
+ * and must not outlive the thread.
+ * @return the pool of the calling thread.
+ */
+inline std::pmr::memory_resource* threadLocalPool()
+{
+    thread_local std::pmr::unsynchronized_pool_resource pool;
+    return &pool;
+}
+
+}
+
+#endif // MEMORY_RESOURCE_H
@@ -11,13 +11,23 @@
 #ifndef PACKET_H
 #define PACKET_H
 
-#include <QString>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
+#include "Instrumentation.h"
+#include "PacoString.h"
 #include "PacketType.h"
-
-// FIXME: add category loggging or remove debug outputs
+#include "TypeName.h"
+#include "PacketVisitor.h"
 
 namespace paco
 {
@@ -38,14 +48,90 @@ class Packet_T;
 
 class Packet
 {
+protected:
+
+    /**
+     * @brief Packet constructor.
+     * @param descriptor the registered type descriptor of the stored data.
+     */
+    explicit Packet(const paco::PacketTypeDescriptor* descriptor)
+    {
+        mDescriptor = descriptor;
+    }
+
+    /**
+     * @brief mDescriptor is the registered type descriptor of the stored data.
+     */
+    const paco::PacketTypeDescriptor* mDescriptor;
+
 public:
 
+    /**
+     * @brief ~Packet destructor.
+     */
+    virtual ~Packet()
+    {
+
+    }
+
     /**
      * @brief getType returns the type of the container.
      * @return the packet type.
      */
 
-    virtual paco::PacketType packetType() = 0;
+    paco::PacketType packetType() const
+    {
+        return paco::PacketType(mDescriptor);
+    }
+
+    /**
+     * @brief moveTo move constructs this packet into a raw buffer and destroys this packet.
+     * Used by PacketSlot to relocate packets that are stored inline.
+     * @param buffer the destination buffer, large and aligned enough for the concrete packet type.
+     * @return the relocated packet inside the buffer.
+     */
+    virtual Packet* moveTo(void* buffer) = 0;
+
+    /**
+     * @brief moveToHeap move constructs this packet into a new heap allocation and destroys this packet.
+     * Used by PacketSlot to release packets that are stored inline.
+     * @return the relocated packet, owned by the caller.
+     */
+    virtual Packet* moveToHeap() = 0;
+
+    /**
+     * @brief packetSize returns the size of the concrete packet object, i.e. sizeof(Packet_T<T>).
+     * @return the size of the packet in bytes.
+     */
+    virtual std::size_t packetSize() const = 0;
+
+    /**
+     * @brief packetAlignment returns the alignment of the concrete packet object, i.e. alignof(Packet_T<T>).
+     * Used by PacketSlot to return packets to a memory resource.
+     * @return the alignment of the packet in bytes.
+     */
+    virtual std::size_t packetAlignment() const = 0;
+
+    /**
+     * @brief dataMemoryUsage returns the heap memory owned by the data of this packet, see paco::dynamicMemoryUsage().
+     * @return the heap memory of the data in bytes.
+     */
+    virtual std::size_t dataMemoryUsage() const = 0;
+
+    /**
+     * @brief rawData returns the address of the stored data, used by codecs to copy flat values in bulk.
+     * @return the address of the data.
+     */
+    virtual const void* rawData() const = 0;
+
+    /**
+     * @brief typeId returns the registry id of the stored data type.
+     * @return the registry id of the stored data type.
+     */
+    paco::TypeId typeId() const
+    {
+        return mDescriptor->id();
+    }
 
     /**
      * @brief get<T> returns the data of this packet in the specified template type T.
@@ -54,27 +140,162 @@ public:
     template <class T>
     T get() //throw(std::bad_cast)
     {
-        try
-        {
+        return paco::packet_cast<paco::Packet_T<T>*>(this)->data();
+    }
 
-            paco::Packet_T<T>* packet = paco::packet_cast<paco::Packet_T<T>*>(this);
+    /**
+     * @brief visit calls the handler matching the data type of this packet, see PacketVisitor_T.
+     * Example: packet->visit([](int& i){ ... }, [](QString& s){ ... }, [](paco::Packet& other){ ... });
+     * @param handlers lambdas taking one typed parameter, and optionally a fallback taking a paco::Packet&.
+     * @return true if a handler has been called.
+     */
+    template <class... Fs>
+    bool visit(Fs&&... handlers)
+    {
+        paco::PacketVisitor_T<typename std::remove_reference<Fs>::type...> visitor(handlers...);
+        return visitor.visit(typeId(), this);
+    }
 
-            //if(packet != nullptr)
-            {
-                return packet->data();
-            }
+    /**
+     * @brief is<T> checks if this packet stores data of type T. This is a single compare of the registered type.
+     * @return true if the packet stores data of type T.
+     */
+    template <class T>
+    bool is() const
+    {
+        return mDescriptor == paco::PacketTypeRegistry::descriptor<T>();
+    }
 
+    /**
+     * @brief get_if<T> returns a pointer to the data of this packet if it stores data of type T.
+     * Never throws, allocates or prints, so it is suited for speculative probing of packets.
+     * @return a pointer to the data, or nullptr if T and data do not match.
+     */
+    template <class T>
+    T* get_if()
+    {
+        if(is<T>())
+        {
+            return &static_cast<paco::Packet_T<T>*>(this)->dataRef();
         }
-        catch(std::bad_cast& e)
+
+        return nullptr;
+    }
+
+    /**
+     * @brief get_if<T> returns a const pointer to the data of this packet if it stores data of type T.
+     * @return a const pointer to the data, or nullptr if T and data do not match.
+     */
+    template <class T>
+    const T* get_if() const
+    {
+        if(is<T>())
         {
-            throw e;
+            return &static_cast<const paco::Packet_T<T>*>(this)->dataRef();
         }
 
-        //return nullptr;
+        return nullptr;
+    }
+
+    /**
+     * @brief try_get<T> copies the data of this packet into value if it stores data of type T.
+     * Like get_if<T>() it never throws on a type mismatch and leaves value untouched in that case.
+     * @param value receives the data of the packet.
+     * @return true if T and data match.
+     */
+    template <class T>
+    bool try_get(T& value) const
+    {
+        const T* data = get_if<T>();
+
+        if(data != nullptr)
+        {
+            value = *data;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief get_ref<T> returns a reference to the data of this packet without copying it.
+     * The reference is valid as long as the packet exists.
+     * @return the data of the packet as T&. If T and data do not match then a std::bad_cast is thrown.
+     */
+    template <class T>
+    T& get_ref()
+    {
+        return paco::packet_cast<paco::Packet_T<T>*>(this)->dataRef();
+    }
+
+    /**
+     * @brief get_cref<T> returns a const reference to the data of this packet without copying it.
+     * @return the data of the packet as const T&. If T and data do not match then a std::bad_cast is thrown.
+     */
+    template <class T>
+    const T& get_cref() const
+    {
+        return paco::packet_cast<paco::Packet_T<T>*>(const_cast<Packet*>(this))->dataRef();
+    }
+
+    /**
+     * @brief take<T> moves the data out of this packet. The packet keeps a moved-from T.
+     * @return the data of the packet as T. If T and data do not match then a std::bad_cast is thrown.
+     */
+    template <class T>
+    T take()
+    {
+        return std::move(get_ref<T>());
     }
 
 };
 
+/**
+ * @brief dynamicMemoryUsage returns the heap memory owned by an object, used by Container::memoryUsage().
+ * The default is 0, overloads for other types can be declared in the namespace of the type.
+ * @return the heap memory owned by the object in bytes.
+ */
+template <class T>
+std::size_t dynamicMemoryUsage(const T&)
+{
+    return 0;
+}
+
+/**
+ * @brief dynamicMemoryUsage returns the heap memory of a string, 0 if it uses the small string buffer.
+ */
+inline std::size_t dynamicMemoryUsage(const std::string& value)
+{
+    const char* data = value.data();
+    const char* object = reinterpret_cast<const char*>(&value);
+
+    if(data >= object && data < object + sizeof(value))
+    {
+        return 0;
+    }
+
+    return value.capacity() + 1;
+}
+
+#ifndef PACO_NO_QT
+/**
+ * @brief dynamicMemoryUsage returns the heap memory of a QString.
+ */
+inline std::size_t dynamicMemoryUsage(const QString& value)
+{
+    return value.capacity() > 0 ? (value.capacity() + 1) * 2 : 0;
+}
+#endif
+
+/**
+ * @brief dynamicMemoryUsage returns the heap memory of the buffer of a vector, not counting memory owned by its elements.
+ */
+template <class T, class Allocator>
+std::size_t dynamicMemoryUsage(const std::vector<T, Allocator>& value)
+{
+    return value.capacity() * sizeof(T);
+}
+
 /**
  * @brief The Packet_T templace class is a template packet that can store any kind of data.
  */
@@ -86,11 +307,14 @@ public:
 
     /**
      * @brief Packet_T is the constructor with the templaet parameter.
-     * @param data the object stored in this package.
+     * The data is constructed in place from the arguments, so Packet_T<T>(value) copies value once
+     * and Packet_T<T>(std::move(value)) does not copy at all.
+     * @param args the constructor arguments of the object stored in this package.
      */
-    Packet_T(T data)
+    template <class... Args>
+    explicit Packet_T(Args&&... args)
+        : Packet(paco::PacketTypeRegistry::descriptor<T>()), mData(std::forward<Args>(args)...)
     {
-        mData = data;
     }
 
 private:
@@ -111,48 +335,224 @@ public:
     }
 
     /**
-     * @brief packetType returns the package type of the package.
-     * @return the package type of the package.
+     * @brief dataRef returns a reference to the data of this package.
+     * @return a reference to the data of this package.
+     */
+    T& dataRef()
+    {
+        return mData;
+    }
+
+    /**
+     * @brief dataRef returns a const reference to the data of this package.
+     * @return a const reference to the data of this package.
+     */
+    const T& dataRef() const
+    {
+        return mData;
+    }
+
+    /**
+     * @brief moveTo move constructs this packet into a raw buffer and destroys this packet.
+     * @param buffer the destination buffer.
+     * @return the relocated packet inside the buffer.
+     */
+    virtual Packet* moveTo(void* buffer)
+    {
+        Packet_T<T>* moved = new (buffer) Packet_T<T>(std::move(mData));
+        this->~Packet_T<T>();
+        return moved;
+    }
+
+    /**
+     * @brief moveToHeap move constructs this packet into a new heap allocation and destroys this packet.
+     * @return the relocated packet, owned by the caller.
+     */
+    virtual Packet* moveToHeap()
+    {
+        Packet_T<T>* moved = new Packet_T<T>(std::move(mData));
+        paco::Instrumentation::countAllocation(mDescriptor, sizeof(Packet_T<T>));
+
+        this->~Packet_T<T>();
+        return moved;
+    }
+
+    /**
+     * @brief packetSize returns sizeof(Packet_T<T>).
+     * @return the size of the packet in bytes.
+     */
+    virtual std::size_t packetSize() const
+    {
+        return sizeof(Packet_T<T>);
+    }
+
+    /**
+     * @brief packetAlignment returns alignof(Packet_T<T>).
+     * @return the alignment of the packet in bytes.
+     */
+    virtual std::size_t packetAlignment() const
+    {
+        return alignof(Packet_T<T>);
+    }
+
+    /**
+     * @brief dataMemoryUsage returns the heap memory owned by the data.
+     * @return the heap memory of the data in bytes.
+     */
+    virtual std::size_t dataMemoryUsage() const
+    {
+        return dynamicMemoryUsage(mData);
+    }
+
+    /**
+     * @brief rawData returns the address of the data.
+     * @return the address of the data.
+     */
+    virtual const void* rawData() const
+    {
+        return &mData;
+    }
+
+};
+
+/**
+ * @brief createFlatPacket<T> constructs a packet of a flat type T from the bytes of a value, see FlatPacketFactory.
+ * T does not need a default constructor, the value is copied from the bytes like with std::bit_cast.
+ * @param data the bytes of the value, sizeof(T) bytes, need not be aligned.
+ * @param buffer the buffer to construct the packet in if it fits, e.g. the inline buffer of a PacketSlot.
+ * @param bufferSize the size of the buffer.
+ * @param bufferAlignment the alignment of the buffer.
+ * @return the packet, inside the buffer or on the heap.
+ */
+template <class T>
+paco::Packet* createFlatPacket(const void* data, void* buffer, std::size_t bufferSize, std::size_t bufferAlignment)
+{
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    std::memcpy(&storage, data, sizeof(T));
+
+    const T& value = *reinterpret_cast<const T*>(&storage);
+
+    if(sizeof(paco::Packet_T<T>) <= bufferSize && alignof(paco::Packet_T<T>) <= bufferAlignment)
+    {
+        return new (buffer) paco::Packet_T<T>(value);
+    }
+
+    return new paco::Packet_T<T>(value);
+}
+
+/**
+ * @brief BadCastHandler is the signature of the hook that is called when packet_cast fails.
+ * @param packet the packet that could not be casted.
+ * @param destination the type id string of the requested data type, e.g. "<int>", see paco::typeName<T>().
+ */
+typedef void (*BadCastHandler)(paco::Packet* packet, std::string_view destination);
+
+/**
+ * @brief badCastHandlerStorage holds the installed bad cast handler.
+ * @return the installed bad cast handler, nullptr by default.
+ */
+inline std::atomic<BadCastHandler>& badCastHandlerStorage()
+{
+    static std::atomic<BadCastHandler> handler(nullptr);
+    return handler;
+}
+
+/**
+ * @brief setBadCastHandler installs a hook that is called before packet_cast throws std::bad_cast.
+ * By default no handler is installed and a failing cast does no I/O or string formatting.
+ * Install paco::printBadCast to get the diagnostic output on std::cout.
+ * @param handler the new handler, or nullptr to disable the hook.
+ * @return the previously installed handler.
+ */
+inline BadCastHandler setBadCastHandler(BadCastHandler handler)
+{
+    return badCastHandlerStorage().exchange(handler);
+}
+
+/**
+ * @brief printBadCast is a bad cast handler that prints the source and destination type of a failed cast to std::cout.
+ * @param packet the packet that could not be casted.
+ * @param destination the type id string of the requested data type.
+ */
+inline void printBadCast(paco::Packet* packet, std::string_view destination)
+{
+    std::string typeNameStringSrc(packet->packetType().descriptor()->nameView());
+
+    std::string errorMessage = "bad cast error: casting Packet data from '" + typeNameStringSrc + "' to '" + std::string(destination) + "' not possible.";
+
+    std::cout << "#################################################################################################################" << std::endl;
+    std::cout << errorMessage << std::endl;
+    std::cout << "#################################################################################################################" << std::endl;
+}
+
+/**
+ * @brief The PacketCastHelper_T class performs the actual cast of packet_cast.
+ * Casts to arbitrary packet classes use dynamic_cast.
+ */
+template <class T>
+struct PacketCastHelper_T
+{
+    /**
+     * @brief name returns the type id string of the cast destination, reported to the bad cast handler.
      */
-    virtual paco::PacketType packetType()
+    static constexpr std::string_view name()
     {
+        return paco::typeName<T>();
+    }
 
-        return paco::PacketType_T<T>();
+    static T cast(Packet* packet)
+    {
+        return dynamic_cast<T>(packet);
     }
+};
 
+/**
+ * @brief The PacketCastHelper_T class specialization for Packet_T<T>* compares the registered type ids instead of using dynamic_cast.
+ */
+template <class T>
+struct PacketCastHelper_T<paco::Packet_T<T>*>
+{
+    static constexpr std::string_view name()
+    {
+        return paco::typeName<T>();
+    }
+
+    static paco::Packet_T<T>* cast(Packet* packet)
+    {
+        if(packet != nullptr && packet->template is<T>())
+        {
+            paco::Instrumentation::countGet(paco::PacketTypeRegistry::descriptor<T>());
+            return static_cast<paco::Packet_T<T>*>(packet);
+        }
+
+        return nullptr;
+    }
 };
 
 /**
  * @brief packet_cast casts the packet into a package of data type T.
  * Throws an std::bad_cast exception in case the desired package type T
- * does not match the packets actual data type.
+ * does not match the packets actual data type. Before throwing, the handler installed
+ * with setBadCastHandler() is called.
  * @param the package type of the package.
  */
 template <class T>
 T packet_cast(Packet* packet)
 {
-    T castedPacket = dynamic_cast<T>(packet);
+    T castedPacket = paco::PacketCastHelper_T<T>::cast(packet);
 
     if(packet != nullptr && castedPacket == nullptr)
     {
-        QString typeNameStringDst = typeid(T).name();
-        typeNameStringDst.append("#");
-        typeNameStringDst.replace("class " , "");
-        typeNameStringDst.replace("paco::Packet_T" , "");
-        typeNameStringDst.replace("*#" , "");
-        typeNameStringDst.replace(" " , "");
-
-        QString typeNameStringSrc = packet->packetType().toString();
+        paco::Instrumentation::countCastFailure(packet->packetType().descriptor());
 
-        //assert(typeNameStringSrc.toStdString() == typeNameStringDst.toStdString());
+        BadCastHandler handler = badCastHandlerStorage().load(std::memory_order_relaxed);
 
-        QString errorMessage = "bad cast error: casting Packet data from '" + typeNameStringSrc + "' to '" + typeNameStringDst + "' not possible.";
-
-        std::cout << "#################################################################################################################" << std::endl;
-        std::cout << errorMessage.toStdString() << std::endl;
-        std::cout << "#################################################################################################################" << std::endl;
+        if(handler != nullptr)
+        {
+            handler(packet, paco::PacketCastHelper_T<T>::name());
+        }
 
-        throw std::bad_cast();//errorMessage.toStdString().c_str());
+        throw std::bad_cast();
 
     }
 
@@ -0,0 +1,349 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACKET_SLOT_H
+#define PACKET_SLOT_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Instrumentation.h"
+#include "Packet.h"
+
+namespace paco
+{
+
+/**
+ * @brief The PacketSlot class is one element of the contiguous storage of a container.
+ * Packets of small trivially copyable types (int, double, pointers, ...) are constructed directly inside the slot,
+ * so they need no heap allocation and live next to their neighbours in memory. All other packets are allocated
+ * on the heap and the slot only keeps the pointer.
+ *
+ * In both cases packet() returns the packet, so code using Packet* does not need to know where it is stored.
+ * An inline packet moves when the slot moves, so pointers into a slot are invalidated when the slot is moved.
+ *
+ * Heap packets are allocated from a std::pmr::memory_resource if one is passed with InPlace_T, otherwise with new.
+ * The resource of a heap packet is kept in the otherwise unused inline buffer, so the slot does not grow and
+ * always returns the packet to where it came from, also after it has been moved into another container.
+ */
+class PacketSlot
+{
+public:
+
+    /**
+     * @brief InlineSize is the size of the inline buffer, enough for a packet carrying one pointer sized value.
+     */
+    static const std::size_t InlineSize = 3 * sizeof(void*);
+
+    /**
+     * @brief InlineAlignment is the alignment of the inline buffer.
+     */
+    static const std::size_t InlineAlignment = alignof(void*);
+
+    /**
+     * @brief storesInline<T> checks if packets of type T are stored inside the slot.
+     * @return true if packets of type T are stored inline.
+     */
+    template <class T>
+    static constexpr bool storesInline()
+    {
+        return std::is_trivially_copyable<T>::value
+                && sizeof(paco::Packet_T<T>) <= InlineSize
+                && alignof(paco::Packet_T<T>) <= InlineAlignment;
+    }
+
+    /**
+     * @brief The InPlace_T struct selects the in place constructor of a slot for packets of type T.
+     */
+    template <class T>
+    struct InPlace_T
+    {
+        /**
+         * @brief InPlace_T constructor.
+         * @param resource the memory resource of a heap packet, nullptr for new.
+         */
+        explicit InPlace_T(std::pmr::memory_resource* resource = nullptr)
+            : resource(resource)
+        {
+        }
+
+        std::pmr::memory_resource* resource;
+    };
+
+public:
+
+    /**
+     * @brief PacketSlot default constructor, creates an empty slot.
+     */
+    PacketSlot()
+    {
+        mPacket = nullptr;
+    }
+
+    /**
+     * @brief PacketSlot constructs a slot with a new packet of type T, constructing its data in place.
+     * @param args the constructor arguments of the data of the packet.
+     */
+    template <class T, class... Args>
+    explicit PacketSlot(InPlace_T<T> tag, Args&&... args)
+    {
+        mPacket = create<T>(std::integral_constant<bool, storesInline<T>()>(), tag.resource, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief PacketSlot constructs a slot with a new packet of a flat type from the bytes of a value.
+     * Small types are stored inline like with InPlace_T, see PacketTypeDescriptor::flatPacketFactory().
+     * @param descriptor the descriptor of a flat type.
+     * @param data the bytes of the value, descriptor->size() bytes.
+     */
+    PacketSlot(const paco::PacketTypeDescriptor* descriptor, const void* data)
+    {
+        mPacket = descriptor->flatPacketFactory()(data, mStorage, InlineSize, InlineAlignment);
+
+        if(!isInline())
+        {
+            paco::Instrumentation::countAllocation(descriptor, mPacket->packetSize());
+            setHeapResource(nullptr);
+        }
+    }
+
+    /**
+     * @brief PacketSlot move constructor, relocates an inline packet or takes over a heap packet.
+     * @param other the slot to move from, empty afterwards.
+     */
+    PacketSlot(PacketSlot&& other) noexcept
+    {
+        mPacket = nullptr;
+        take(other);
+    }
+
+    /**
+     * @brief operator= move assignment, destroys the current packet and takes over the packet of other.
+     * @param other the slot to move from, empty afterwards.
+     * @return this slot.
+     */
+    PacketSlot& operator=(PacketSlot&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            take(other);
+        }
+
+        return *this;
+    }
+
+    PacketSlot(const PacketSlot&) = delete;
+    PacketSlot& operator=(const PacketSlot&) = delete;
+
+    /**
+     * @brief ~PacketSlot destructor, destroys the packet.
+     */
+    ~PacketSlot()
+    {
+        reset();
+    }
+
+    /**
+     * @brief emplace<T> destroys the current packet and stores a new packet, constructing its data in place.
+     * @param args the constructor arguments of the data of the new packet.
+     * @return the new packet.
+     */
+    template <class T, class... Args>
+    paco::Packet_T<T>* emplace(Args&&... args)
+    {
+        reset();
+
+        paco::Packet_T<T>* packet = create<T>(std::integral_constant<bool, storesInline<T>()>(), nullptr, std::forward<Args>(args)...);
+        mPacket = packet;
+
+        return packet;
+    }
+
+    /**
+     * @brief reset destroys the packet and leaves the slot empty.
+     */
+    void reset()
+    {
+        if(mPacket != nullptr)
+        {
+            std::pmr::memory_resource* resource = heapResource();
+
+            if(isInline())
+            {
+                mPacket->~Packet();
+            }
+            else if(resource != nullptr)
+            {
+                std::size_t size = mPacket->packetSize();
+                std::size_t alignment = mPacket->packetAlignment();
+
+                mPacket->~Packet();
+                resource->deallocate(mPacket, size, alignment);
+            }
+            else
+            {
+                delete mPacket;
+            }
+
+            mPacket = nullptr;
+        }
+    }
+
+    /**
+     * @brief release hands the packet over to the caller and leaves the slot empty.
+     * An inline packet or a packet of a memory resource is moved to the heap first, so the result can always be
+     * deleted with delete.
+     * @return the packet owned by the caller, or nullptr if the slot is empty.
+     */
+    paco::Packet* release()
+    {
+        paco::Packet* packet = mPacket;
+        std::pmr::memory_resource* resource = heapResource();
+
+        if(isInline())
+        {
+            packet = mPacket->moveToHeap();
+        }
+        else if(resource != nullptr)
+        {
+            std::size_t size = mPacket->packetSize();
+            std::size_t alignment = mPacket->packetAlignment();
+
+            packet = mPacket->moveToHeap();
+            resource->deallocate(mPacket, size, alignment);
+        }
+
+        mPacket = nullptr;
+
+        return packet;
+    }
+
+    /**
+     * @brief packet returns the packet stored in this slot.
+     * @return the packet, or nullptr if the slot is empty.
+     */
+    paco::Packet* packet() const
+    {
+        return mPacket;
+    }
+
+    /**
+     * @brief isInline checks if the packet is stored inside the slot.
+     * @return true if the packet is stored inside the slot.
+     */
+    bool isInline() const
+    {
+        return mPacket != nullptr && (const void*)mPacket == (const void*)mStorage;
+    }
+
+private:
+
+    /**
+     * @brief create constructs a packet inside the inline buffer.
+     */
+    template <class T, class... Args>
+    paco::Packet_T<T>* create(std::true_type, std::pmr::memory_resource*, Args&&... args)
+    {
+        return new (mStorage) paco::Packet_T<T>(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief create constructs a packet on the heap or in a memory resource, and remembers the resource.
+     */
+    template <class T, class... Args>
+    paco::Packet_T<T>* create(std::false_type, std::pmr::memory_resource* resource, Args&&... args)
+    {
+        paco::Packet_T<T>* packet;
+
+        if(resource == nullptr)
+        {
+            packet = new paco::Packet_T<T>(std::forward<Args>(args)...);
+        }
+        else
+        {
+            void* memory = resource->allocate(sizeof(paco::Packet_T<T>), alignof(paco::Packet_T<T>));
+
+            try
+            {
+                packet = new (memory) paco::Packet_T<T>(std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                resource->deallocate(memory, sizeof(paco::Packet_T<T>), alignof(paco::Packet_T<T>));
+                throw;
+            }
+        }
+
+        paco::Instrumentation::countAllocation(paco::PacketTypeRegistry::descriptor<T>(), sizeof(paco::Packet_T<T>));
+        setHeapResource(resource);
+
+        return packet;
+    }
+
+    /**
+     * @brief heapResource returns the memory resource of a heap packet, nullptr for new or an inline packet.
+     */
+    std::pmr::memory_resource* heapResource() const
+    {
+        std::pmr::memory_resource* resource = nullptr;
+
+        if(mPacket != nullptr && !isInline())
+        {
+            std::memcpy(&resource, mStorage, sizeof(resource));
+        }
+
+        return resource;
+    }
+
+    void setHeapResource(std::pmr::memory_resource* resource)
+    {
+        std::memcpy(mStorage, &resource, sizeof(resource));
+    }
+
+    /**
+     * @brief take moves the packet of other into this empty slot.
+     * @param other the slot to move from.
+     */
+    void take(PacketSlot& other)
+    {
+        if(other.isInline())
+        {
+            mPacket = other.mPacket->moveTo(mStorage);
+        }
+        else
+        {
+            setHeapResource(other.heapResource());
+            mPacket = other.mPacket;
+        }
+
+        other.mPacket = nullptr;
+    }
+
+private:
+
+    /**
+     * @brief mPacket points to the packet, either into mStorage or to the heap.
+     */
+    paco::Packet* mPacket;
+
+    /**
+     * @brief mStorage is the inline buffer for small packets, or holds the memory resource of a heap packet.
+     */
+    alignas(InlineAlignment) unsigned char mStorage[InlineSize];
+};
+
+}
+
+#endif // PACKET_SLOT_H
@@ -14,15 +14,10 @@
 
 #include <stdio.h>
 #include <iostream>
-#include <typeinfo>
 
-#if __GNUC__
-    #include <cxxabi.h>
-#endif
-
-
-
-#include <QString>
+#include "PacoString.h"
+#include "PacketTypeRegistry.h"
+#include "SlotKey.h"
 
 namespace paco
 {
@@ -33,6 +28,8 @@ class PacketType_T;
 
 /**
  * @brief The PacketType class stores the packet type of a package.
+ * A packet type is a cheap, trivially copyable handle: a pointer to the registered type descriptor
+ * and a pointer to an interned description. Comparing two packet types is an integer compare.
  */
 class PacketType
 {
@@ -43,21 +40,32 @@ public:
      */
     PacketType()
     {
-        mPacketString = "<PacketType not specified>";
-        mPacketDescription = "";
+        mDescriptor = paco::PacketTypeRegistry::unspecified();
+        mDescription = nullptr;
+    }
+
+    /**
+     * @brief PacketType constructs a packet type from a registered descriptor.
+     * @param descriptor the type descriptor, see PacketTypeRegistry::descriptor<T>().
+     * @param description the interned description, see PacketTypeRegistry::internDescription().
+     */
+    explicit PacketType(const paco::PacketTypeDescriptor* descriptor, const paco::String* description = nullptr)
+    {
+        mDescriptor = descriptor;
+        mDescription = description;
     }
 
 protected:
 
     /**
-     * @brief mPacketString contains the type of the packet.
+     * @brief mDescriptor is the registered descriptor of the packet type.
      */
-    QString mPacketString;
+    const paco::PacketTypeDescriptor* mDescriptor;
 
     /**
-     * @brief mPacketDescription contains the description of the packet.
+     * @brief mDescription is the interned description of the packet, or nullptr.
      */
-    QString mPacketDescription;
+    const paco::String* mDescription;
 
 public:
 
@@ -65,9 +73,45 @@ public:
      * @brief toString returns the type id string of the packet.
      * @return the type id string of the packet.
      */
-    virtual QString toString() const
+    paco::String toString() const
+    {
+        return mDescriptor->name();
+    }
+
+    /**
+     * @brief description returns the description of the packet.
+     * @return the description of the packet.
+     */
+    paco::String description() const
     {
-        return mPacketString;
+        return mDescription != nullptr ? *mDescription : paco::String();
+    }
+
+    /**
+     * @brief key returns the description as a key, see Container::append<T>(key, value).
+     * @return the key of the packet, the null key if it has no description.
+     */
+    paco::SlotKey key() const
+    {
+        return paco::SlotKey::fromInterned(mDescription);
+    }
+
+    /**
+     * @brief typeId returns the registry id of the packet type.
+     * @return the registry id of the packet type.
+     */
+    paco::TypeId typeId() const
+    {
+        return mDescriptor->id();
+    }
+
+    /**
+     * @brief descriptor returns the registered descriptor of the packet type.
+     * @return the registered descriptor of the packet type.
+     */
+    const paco::PacketTypeDescriptor* descriptor() const
+    {
+        return mDescriptor;
     }
 
     /**
@@ -75,9 +119,9 @@ public:
      * @param other the packet to compare with.
      * @return true if the packets type id's match.
      */
-    bool equals(PacketType& other)
+    bool equals(const PacketType& other) const
     {
-        return other.toString().compare(this->toString()) == 0;
+        return other.mDescriptor == mDescriptor;
     }
 
 
@@ -86,12 +130,9 @@ public:
      * @return true if the packet matches a type.
      */
     template <class T>
-    bool equals()
+    bool equals() const
     {
-        PacketType_T<T> other = PacketType_T<T>();
-        PacketType* otherBase = dynamic_cast<PacketType*>(&other);
-
-        return otherBase->toString().compare(this->toString()) == 0;
+        return paco::PacketTypeRegistry::descriptor<T>() == mDescriptor;
     }
 
 };
@@ -105,7 +146,7 @@ public:
  */
 inline bool operator==(const PacketType& lhs, const PacketType& rhs)
 {
-    return lhs.toString().compare(rhs.toString()) == 0;
+    return lhs.equals(rhs);
 }
 
 /**
@@ -131,67 +172,10 @@ public:
      * @brief PacketType_T is the default constructor.
      * @param description is the description of the packet.
      */
-    PacketType_T(QString description = "")
+    PacketType_T(paco::String description = "")
+        : PacketType(paco::PacketTypeRegistry::descriptor<T>(),
+                     paco::PacketTypeRegistry::instance().internDescription(description))
     {
-        mPacketString = toStringHelper();
-        mPacketDescription = description;
-    }
-
-public:
-
-    /**
-     * @brief toString returns the packet type id string.
-     * @return the packet type id string.
-     */
-    virtual QString toString() const
-    {
-        return mPacketString;
-    }
-
-private:
-
-    /**
-     * @brief toStringHelper is a helper function to create a human readable type id string from the type id.
-     * @return a human readable type id string from the type id.
-     */
-    QString toStringHelper()
-    {
-        QString typeIdString;
-
-
-        const std::type_info  &ti = typeid(T);
-
-#if _WIN32 || _WIN64
-#if !__GNUC__
-        //msvc
-        typeIdString = /*"Packet_T*/"<" + QString(ti.name()) + ">";
-#endif
-#endif
-
-// Check GCC, then use demangle to format the type name nicely.
-#if __GNUC__
-        int     status;
-        char   *realname;
-
-        realname = abi::__cxa_demangle(ti.name(), 0, 0, &status);
-        typeIdString = QString("<" + QString(realname) + ">");
-        free(realname);
-#endif
-
-
-        typeIdString.replace("<class ", "<");
-        typeIdString.replace(" ", "");
-        typeIdString.replace(",classstd::allocator", "");
-        typeIdString.replace(",std::allocator", "");
-
-        /*
-        if(typeIdString.startsWith("<"))
-        {
-            typeIdString = typeIdString.remove(0,1);
-            typeIdString = typeIdString.remove(typeIdString.length()-1,1);
-        }*/
-
-        return typeIdString;
     }
 };
 
@@ -0,0 +1,620 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACKET_TYPE_REGISTRY_H
+#define PACKET_TYPE_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "PacoString.h"
+#include "TypeName.h"
+
+namespace paco
+{
+
+/**
+ * @brief TypeId is the small integer id the registry assigns to every packet type.
+ * Ids are dense and start at 0, which is reserved for the unspecified packet type.
+ * They are only valid within one process, use PacketTypeDescriptor::hash() to identify types across processes.
+ */
+typedef int TypeId;
+
+class Packet;
+class PacketCodec;
+
+/**
+ * @brief FlatPacketFactory constructs a packet of a flat type from the bytes of a value, see createFlatPacket<T>().
+ * The packet is constructed inside the buffer if it fits, otherwise on the heap.
+ */
+typedef paco::Packet* (*FlatPacketFactory)(const void* data, void* buffer, std::size_t bufferSize, std::size_t bufferAlignment);
+
+/**
+ * @brief createFlatPacket<T> is the FlatPacketFactory of a flat type T, defined in Packet.h.
+ */
+template <class T>
+paco::Packet* createFlatPacket(const void* data, void* buffer, std::size_t bufferSize, std::size_t bufferAlignment);
+
+#ifdef PACO_INSTRUMENTATION
+/**
+ * @brief The PacketTypeCounters struct holds the hot path counters of one packet type, see Instrumentation.h.
+ */
+struct PacketTypeCounters
+{
+    PacketTypeCounters()
+        : appends(0), gets(0), castFailures(0), replaces(0), allocations(0), allocationBytes(0)
+    {
+    }
+
+    std::atomic<std::uint64_t> appends;
+    std::atomic<std::uint64_t> gets;
+    std::atomic<std::uint64_t> castFailures;
+    std::atomic<std::uint64_t> replaces;
+    std::atomic<std::uint64_t> allocations;
+    std::atomic<std::uint64_t> allocationBytes;
+};
+#endif
+
+/**
+ * @brief The PacketTypeDescriptor class describes a single registered packet type.
+ * Descriptors are created once per type by the PacketTypeRegistry and live until the program exits,
+ * so pointers to them can be stored and compared freely.
+ */
+class PacketTypeDescriptor
+{
+    friend class PacketTypeRegistry;
+
+public:
+
+    /**
+     * @brief id returns the registry id of the type.
+     * @return the registry id of the type.
+     */
+    TypeId id() const
+    {
+        return mId;
+    }
+
+    /**
+     * @brief name returns the human readable type id string, e.g. "<QList<int>*>".
+     * @return the human readable type id string.
+     */
+    const paco::String& name() const
+    {
+        return mName;
+    }
+
+    /**
+     * @brief nameView returns the type id string as computed at compile time by paco::typeName<T>().
+     * @return the type id string.
+     */
+    std::string_view nameView() const
+    {
+        return mNameView;
+    }
+
+    /**
+     * @brief hash returns a 64 bit FNV-1a hash of the type name, see paco::typeHash<T>(). Unlike id() it is stable
+     * across processes.
+     * @return the hash of the type name.
+     */
+    std::uint64_t hash() const
+    {
+        return mHash;
+    }
+
+    /**
+     * @brief size returns sizeof(T) of the registered type.
+     * @return the size of the type in bytes.
+     */
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief isTriviallyCopyable returns true if the type can be copied with memcpy.
+     * @return true if the type is trivially copyable.
+     */
+    bool isTriviallyCopyable() const
+    {
+        return mTriviallyCopyable;
+    }
+
+    /**
+     * @brief isFlat returns true if the bytes of a value are meaningful outside of the process,
+     * i.e. the type is trivially copyable and not a pointer.
+     * @return true if the type is flat.
+     */
+    bool isFlat() const
+    {
+        return mFlat;
+    }
+
+    /**
+     * @brief codec returns the codec registered for the type, see ContainerCodec.h.
+     * @return the codec, or nullptr if no codec has been registered.
+     */
+    const paco::PacketCodec* codec() const
+    {
+        return mCodec.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief flatPacketFactory returns the function that constructs a packet of the type from the bytes of a value.
+     * Used to decode flat types that have no registered codec, see ContainerCodec.h.
+     * @return the factory, or nullptr if the type is not flat.
+     */
+    paco::FlatPacketFactory flatPacketFactory() const
+    {
+        return mFlatPacketFactory;
+    }
+
+#ifdef PACO_INSTRUMENTATION
+    /**
+     * @brief counters returns the hot path counters of the type, only available with PACO_INSTRUMENTATION.
+     * @return the counters of the type.
+     */
+    paco::PacketTypeCounters& counters() const
+    {
+        return mCounters;
+    }
+#endif
+
+private:
+
+    /**
+     * @brief PacketTypeDescriptor constructor, only the registry creates descriptors.
+     */
+    PacketTypeDescriptor()
+        : mCodec(nullptr)
+    {
+    }
+
+    /**
+     * @brief mId is the registry id of the type.
+     */
+    TypeId mId;
+
+    /**
+     * @brief mName is the human readable type id string.
+     */
+    paco::String mName;
+
+    /**
+     * @brief mNameView is the type id string in static storage.
+     */
+    std::string_view mNameView;
+
+    /**
+     * @brief mHash is the hash of mName.
+     */
+    std::uint64_t mHash;
+
+    /**
+     * @brief mSize is sizeof(T).
+     */
+    std::size_t mSize;
+
+    /**
+     * @brief mTriviallyCopyable is std::is_trivially_copyable<T>.
+     */
+    bool mTriviallyCopyable;
+
+    /**
+     * @brief mFlat is true if T is trivially copyable and not a pointer.
+     */
+    bool mFlat;
+
+    /**
+     * @brief mFlatPacketFactory constructs packets from bytes if T is flat, otherwise nullptr.
+     */
+    paco::FlatPacketFactory mFlatPacketFactory;
+
+    /**
+     * @brief mCodec is the codec of the type, or nullptr.
+     */
+    std::atomic<const paco::PacketCodec*> mCodec;
+
+#ifdef PACO_INSTRUMENTATION
+    /**
+     * @brief mCounters are the hot path counters of the type.
+     */
+    mutable paco::PacketTypeCounters mCounters;
+#endif
+};
+
+
+/**
+ * @brief The PacketTypeRegistry class assigns every packet type T a PacketTypeDescriptor with a small integer id.
+ * The type name of T and its hash are computed at compile time by paco::typeName<T>() and paco::typeHash<T>(),
+ * registering T only allocates the descriptor. Afterwards looking up the descriptor of T is a single load of
+ * a function local static, which makes type checks plain integer compares.
+ *
+ * The registry also interns the descriptions of packet types, so that a PacketType only has to carry a pointer.
+ */
+class PacketTypeRegistry
+{
+public:
+
+    /**
+     * @brief instance returns the process wide registry.
+     * @return the process wide registry.
+     */
+    static PacketTypeRegistry& instance()
+    {
+        static PacketTypeRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief descriptor<T> returns the descriptor of type T and registers T on first use.
+     * @return the descriptor of type T.
+     */
+    template <class T>
+    static const PacketTypeDescriptor* descriptor()
+    {
+        typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value
+                                             && !std::is_pointer<T>::value
+                                             && !std::is_member_pointer<T>::value> Flat;
+
+        static const PacketTypeDescriptor* descriptor = instance().registerType(paco::typeName<T>(),
+                                                                                paco::typeHash<T>(),
+                                                                                sizeof(T),
+                                                                                std::is_trivially_copyable<T>::value,
+                                                                                flatPacketFactory<T>(Flat()));
+        return descriptor;
+    }
+
+    /**
+     * @brief id<T> returns the registry id of type T.
+     * @return the registry id of type T.
+     */
+    template <class T>
+    static TypeId id()
+    {
+        return descriptor<T>()->id();
+    }
+
+    /**
+     * @brief unspecified returns the descriptor of the unspecified packet type with id 0.
+     * @return the descriptor of the unspecified packet type.
+     */
+    static const PacketTypeDescriptor* unspecified()
+    {
+        return instance().mUnspecified;
+    }
+
+    /**
+     * @brief find returns the descriptor of a registered type id.
+     * @param id the registry id.
+     * @return the descriptor, or nullptr if no type with that id has been registered.
+     */
+    const PacketTypeDescriptor* find(TypeId id)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if(id >= 0 && id < (int)mDescriptors.size())
+        {
+            return mDescriptors.at(id).get();
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief findByHash returns the descriptor of a registered type by its name hash.
+     * Only types that have been used in this process can be found.
+     * @param hash the hash of the type name, see PacketTypeDescriptor::hash().
+     * @return the descriptor, or nullptr if no such type has been registered.
+     */
+    const PacketTypeDescriptor* findByHash(std::uint64_t hash)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        std::map<std::uint64_t, const PacketTypeDescriptor*>::const_iterator it = mHashes.find(hash);
+        if(it != mHashes.end())
+        {
+            return it->second;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief count returns the number of registered types, including the unspecified type.
+     * @return the number of registered types.
+     */
+    int count()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDescriptors.size();
+    }
+
+    /**
+     * @brief setCodec installs the codec of a type. The registry keeps the codec alive until the program exits.
+     * Usually called through paco::registerCodec<T>(), see ContainerCodec.h.
+     * @param descriptor the descriptor of the type.
+     * @param codec the codec of the type.
+     */
+    void setCodec(const PacketTypeDescriptor* descriptor, const std::shared_ptr<const paco::PacketCodec>& codec)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mCodecs.push_back(codec);
+        mDescriptors.at(descriptor->id())->mCodec.store(codec.get(), std::memory_order_release);
+    }
+
+    /**
+     * @brief internDescription returns a pointer to a shared copy of the description.
+     * Equal descriptions always return the same pointer. Empty descriptions return nullptr.
+     * @param description the description to intern.
+     * @return the interned description.
+     */
+    const paco::String* internDescription(const paco::String& description)
+    {
+        if(paco::isEmpty(description))
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        std::map<paco::String, const paco::String*>::const_iterator it = mDescriptions.find(description);
+        if(it != mDescriptions.end())
+        {
+            return it->second;
+        }
+
+        mDescriptionStorage.push_back(description);
+        const paco::String* interned = &mDescriptionStorage.back();
+        mDescriptions[description] = interned;
+
+        std::string utf8 = paco::toStdString(description);
+        mNameStorage.push_back(InternedName{utf8, hashName(utf8), interned});
+        insertName(&mNameStorage.back());
+
+        return interned;
+    }
+
+    /**
+     * @brief findDescription returns the interned copy of a description without interning it. Lock free, so name
+     * lookups like Container::contains("name") neither wait for the registry nor grow it.
+     * @param utf8 the description in UTF-8.
+     * @return the interned description, or nullptr if it has never been interned or is empty.
+     */
+    const paco::String* findDescription(std::string_view utf8) const
+    {
+        if(utf8.empty())
+        {
+            return nullptr;
+        }
+
+        const std::uint64_t hash = hashName(utf8);
+        const NameTable* table = mNames.load(std::memory_order_acquire);
+
+        for(std::size_t i = hash & table->mask; ; i = (i + 1) & table->mask)
+        {
+            const InternedName* name = table->slots[i].load(std::memory_order_acquire);
+
+            if(name == nullptr)
+            {
+                return nullptr;
+            }
+
+            if(name->hash == hash && name->utf8 == utf8)
+            {
+                return name->description;
+            }
+        }
+    }
+
+    /**
+     * @brief hashName computes the 64 bit FNV-1a hash of a type name.
+     * @param name the type name.
+     * @return the hash of the name.
+     */
+    static constexpr std::uint64_t hashName(std::string_view name)
+    {
+        return paco::fnv1a(name);
+    }
+
+private:
+
+    /**
+     * @brief PacketTypeRegistry constructor, registers the unspecified type as id 0.
+     */
+    PacketTypeRegistry()
+    {
+        mNameTables.push_back(std::unique_ptr<NameTable>(new NameTable(16)));
+        mNames.store(mNameTables.back().get(), std::memory_order_release);
+
+        mUnspecified = registerType("<PacketType not specified>", hashName("<PacketType not specified>"), 0, false, nullptr);
+    }
+
+    /**
+     * @brief flatPacketFactory<T> returns createFlatPacket<T> for a flat type T.
+     */
+    template <class T>
+    static paco::FlatPacketFactory flatPacketFactory(std::true_type)
+    {
+        return &paco::createFlatPacket<T>;
+    }
+
+    /**
+     * @brief flatPacketFactory<T> returns nullptr for a type that is not flat.
+     */
+    template <class T>
+    static paco::FlatPacketFactory flatPacketFactory(std::false_type)
+    {
+        return nullptr;
+    }
+
+    PacketTypeRegistry(const PacketTypeRegistry&) = delete;
+    PacketTypeRegistry& operator=(const PacketTypeRegistry&) = delete;
+
+    /**
+     * @brief registerType creates a new descriptor. Called exactly once per type.
+     * @param flatPacketFactory the factory of a flat type, nullptr if the type is not flat.
+     * @return the new descriptor.
+     */
+    const PacketTypeDescriptor* registerType(std::string_view name, std::uint64_t hash, std::size_t size, bool triviallyCopyable,
+                                             paco::FlatPacketFactory flatPacketFactory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        PacketTypeDescriptor* descriptor = new PacketTypeDescriptor();
+        descriptor->mId = mDescriptors.size();
+        descriptor->mName = paco::fromUtf8(name);
+        descriptor->mNameView = name;
+        descriptor->mHash = hash;
+        descriptor->mSize = size;
+        descriptor->mTriviallyCopyable = triviallyCopyable;
+        descriptor->mFlat = flatPacketFactory != nullptr;
+        descriptor->mFlatPacketFactory = flatPacketFactory;
+
+        mDescriptors.push_back(std::unique_ptr<PacketTypeDescriptor>(descriptor));
+        mHashes.insert(std::make_pair(descriptor->mHash, descriptor));
+
+        return descriptor;
+    }
+
+    /**
+     * @brief The InternedName struct is an interned description with its UTF-8 name, found by findDescription().
+     */
+    struct InternedName
+    {
+        std::string utf8;
+        std::uint64_t hash;
+        const paco::String* description;
+    };
+
+    /**
+     * @brief The NameTable struct is an open addressing hash table of interned names with linear probing,
+     * at most half full. Slots are only ever filled, so readers need no lock.
+     */
+    struct NameTable
+    {
+        explicit NameTable(std::size_t size)
+            : mask(size - 1), count(0), slots(new std::atomic<const InternedName*>[size])
+        {
+            for(std::size_t i = 0; i < size; i++)
+            {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t mask;
+        std::size_t count;
+        std::unique_ptr<std::atomic<const InternedName*>[]> slots;
+    };
+
+    /**
+     * @brief insertName adds an interned name to the name table, called with mMutex locked.
+     * A full table is replaced by one of twice the size; the old table stays alive for readers still probing it.
+     */
+    void insertName(const InternedName* name)
+    {
+        NameTable* table = mNames.load(std::memory_order_relaxed);
+
+        if(2 * (table->count + 1) > table->mask + 1)
+        {
+            NameTable* grown = new NameTable(2 * (table->mask + 1));
+            mNameTables.push_back(std::unique_ptr<NameTable>(grown));
+
+            for(std::size_t i = 0; i < mNameStorage.size() - 1; i++)
+            {
+                insertName(grown, &mNameStorage[i]);
+            }
+
+            mNames.store(grown, std::memory_order_release);
+            table = grown;
+        }
+
+        insertName(table, name);
+    }
+
+    static void insertName(NameTable* table, const InternedName* name)
+    {
+        std::size_t i = name->hash & table->mask;
+
+        while(table->slots[i].load(std::memory_order_relaxed) != nullptr)
+        {
+            i = (i + 1) & table->mask;
+        }
+
+        table->slots[i].store(name, std::memory_order_release);
+        table->count++;
+    }
+
+private:
+
+    /**
+     * @brief mMutex guards registration and lookups by id, hash or description.
+     */
+    std::mutex mMutex;
+
+    /**
+     * @brief mDescriptors all registered descriptors, indexed by id.
+     */
+    std::vector<std::unique_ptr<PacketTypeDescriptor> > mDescriptors;
+
+    /**
+     * @brief mCodecs owns the registered codecs.
+     */
+    std::vector<std::shared_ptr<const paco::PacketCodec> > mCodecs;
+
+    /**
+     * @brief mHashes maps name hashes to descriptors.
+     */
+    std::map<std::uint64_t, const PacketTypeDescriptor*> mHashes;
+
+    /**
+     * @brief mUnspecified is the descriptor with id 0.
+     */
+    const PacketTypeDescriptor* mUnspecified;
+
+    /**
+     * @brief mDescriptionStorage owns the interned descriptions.
+     */
+    std::deque<paco::String> mDescriptionStorage;
+
+    /**
+     * @brief mDescriptions maps descriptions to their interned copy.
+     */
+    std::map<paco::String, const paco::String*> mDescriptions;
+
+    /**
+     * @brief mNameStorage owns the entries of the name tables, one per interned description.
+     */
+    std::deque<InternedName> mNameStorage;
+
+    /**
+     * @brief mNameTables owns the current name table and the ones it replaced.
+     */
+    std::vector<std::unique_ptr<NameTable> > mNameTables;
+
+    /**
+     * @brief mNames the current name table, read without a lock by findDescription().
+     */
+    std::atomic<NameTable*> mNames;
+};
+
+}
+
+#endif // PACKET_TYPE_REGISTRY_H
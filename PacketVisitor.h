@@ -0,0 +1,270 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACKET_VISITOR_H
+#define PACKET_VISITOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "PacketTypeRegistry.h"
+
+namespace paco
+{
+
+class Packet;
+
+template <typename T>
+class Packet_T;
+
+
+/**
+ * @brief The PacketVisitorTraits_T class extracts the argument type of a visitor handler.
+ * Handlers are lambdas, function objects or function pointers with exactly one parameter.
+ */
+template <class F>
+struct PacketVisitorTraits_T : PacketVisitorTraits_T<decltype(&F::operator())>
+{
+};
+
+template <class C, class R, class A>
+struct PacketVisitorTraits_T<R (C::*)(A) const>
+{
+    typedef typename std::decay<A>::type Argument;
+};
+
+template <class C, class R, class A>
+struct PacketVisitorTraits_T<R (C::*)(A)>
+{
+    typedef typename std::decay<A>::type Argument;
+};
+
+template <class R, class A>
+struct PacketVisitorTraits_T<R (*)(A)>
+{
+    typedef typename std::decay<A>::type Argument;
+};
+
+
+/**
+ * @brief The PacketVisitor_T class dispatches packets to a set of typed handlers.
+ *
+ * Every handler takes one parameter. A handler taking a T, T& or const T& is called for packets carrying a T.
+ * A handler taking a paco::Packet& or paco::Packet* is the fallback and is called for all other packets.
+ * If several handlers take the same type, the first one wins.
+ *
+ * The handler types are known at compile time, so the dispatch table that maps type ids to handlers is built
+ * once per set of handler types. Dispatching a packet is a single table lookup, independent of the number of handlers.
+ *
+ * Usually this class is not used directly but through Packet::visit() and Container::visit().
+ */
+template <class... Fs>
+class PacketVisitor_T
+{
+public:
+
+    /**
+     * @brief Handlers holds references to the handlers of one visit.
+     */
+    typedef std::tuple<Fs&...> Handlers;
+
+    /**
+     * @brief Thunk calls one handler with a packet.
+     */
+    typedef bool (*Thunk)(Handlers& handlers, paco::Packet* packet);
+
+    /**
+     * @brief PacketVisitor_T constructor.
+     * @param handlers the handlers, they have to outlive the visitor.
+     */
+    explicit PacketVisitor_T(Fs&... handlers)
+        : mHandlers(handlers...), mTable(table())
+    {
+    }
+
+    /**
+     * @brief visit calls the handler matching the type of a packet.
+     * @param typeId the type id of the packet, see Packet::typeId().
+     * @param packet the packet.
+     * @return true if a typed handler or the fallback has been called.
+     */
+    bool visit(paco::TypeId typeId, paco::Packet* packet)
+    {
+        Thunk thunk = (std::size_t)typeId < mTable.thunks.size() ? mTable.thunks[typeId] : mTable.fallback;
+        return thunk(mHandlers, packet);
+    }
+
+private:
+
+    /**
+     * @brief The Table struct is the dispatch table of one set of handler types.
+     */
+    struct Table
+    {
+        /**
+         * @brief thunks maps type ids to handlers, unmatched type ids map to the fallback.
+         */
+        std::vector<Thunk> thunks;
+
+        /**
+         * @brief fallback is called for type ids outside of thunks.
+         */
+        Thunk fallback;
+    };
+
+    /**
+     * @brief table returns the dispatch table of the handler types, built on first use.
+     * @return the dispatch table.
+     */
+    static const Table& table()
+    {
+        static const Table table = build();
+        return table;
+    }
+
+    /**
+     * @brief build creates the dispatch table.
+     * @return the dispatch table.
+     */
+    static Table build()
+    {
+        std::vector<paco::TypeId> typeIds;
+        std::vector<Thunk> thunks;
+        Table table;
+        table.fallback = &ignore;
+
+        collect(typeIds, thunks, table.fallback, std::integral_constant<std::size_t, 0>());
+
+        paco::TypeId maxTypeId = 0;
+        for(std::size_t i = 0; i < typeIds.size(); i++)
+        {
+            maxTypeId = std::max(maxTypeId, typeIds[i]);
+        }
+
+        table.thunks.assign(maxTypeId + 1, table.fallback);
+
+        // fill in reverse order, so that the first handler of a type wins
+        for(std::size_t i = typeIds.size(); i > 0; i--)
+        {
+            table.thunks[typeIds[i - 1]] = thunks[i - 1];
+        }
+
+        return table;
+    }
+
+    /**
+     * @brief collect terminates the recursion over the handlers.
+     */
+    static void collect(std::vector<paco::TypeId>&, std::vector<Thunk>&, Thunk&, std::integral_constant<std::size_t, sizeof...(Fs)>)
+    {
+    }
+
+    /**
+     * @brief collect registers handler I and recurses to the next handler.
+     */
+    template <std::size_t I>
+    static void collect(std::vector<paco::TypeId>& typeIds, std::vector<Thunk>& thunks, Thunk& fallback, std::integral_constant<std::size_t, I>)
+    {
+        typedef typename std::tuple_element<I, std::tuple<Fs...> >::type F;
+        typedef typename paco::PacketVisitorTraits_T<F>::Argument Argument;
+
+        add<I, Argument>(typeIds, thunks, fallback, std::integral_constant<bool, std::is_same<Argument, paco::Packet>::value
+                                                                               || std::is_same<Argument, paco::Packet*>::value>());
+
+        collect(typeIds, thunks, fallback, std::integral_constant<std::size_t, I + 1>());
+    }
+
+    /**
+     * @brief add registers handler I as fallback, unless there already is one.
+     */
+    template <std::size_t I, class Argument>
+    static void add(std::vector<paco::TypeId>&, std::vector<Thunk>&, Thunk& fallback, std::true_type)
+    {
+        if(fallback == &ignore)
+        {
+            fallback = &callFallback<I, Argument>;
+        }
+    }
+
+    /**
+     * @brief add registers handler I as handler for packets carrying an Argument.
+     */
+    template <std::size_t I, class Argument>
+    static void add(std::vector<paco::TypeId>& typeIds, std::vector<Thunk>& thunks, Thunk&, std::false_type)
+    {
+        typeIds.push_back(paco::PacketTypeRegistry::id<Argument>());
+        thunks.push_back(&callTyped<I, Argument>);
+    }
+
+    /**
+     * @brief callTyped calls handler I with the data of a packet carrying an Argument.
+     */
+    template <std::size_t I, class Argument>
+    static bool callTyped(Handlers& handlers, paco::Packet* packet)
+    {
+        std::get<I>(handlers)(static_cast<paco::Packet_T<Argument>*>(packet)->dataRef());
+        return true;
+    }
+
+    /**
+     * @brief callFallback calls the fallback handler I with the packet.
+     */
+    template <std::size_t I, class Argument>
+    static bool callFallback(Handlers& handlers, paco::Packet* packet)
+    {
+        invokeFallback(std::get<I>(handlers), packet, std::is_pointer<Argument>());
+        return true;
+    }
+
+    /**
+     * @brief invokeFallback calls a fallback handler taking a paco::Packet*.
+     */
+    template <class F>
+    static void invokeFallback(F& handler, paco::Packet* packet, std::true_type)
+    {
+        handler(packet);
+    }
+
+    /**
+     * @brief invokeFallback calls a fallback handler taking a paco::Packet&.
+     */
+    template <class F, class P>
+    static void invokeFallback(F& handler, P* packet, std::false_type)
+    {
+        handler(*packet);
+    }
+
+    /**
+     * @brief ignore is used for unmatched packets if there is no fallback handler.
+     */
+    static bool ignore(Handlers&, paco::Packet*)
+    {
+        return false;
+    }
+
+private:
+
+    /**
+     * @brief mHandlers the handlers of this visit.
+     */
+    Handlers mHandlers;
+
+    /**
+     * @brief mTable the dispatch table of the handler types.
+     */
+    const Table& mTable;
+};
+
+}
+
+#endif // PACKET_VISITOR_H
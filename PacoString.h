@@ -0,0 +1,80 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACO_STRING_H
+#define PACO_STRING_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#ifndef PACO_NO_QT
+    #include <QString>
+#endif
+
+namespace paco
+{
+
+#ifdef PACO_NO_QT
+
+/**
+ * @brief String is the string type of the paco API: std::string in the Qt-free build (PACO_NO_QT defined),
+ * QString otherwise. Type names and descriptions are converted to String once, when they are registered.
+ */
+typedef std::string String;
+
+/**
+ * @brief toStdString converts a String to UTF-8.
+ */
+inline std::string toStdString(const String& string)
+{
+    return string;
+}
+
+/**
+ * @brief fromUtf8 creates a String from UTF-8.
+ */
+inline String fromUtf8(std::string_view utf8)
+{
+    return std::string(utf8);
+}
+
+/**
+ * @brief isEmpty checks if a String is empty.
+ */
+inline bool isEmpty(const String& string)
+{
+    return string.empty();
+}
+
+#else
+
+typedef QString String;
+
+inline std::string toStdString(const String& string)
+{
+    return string.toStdString();
+}
+
+inline String fromUtf8(std::string_view utf8)
+{
+    return QString::fromUtf8(utf8.data(), (int)utf8.size());
+}
+
+inline bool isEmpty(const String& string)
+{
+    return string.isEmpty();
+}
+
+#endif
+
+}
+
+#endif // PACO_STRING_H
@@ -0,0 +1,610 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Container.h"
+#include "Packet.h"
+
+namespace paco
+{
+namespace parallel
+{
+
+/**
+ * @brief The ThreadPool class runs the parallel algorithms of paco::parallel with work stealing.
+ *
+ * Every worker owns a task deque. A parallel loop splits its range in halves, keeps working on the left half and
+ * pushes the right half onto the deque of the current thread, until a piece is no larger than the grain size.
+ * Workers take the newest task of their own deque and steal the oldest, i.e. largest, task of another deque when
+ * they run dry, so the work spreads without a central queue. The thread that starts a loop takes part in it and
+ * returns when the whole range is done, so loops may also be started from inside a loop.
+ *
+ * A pool with concurrency n starts n - 1 worker threads, the calling thread is the n-th.
+ */
+class ThreadPool
+{
+public:
+
+    /**
+     * @brief ThreadPool constructor, starts the worker threads.
+     * @param concurrency the number of threads working on a loop including the caller,
+     * 0 for std::thread::hardware_concurrency().
+     */
+    explicit ThreadPool(int concurrency = 0)
+        : mQueued(0), mStop(false)
+    {
+        if(concurrency <= 0)
+        {
+            concurrency = std::max(1, (int)std::thread::hardware_concurrency());
+        }
+
+        // one deque per worker plus a shared one for threads outside of the pool
+        for(int i = 0; i < concurrency; i++)
+        {
+            mQueues.push_back(std::unique_ptr<Queue>(new Queue()));
+        }
+
+        for(int i = 0; i < concurrency - 1; i++)
+        {
+            mWorkers.push_back(std::thread(&ThreadPool::work, this, i));
+        }
+    }
+
+    /**
+     * @brief ~ThreadPool destructor, waits for the worker threads to finish their tasks.
+     */
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mStop = true;
+        }
+
+        mWake.notify_all();
+
+        for(std::size_t i = 0; i < mWorkers.size(); i++)
+        {
+            mWorkers[i].join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief instance returns the process wide pool with one thread per hardware thread, started on first use.
+     * @return the process wide pool.
+     */
+    static ThreadPool& instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief concurrency returns the number of threads working on a loop, including the caller.
+     * @return the concurrency of the pool.
+     */
+    int concurrency() const
+    {
+        return mWorkers.size() + 1;
+    }
+
+    /**
+     * @brief forRange calls body(first, last) for pieces of [begin, end) that are at most grain long, in parallel,
+     * and returns when all pieces are done. The first exception thrown by body is rethrown after all pieces are done.
+     * @param begin the beginning of the range.
+     * @param end the end of the range.
+     * @param grain the largest piece, 0 to choose one that gives every thread about 8 pieces.
+     * @param body the function called for each piece.
+     */
+    template <class F>
+    void forRange(std::size_t begin, std::size_t end, std::size_t grain, const F& body)
+    {
+        if(begin >= end)
+        {
+            return;
+        }
+
+        if(grain == 0)
+        {
+            grain = std::max<std::size_t>(1, (end - begin) / (8 * concurrency()));
+        }
+
+        Loop_T<F> loop(body, grain, end - begin);
+
+        split(loop, begin, end);
+
+        while(loop.remaining.load(std::memory_order_acquire) != 0)
+        {
+            if(!runOne(queueIndex()))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if(loop.error)
+        {
+            std::rethrow_exception(loop.error);
+        }
+    }
+
+private:
+
+    /**
+     * @brief The Queue struct is the task deque of one worker.
+     */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    /**
+     * @brief The Loop_T struct is the state of one forRange call, it lives on the stack of the caller.
+     */
+    template <class F>
+    struct Loop_T
+    {
+        Loop_T(const F& body, std::size_t grain, std::size_t size)
+            : body(body), grain(grain), remaining(size)
+        {
+        }
+
+        const F& body;
+        std::size_t grain;
+
+        /**
+         * @brief remaining the number of elements not done yet, the caller returns when it reaches 0.
+         */
+        std::atomic<std::size_t> remaining;
+
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    /**
+     * @brief split pushes right halves of [begin, end) as tasks until the rest is at most one grain, then runs the rest.
+     * Decrementing remaining is the last access to the loop, the caller may return right afterwards.
+     */
+    template <class F>
+    void split(Loop_T<F>& loop, std::size_t begin, std::size_t end)
+    {
+        while(end - begin > loop.grain)
+        {
+            std::size_t middle = begin + (end - begin) / 2;
+            Loop_T<F>* pointer = &loop;
+
+            push([this, pointer, middle, end] { split(*pointer, middle, end); });
+
+            end = middle;
+        }
+
+        try
+        {
+            loop.body(begin, end);
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(loop.errorMutex);
+
+            if(!loop.error)
+            {
+                loop.error = std::current_exception();
+            }
+        }
+
+        loop.remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief queueIndex returns the deque of the current thread: its own for a worker, the last one for other threads.
+     */
+    int queueIndex() const
+    {
+        if(currentPool() == this)
+        {
+            return currentWorker();
+        }
+
+        return mQueues.size() - 1;
+    }
+
+    /**
+     * @brief push adds a task to the deque of the current thread and wakes a sleeping worker.
+     */
+    void push(std::function<void()> task)
+    {
+        Queue& queue = *mQueues[queueIndex()];
+
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        mQueued.fetch_add(1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+        }
+
+        mWake.notify_one();
+    }
+
+    /**
+     * @brief runOne runs the newest task of the own deque, or steals the oldest task of another deque.
+     * @param own the deque of the current thread.
+     * @return false if all deques were empty.
+     */
+    bool runOne(int own)
+    {
+        std::function<void()> task;
+        const int count = mQueues.size();
+
+        for(int i = 0; i < count && !task; i++)
+        {
+            Queue& queue = *mQueues[(own + i) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if(!queue.tasks.empty())
+            {
+                if(i == 0)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+            }
+        }
+
+        if(!task)
+        {
+            return false;
+        }
+
+        mQueued.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+
+        return true;
+    }
+
+    /**
+     * @brief work is the loop of a worker thread.
+     */
+    void work(int index)
+    {
+        currentPool() = this;
+        currentWorker() = index;
+
+        while(true)
+        {
+            if(runOne(index))
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mWake.wait(lock, [this] { return mStop || mQueued.load(std::memory_order_acquire) > 0; });
+
+            if(mStop && mQueued.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief currentPool is the pool the current thread works for, or nullptr.
+     */
+    static const ThreadPool*& currentPool()
+    {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    /**
+     * @brief currentWorker is the index of the current worker thread in its pool.
+     */
+    static int& currentWorker()
+    {
+        static thread_local int worker = -1;
+        return worker;
+    }
+
+private:
+
+    /**
+     * @brief mQueues the task deques, one per worker and a last one for threads outside of the pool.
+     */
+    std::vector<std::unique_ptr<Queue> > mQueues;
+
+    /**
+     * @brief mWorkers the worker threads.
+     */
+    std::vector<std::thread> mWorkers;
+
+    /**
+     * @brief mQueued the number of tasks in all deques.
+     */
+    std::atomic<int> mQueued;
+
+    /**
+     * @brief mSleepMutex and mWake let idle workers sleep until a task is pushed.
+     */
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+
+    /**
+     * @brief mStop is set by the destructor.
+     */
+    bool mStop;
+};
+
+
+/**
+ * @brief The Options struct tunes a parallel algorithm.
+ */
+struct Options
+{
+    Options(std::size_t grain = 0, paco::parallel::ThreadPool* pool = nullptr)
+        : grain(grain), pool(pool)
+    {
+    }
+
+    /**
+     * @brief grain the largest number of elements handled as one task, 0 to choose automatically.
+     * Choose a larger grain when the work per element is small.
+     */
+    std::size_t grain;
+
+    /**
+     * @brief pool the pool to run on, nullptr for ThreadPool::instance().
+     */
+    paco::parallel::ThreadPool* pool;
+
+    paco::parallel::ThreadPool& threadPool() const
+    {
+        return pool != nullptr ? *pool : paco::parallel::ThreadPool::instance();
+    }
+};
+
+/**
+ * @brief forIndex calls f(i) for every i in [0, n) in parallel.
+ * @param n the number of indices.
+ * @param f the function.
+ * @param options the grain size and pool.
+ */
+template <class F>
+void forIndex(std::size_t n, F f, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    options.threadPool().forRange(0, n, options.grain, [&f](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first; i < last; i++)
+        {
+            f(i);
+        }
+    });
+}
+
+/**
+ * @brief reduceIndex computes combine(... combine(combine(identity, map(0)), map(1)) ..., map(n - 1)) in parallel.
+ * The indices are reduced in pieces of the grain size, which are combined in order, so combine only has to be
+ * associative, not commutative.
+ */
+template <class R, class Map, class Combine>
+R reduceIndex(std::size_t n, R identity, Map map, Combine combine, const paco::parallel::Options& options)
+{
+    paco::parallel::ThreadPool& pool = options.threadPool();
+    std::size_t grain = options.grain;
+
+    if(grain == 0)
+    {
+        grain = std::max<std::size_t>(1, n / (8 * pool.concurrency()));
+    }
+
+    std::size_t pieces = (n + grain - 1) / grain;
+    std::vector<R> partials(pieces, identity);
+
+    pool.forRange(0, pieces, 1, [&](std::size_t first, std::size_t last)
+    {
+        for(std::size_t piece = first; piece < last; piece++)
+        {
+            R partial = identity;
+
+            for(std::size_t i = piece * grain; i < std::min(n, (piece + 1) * grain); i++)
+            {
+                partial = combine(std::move(partial), map(i));
+            }
+
+            partials[piece] = std::move(partial);
+        }
+    });
+
+    R result = identity;
+
+    for(std::size_t piece = 0; piece < pieces; piece++)
+    {
+        result = combine(std::move(result), std::move(partials[piece]));
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief for_each calls f(packet) for every object of a container in parallel.
+ * The container must not be modified until for_each returns, f may modify the objects.
+ * @param container the container.
+ * @param f a function taking a paco::Packet&.
+ * @param options the grain size and pool.
+ */
+template <class F>
+void for_each(paco::Container& container, F f, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    paco::parallel::forIndex(container.size(), [&](std::size_t i) { f(*container.at(i)); }, options);
+}
+
+/**
+ * @brief for_each<T> calls f(object) for every object of type T of a container in parallel, see Container::range<T>().
+ * @param container the container.
+ * @param f a function taking a T&.
+ * @param options the grain size and pool.
+ */
+template <class T, class F>
+void for_each(paco::Container& container, F f, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    paco::TypedRange_T<T> range = container.range<T>();
+
+    paco::parallel::forIndex(range.size(), [&](std::size_t i) { f(range[i]); }, options);
+}
+
+/**
+ * @brief for_each calls f(element) for every element of a random access range, e.g. a std::vector<paco::Container>.
+ * @param first the first element.
+ * @param last the end of the range.
+ * @param f a function taking a reference to an element.
+ * @param options the grain size and pool.
+ */
+template <class Iterator, class F>
+void for_each(Iterator first, Iterator last, F f, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    paco::parallel::forIndex(last - first, [&](std::size_t i) { f(first[i]); }, options);
+}
+
+/**
+ * @brief transform calls f(packet) for every object of a container in parallel.
+ * @param container the container.
+ * @param f a function taking a const paco::Packet&.
+ * @param options the grain size and pool.
+ * @return the results in the order of the objects, the result type must be default constructible.
+ */
+template <class F>
+auto transform(const paco::Container& container, F f, const paco::parallel::Options& options = paco::parallel::Options())
+    -> std::vector<typename std::decay<decltype(f(std::declval<const paco::Packet&>()))>::type>
+{
+    std::vector<typename std::decay<decltype(f(std::declval<const paco::Packet&>()))>::type> results(container.size());
+
+    paco::parallel::forIndex(results.size(), [&](std::size_t i) { results[i] = f(*container.at(i)); }, options);
+
+    return results;
+}
+
+/**
+ * @brief transform<T> calls f(object) for every object of type T of a container in parallel.
+ * @param container the container.
+ * @param f a function taking a const T&.
+ * @param options the grain size and pool.
+ * @return the results in the order of the objects, the result type must be default constructible.
+ */
+template <class T, class F>
+auto transform(const paco::Container& container, F f, const paco::parallel::Options& options = paco::parallel::Options())
+    -> std::vector<typename std::decay<decltype(f(std::declval<const T&>()))>::type>
+{
+    paco::TypedRange_T<const T> range = container.range<T>();
+    std::vector<typename std::decay<decltype(f(std::declval<const T&>()))>::type> results(range.size());
+
+    paco::parallel::forIndex(results.size(), [&](std::size_t i) { results[i] = f(range[i]); }, options);
+
+    return results;
+}
+
+/**
+ * @brief transform calls f(element) for every element of a random access range in parallel.
+ * @param first the first element.
+ * @param last the end of the range.
+ * @param f a function taking a reference to an element.
+ * @param options the grain size and pool.
+ * @return the results in order, the result type must be default constructible.
+ */
+template <class Iterator, class F>
+auto transform(Iterator first, Iterator last, F f, const paco::parallel::Options& options = paco::parallel::Options())
+    -> std::vector<typename std::decay<decltype(f(*first))>::type>
+{
+    std::vector<typename std::decay<decltype(f(*first))>::type> results(last - first);
+
+    paco::parallel::forIndex(results.size(), [&](std::size_t i) { results[i] = f(first[i]); }, options);
+
+    return results;
+}
+
+/**
+ * @brief reduce maps every object of a container and combines the results in parallel.
+ * Map is the first template parameter, so reduce<T>(...) always selects the typed overload below.
+ * @param container the container.
+ * @param identity the neutral element of combine.
+ * @param map a function taking a const paco::Packet& and returning an R.
+ * @param combine an associative function combining two Rs.
+ * @param options the grain size and pool.
+ * @return the combined result, identity for an empty container.
+ */
+template <class Map, class R, class Combine>
+R reduce(const paco::Container& container, R identity, Map map, Combine combine, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    return paco::parallel::reduceIndex(container.size(), std::move(identity), [&](std::size_t i) { return map(*container.at(i)); }, combine, options);
+}
+
+/**
+ * @brief reduce<T> maps every object of type T of a container and combines the results in parallel.
+ * @param container the container.
+ * @param identity the neutral element of combine.
+ * @param map a function taking a const T& and returning an R.
+ * @param combine an associative function combining two Rs.
+ * @param options the grain size and pool.
+ * @return the combined result, identity for a container without T.
+ */
+template <class T, class R, class Map, class Combine>
+R reduce(const paco::Container& container, R identity, Map map, Combine combine, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    paco::TypedRange_T<const T> range = container.range<T>();
+
+    return paco::parallel::reduceIndex(range.size(), std::move(identity), [&](std::size_t i) { return map(range[i]); }, combine, options);
+}
+
+/**
+ * @brief reduce maps every element of a random access range and combines the results in parallel.
+ * @param first the first element.
+ * @param last the end of the range.
+ * @param identity the neutral element of combine.
+ * @param map a function taking a reference to an element and returning an R.
+ * @param combine an associative function combining two Rs.
+ * @param options the grain size and pool.
+ * @return the combined result, identity for an empty range.
+ */
+template <class Iterator, class R, class Map, class Combine>
+R reduce(Iterator first, Iterator last, R identity, Map map, Combine combine, const paco::parallel::Options& options = paco::parallel::Options())
+{
+    return paco::parallel::reduceIndex(last - first, std::move(identity), [&](std::size_t i) { return map(first[i]); }, combine, options);
+}
+
+}
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,707 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#include "Container.h"
+#include "ContainerChannel.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The StageStatistics struct is a snapshot of the counters of one pipeline stage, see Pipeline::statistics().
+ */
+struct StageStatistics
+{
+    /**
+     * @brief name the name of the stage.
+     */
+    std::string name;
+
+    /**
+     * @brief workers the number of threads running the stage.
+     */
+    int workers;
+
+    /**
+     * @brief processed the number of containers processed by the stage.
+     */
+    std::uint64_t processed;
+
+    /**
+     * @brief batches the number of batches the containers were popped in.
+     */
+    std::uint64_t batches;
+
+    /**
+     * @brief throughput processed containers per second since the pipeline was started.
+     */
+    double throughput;
+
+    /**
+     * @brief queueDepth the number of containers waiting in the input queue of the stage.
+     */
+    std::size_t queueDepth;
+
+    /**
+     * @brief queueCapacity the capacity of the input queue of the stage.
+     */
+    std::size_t queueCapacity;
+};
+
+
+/**
+ * @brief The Pipeline class runs containers through a graph of stages.
+ *
+ * Every stage declares the Specification of the containers it accepts and of the containers it produces,
+ * and processes one container at a time in place. Stages are connected to a graph in which each stage passes
+ * its output to one downstream stage, and any number of stages may feed the same stage:
+ *
+ *  paco::Pipeline pipeline;
+ *  int decode = pipeline.addStage("decode", raw, decoded, [](paco::Container& c) { ... });
+ *  int filter = pipeline.addStage("filter", decoded, decoded, [](paco::Container& c) { ... }, 4);
+ *  int store = pipeline.addSink("store", decoded, [](paco::Container& c) { ... });
+ *  pipeline.connect(decode, filter);
+ *  pipeline.connect(filter, store);
+ *  pipeline.start();
+ *
+ *  pipeline.push(decode, container); // checked against the input specification of decode
+ *  ...
+ *  pipeline.close();
+ *  pipeline.wait();
+ *
+ * start() validates the graph once: the output specification of every stage must equal the input specification of
+ * its downstream stage, and the graph must not contain cycles. Afterwards only containers pushed into the pipeline
+ * are checked, which is a single fingerprint compare, and the stages trust their input without per message checks.
+ * A stage must therefore produce containers that match its declared output specification.
+ *
+ * Every stage runs on its own worker threads, so all stages run concurrently. Stages are connected by bounded
+ * MpmcContainerChannels: a stage blocks when the queue of its downstream stage is full, which propagates
+ * backpressure up to push(). Workers pop and push containers in batches of up to batchSize.
+ *
+ * Containers leaving a stage without downstream stage are collected in the output queue, see pop(), except for sinks,
+ * whose containers are recycled. An exception thrown by a stage is kept, the container is dropped and the first
+ * exception is rethrown by wait().
+ */
+class Pipeline
+{
+public:
+
+    /**
+     * @brief StageFunction processes one container in place.
+     */
+    typedef std::function<void(paco::Container&)> StageFunction;
+
+    /**
+     * @brief Pipeline constructor.
+     * @param queueCapacity the capacity of the queue in front of every stage and of the output queue.
+     * @param batchSize the maximum number of containers a worker pops and pushes at once.
+     */
+    explicit Pipeline(std::size_t queueCapacity = 1024, std::size_t batchSize = 32)
+        : mQueueCapacity(queueCapacity),
+          mBatchSize(batchSize > 0 ? batchSize : 1),
+          mOutput(queueCapacity),
+          mOutputProducers(0),
+          mStarted(false),
+          mClosed(false)
+    {
+    }
+
+    /**
+     * @brief ~Pipeline destructor, closes the pipeline, drops unread output and waits for all stages.
+     */
+    ~Pipeline()
+    {
+        close();
+
+        if(mStarted)
+        {
+            // unblock stages that wait for space in the output queue
+            while(!allWorkersDone())
+            {
+                paco::Container* container = nullptr;
+
+                if(mOutput.tryPop(container))
+                {
+                    mOutput.recycle(container);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        joinWorkers();
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /**
+     * @brief addStage adds a stage that passes its output on.
+     * @param name the name of the stage, used in errors and statistics.
+     * @param input the specification of the containers the stage accepts.
+     * @param output the specification of the containers the stage produces.
+     * @param function the function processing a container in place.
+     * @param workers the number of threads running the stage.
+     * @return the id of the stage.
+     */
+    int addStage(const std::string& name, const paco::Specification& input, const paco::Specification& output,
+                 StageFunction function, int workers = 1)
+    {
+        return add(name, input, output, std::move(function), workers, false);
+    }
+
+    /**
+     * @brief addSink adds a stage that consumes containers. Processed containers are recycled.
+     * @param name the name of the stage, used in errors and statistics.
+     * @param input the specification of the containers the stage accepts.
+     * @param function the function consuming a container.
+     * @param workers the number of threads running the stage.
+     * @return the id of the stage.
+     */
+    int addSink(const std::string& name, const paco::Specification& input, StageFunction function, int workers = 1)
+    {
+        return add(name, input, paco::Specification(), std::move(function), workers, true);
+    }
+
+    /**
+     * @brief connect passes the output of one stage to another stage.
+     * Throws std::out_of_range for unknown stages and std::logic_error if the pipeline has been started,
+     * from is a sink or from already has a downstream stage.
+     * @param from the id of the upstream stage.
+     * @param to the id of the downstream stage.
+     */
+    void connect(int from, int to)
+    {
+        checkNotStarted();
+
+        Stage& upstream = stage(from);
+        stage(to);
+
+        if(upstream.sink)
+        {
+            throw std::logic_error("paco::Pipeline: the sink '" + upstream.name + "' has no output to connect");
+        }
+
+        if(upstream.downstream >= 0)
+        {
+            throw std::logic_error("paco::Pipeline: the stage '" + upstream.name + "' is already connected");
+        }
+
+        upstream.downstream = to;
+    }
+
+    /**
+     * @brief start validates the graph and starts the worker threads of all stages.
+     * Throws std::logic_error if the specifications of two connected stages do not match or the graph has a cycle.
+     */
+    void start()
+    {
+        checkNotStarted();
+
+        if(mClosed.load())
+        {
+            throw std::logic_error("paco::Pipeline: the pipeline has been closed");
+        }
+
+        validate();
+
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            Stage& stage = *mStages[i];
+
+            if(stage.downstream >= 0)
+            {
+                mStages[stage.downstream]->producers += stage.workers;
+            }
+            else if(!stage.sink)
+            {
+                mOutputProducers += stage.workers;
+            }
+        }
+
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            Stage& stage = *mStages[i];
+            stage.entry = stage.producers.load() == 0;
+
+            if(stage.entry)
+            {
+                // the caller of push() is the producer of an entry stage until close()
+                stage.producers = 1;
+            }
+        }
+
+        if(mOutputProducers.load() == 0)
+        {
+            mOutput.close();
+        }
+
+        mStartTime = std::chrono::steady_clock::now();
+        mStarted = true;
+
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            for(int w = 0; w < mStages[i]->workers; w++)
+            {
+                mStages[i]->threads.push_back(std::thread(&Pipeline::work, this, (int)i));
+            }
+        }
+    }
+
+    /**
+     * @brief acquire returns an empty container for push(), recycled if possible.
+     * @return an empty container owned by the caller.
+     */
+    paco::Container* acquire()
+    {
+        return mOutput.acquire();
+    }
+
+    /**
+     * @brief recycle hands a container returned by pop() back for reuse.
+     * @param container a container owned by the caller.
+     */
+    void recycle(paco::Container* container)
+    {
+        mOutput.recycle(container);
+    }
+
+    /**
+     * @brief push pushes a container into an entry stage, i.e. a stage without upstream stages,
+     * and waits while the queue of the stage is full.
+     * Throws std::bad_cast if the container does not match the input specification of the stage,
+     * and std::logic_error if the stage is not an entry stage or the pipeline is not running.
+     * @param stage the id of the entry stage.
+     * @param container the container, owned by the pipeline on success.
+     * @return false if the pipeline has been closed, the container is still owned by the caller then.
+     */
+    bool push(int stage, paco::Container* container)
+    {
+        Stage& entry = checkedEntry(stage);
+
+        if(!container->matches(entry.input))
+        {
+            throw std::bad_cast();
+        }
+
+        return entry.channel->push(container);
+    }
+
+    /**
+     * @brief pop pops a container that left the graph and waits for one.
+     * @param container receives the container, owned by the caller.
+     * @return false if all stages are done and the output queue is empty.
+     */
+    bool pop(paco::Container*& container)
+    {
+        return mOutput.pop(container);
+    }
+
+    /**
+     * @brief popBatch pops up to count containers that left the graph and waits until there is at least one.
+     * @param containers receives the containers, owned by the caller.
+     * @param count the maximum number of containers.
+     * @return the number of popped containers, 0 only if all stages are done and the output queue is empty.
+     */
+    std::size_t popBatch(paco::Container** containers, std::size_t count)
+    {
+        return mOutput.popBatch(containers, count);
+    }
+
+    /**
+     * @brief close ends the input of the pipeline. The stages process the queued containers and finish.
+     */
+    void close()
+    {
+        if(mClosed.exchange(true))
+        {
+            return;
+        }
+
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            if(mStarted && mStages[i]->entry)
+            {
+                release(*mStages[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief wait closes the pipeline and waits until all stages are done.
+     * Containers in the output queue stay there, so it must be drained concurrently with pop() if more containers
+     * than its capacity leave the graph. The first exception thrown by a stage is rethrown.
+     */
+    void wait()
+    {
+        close();
+        joinWorkers();
+
+        std::lock_guard<std::mutex> lock(mErrorMutex);
+
+        if(mError)
+        {
+            std::exception_ptr error = mError;
+            mError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief statistics returns the counters and queue depths of all stages, in the order they have been added.
+     * @return the statistics of all stages.
+     */
+    std::vector<paco::StageStatistics> statistics() const
+    {
+        std::vector<paco::StageStatistics> statistics;
+        double seconds = mStarted ? std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count() : 0.0;
+
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            const Stage& stage = *mStages[i];
+
+            paco::StageStatistics entry;
+            entry.name = stage.name;
+            entry.workers = stage.workers;
+            entry.processed = stage.processed.load(std::memory_order_relaxed);
+            entry.batches = stage.batches.load(std::memory_order_relaxed);
+            entry.throughput = seconds > 0.0 ? entry.processed / seconds : 0.0;
+            entry.queueDepth = stage.channel->size();
+            entry.queueCapacity = stage.channel->capacity();
+
+            statistics.push_back(entry);
+        }
+
+        return statistics;
+    }
+
+    /**
+     * @brief outputDepth returns the number of containers waiting in the output queue.
+     * @return the number of containers in the output queue.
+     */
+    std::size_t outputDepth() const
+    {
+        return mOutput.size();
+    }
+
+private:
+
+    /**
+     * @brief The Stage struct is one node of the graph.
+     */
+    struct Stage
+    {
+        Stage(std::size_t queueCapacity)
+            : channel(new paco::MpmcContainerChannel(queueCapacity)),
+              workers(1), sink(false), entry(false), downstream(-1),
+              producers(0), running(0), processed(0), batches(0)
+        {
+        }
+
+        std::string name;
+        paco::Specification input;
+        paco::Specification output;
+        StageFunction function;
+
+        /**
+         * @brief channel the input queue of the stage.
+         */
+        std::unique_ptr<paco::MpmcContainerChannel> channel;
+
+        int workers;
+        bool sink;
+
+        /**
+         * @brief entry true if no stage feeds this stage, containers are pushed with Pipeline::push().
+         */
+        bool entry;
+
+        /**
+         * @brief downstream the id of the downstream stage, or -1.
+         */
+        int downstream;
+
+        /**
+         * @brief producers the number of threads that may still push into channel, it is closed when this reaches 0.
+         */
+        std::atomic<int> producers;
+
+        /**
+         * @brief running the number of workers of this stage that have not finished yet.
+         */
+        std::atomic<int> running;
+
+        std::atomic<std::uint64_t> processed;
+        std::atomic<std::uint64_t> batches;
+
+        std::vector<std::thread> threads;
+    };
+
+    /**
+     * @brief add creates a stage.
+     */
+    int add(const std::string& name, const paco::Specification& input, const paco::Specification& output,
+            StageFunction function, int workers, bool sink)
+    {
+        checkNotStarted();
+
+        std::unique_ptr<Stage> stage(new Stage(mQueueCapacity));
+        stage->name = name;
+        stage->input = input;
+        stage->output = output;
+        stage->function = std::move(function);
+        stage->workers = workers > 0 ? workers : 1;
+        stage->running = stage->workers;
+        stage->sink = sink;
+
+        mStages.push_back(std::move(stage));
+
+        return mStages.size() - 1;
+    }
+
+    /**
+     * @brief validate checks the specifications of all connections and that there are no cycles.
+     */
+    void validate() const
+    {
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            const Stage& stage = *mStages[i];
+
+            if(stage.downstream >= 0 && stage.output != mStages[stage.downstream]->input)
+            {
+                throw std::logic_error("paco::Pipeline: the output of '" + stage.name + "' does not match the input of '"
+                                       + mStages[stage.downstream]->name + "'");
+            }
+
+            // every stage has at most one downstream stage, so a cycle is found by following the chain
+            int next = stage.downstream;
+
+            for(std::size_t steps = 0; next >= 0; steps++)
+            {
+                if(next == (int)i || steps > mStages.size())
+                {
+                    throw std::logic_error("paco::Pipeline: the stage '" + stage.name + "' is part of a cycle");
+                }
+
+                next = mStages[next]->downstream;
+            }
+        }
+    }
+
+    /**
+     * @brief work is the loop of a worker thread of a stage.
+     */
+    void work(int index)
+    {
+        Stage& stage = *mStages[index];
+        std::vector<paco::Container*> batch(mBatchSize);
+        std::vector<paco::Container*> passed(mBatchSize);
+
+        std::size_t count;
+        while((count = stage.channel->popBatch(batch.data(), batch.size())) > 0)
+        {
+            std::size_t passing = 0;
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                try
+                {
+                    stage.function(*batch[i]);
+                    passed[passing++] = batch[i];
+                }
+                catch(...)
+                {
+                    fail();
+                    mOutput.recycle(batch[i]);
+                }
+            }
+
+            stage.processed.fetch_add(count, std::memory_order_relaxed);
+            stage.batches.fetch_add(1, std::memory_order_relaxed);
+
+            if(stage.sink)
+            {
+                for(std::size_t i = 0; i < passing; i++)
+                {
+                    mOutput.recycle(passed[i]);
+                }
+            }
+            else
+            {
+                paco::MpmcContainerChannel& next = stage.downstream >= 0 ? *mStages[stage.downstream]->channel : mOutput;
+                std::size_t pushed = next.pushBatch(passed.data(), passing);
+
+                for(std::size_t i = pushed; i < passing; i++)
+                {
+                    mOutput.recycle(passed[i]);
+                }
+            }
+        }
+
+        if(!stage.sink)
+        {
+            if(stage.downstream >= 0)
+            {
+                release(*mStages[stage.downstream]);
+            }
+            else if(mOutputProducers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                mOutput.close();
+            }
+        }
+
+        stage.running.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief release removes one producer of a stage and closes its queue after the last one.
+     */
+    static void release(Stage& stage)
+    {
+        if(stage.producers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            stage.channel->close();
+        }
+    }
+
+    /**
+     * @brief fail keeps the first exception thrown by a stage.
+     */
+    void fail()
+    {
+        std::lock_guard<std::mutex> lock(mErrorMutex);
+
+        if(!mError)
+        {
+            mError = std::current_exception();
+        }
+    }
+
+    /**
+     * @brief allWorkersDone checks if all workers of all stages have finished.
+     */
+    bool allWorkersDone() const
+    {
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            if(mStages[i]->running.load(std::memory_order_acquire) > 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief joinWorkers joins all worker threads.
+     */
+    void joinWorkers()
+    {
+        for(std::size_t i = 0; i < mStages.size(); i++)
+        {
+            for(std::size_t t = 0; t < mStages[i]->threads.size(); t++)
+            {
+                if(mStages[i]->threads[t].joinable())
+                {
+                    mStages[i]->threads[t].join();
+                }
+            }
+        }
+    }
+
+    Stage& stage(int id)
+    {
+        if(id < 0 || id >= (int)mStages.size())
+        {
+            throw std::out_of_range("paco::Pipeline: unknown stage");
+        }
+
+        return *mStages[id];
+    }
+
+    Stage& checkedEntry(int id)
+    {
+        Stage& entry = stage(id);
+
+        if(!mStarted || mClosed.load())
+        {
+            throw std::logic_error("paco::Pipeline: the pipeline is not running");
+        }
+
+        if(!entry.entry)
+        {
+            throw std::logic_error("paco::Pipeline: '" + entry.name + "' is fed by other stages");
+        }
+
+        return entry;
+    }
+
+    void checkNotStarted() const
+    {
+        if(mStarted)
+        {
+            throw std::logic_error("paco::Pipeline: the pipeline has already been started");
+        }
+    }
+
+private:
+
+    /**
+     * @brief mStages the stages, indexed by id.
+     */
+    std::vector<std::unique_ptr<Stage> > mStages;
+
+    std::size_t mQueueCapacity;
+    std::size_t mBatchSize;
+
+    /**
+     * @brief mOutput the containers that left the graph, also the pool of acquire() and recycle().
+     */
+    paco::MpmcContainerChannel mOutput;
+
+    /**
+     * @brief mOutputProducers the number of workers that may still push into mOutput.
+     */
+    std::atomic<int> mOutputProducers;
+
+    bool mStarted;
+    std::atomic<bool> mClosed;
+
+    std::chrono::steady_clock::time_point mStartTime;
+
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;
+};
+
+}
+
+#endif // PIPELINE_H
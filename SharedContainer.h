@@ -0,0 +1,319 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SHARED_CONTAINER_H
+#define SHARED_CONTAINER_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Container.h"
+#include "Instrumentation.h"
+#include "Packet.h"
+#include "PacketType.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief SharedPacket is a reference counted immutable packet. Copying it only increments the reference count.
+ */
+typedef std::shared_ptr<const paco::Packet> SharedPacket;
+
+/**
+ * @brief makeSharedPacket creates a shared packet of type T, constructing its data in place with a single allocation.
+ * @param args the constructor arguments of the data of the packet.
+ * @return the shared packet.
+ */
+template <class T, class... Args>
+SharedPacket makeSharedPacket(Args&&... args)
+{
+    paco::Instrumentation::countAllocation(paco::PacketTypeRegistry::descriptor<T>(), sizeof(paco::Packet_T<T>));
+    return std::make_shared<const paco::Packet_T<T> >(std::forward<Args>(args)...);
+}
+
+
+/**
+ * @brief The SharedContainer class is a copy-on-write handle to a list of shared immutable packets.
+ *
+ * Copying a SharedContainer costs a single reference count increment, so one container can be fanned out
+ * to many consumers without copying its objects. All copies see the same packets until one of them is modified:
+ * the modified copy then detaches by copying the list of packet pointers, and only the changed slots receive
+ * new packets. The objects of the unchanged slots stay shared, no object is ever deep copied.
+ *
+ * The objects can only be read through a SharedContainer, use replace() to change one.
+ * A SharedContainer is created from a Container by moving its packets, see SharedContainer(Container&&).
+ *
+ * Like std::shared_ptr, different SharedContainer instances may be used from different threads at the same time,
+ * while a single instance must not be modified concurrently.
+ */
+class SharedContainer
+{
+private:
+
+    /**
+     * template_type_must_be_specified_when_calling_append is a helper to force the programmer
+     * to use angle brackets <type> in append<type>(value). If not specified the compiler will not be able to compile.
+     */
+    template <typename T>
+    struct template_type_must_be_specified_when_calling_append
+    {
+        using type = T;
+    };
+
+    /**
+     * @brief The Data struct is the state shared between the copies of a SharedContainer.
+     */
+    struct Data
+    {
+        std::vector<paco::SharedPacket> packets;
+        paco::Specification specification;
+    };
+
+public:
+
+    /**
+     * @brief SharedContainer default constructor, creates an empty container.
+     */
+    SharedContainer()
+        : mData(std::make_shared<Data>())
+    {
+    }
+
+    /**
+     * @brief SharedContainer moves all packets of a container into a new shared container.
+     * Packets stored inline in the container are moved to the heap, heap packets are taken over without a copy.
+     * @param container the container to move from, empty afterwards.
+     */
+    explicit SharedContainer(paco::Container&& container)
+        : mData(std::make_shared<Data>())
+    {
+        mData->packets.reserve(container.mSlots.size());
+
+        for(std::size_t i = 0; i < container.mSlots.size(); i++)
+        {
+            mData->packets.push_back(paco::SharedPacket(container.mSlots[i].release()));
+        }
+
+        mData->specification = container.mSpecification;
+        container.clear();
+    }
+
+    /**
+     * @brief size
+     * @return the number of elements in the container.
+     */
+    int size() const
+    {
+        return mData->packets.size();
+    }
+
+    /**
+     * @brief append appends an object wrapped into a new shared packet.
+     * Pass an rvalue to move the object into the container.
+     */
+    template <class T>
+    void append(typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        append(paco::makeSharedPacket<T>(std::move(value)));
+    }
+
+    /**
+     * @brief append appends a shared packet, e.g. one taken from another shared container with packet().
+     * @param packet the shared packet.
+     */
+    void append(paco::SharedPacket packet)
+    {
+        detach();
+
+        paco::PacketType packetType = packet->packetType();
+        mData->packets.push_back(std::move(packet));
+        mData->specification.append_friend_class_only(packetType);
+    }
+
+    /**
+     * @brief insert inserts an object wrapped into a new shared packet at a certain index position.
+     * @param index the desired index.
+     */
+    template <class T>
+    void insert(int index, typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        paco::SharedPacket packet = paco::makeSharedPacket<T>(std::move(value));
+
+        detach();
+
+        mData->packets.insert(mData->packets.begin() + index, packet);
+        mData->specification.insert_friend_class_only(index, packet->packetType());
+    }
+
+    /**
+     * @brief replace replaces the object at a certain index position. Only this slot is detached from the other copies.
+     * @param index the index of the object that has to be replaced.
+     */
+    template <class T>
+    void replace(int index, T value)
+    {
+        replace(index, paco::makeSharedPacket<T>(std::move(value)));
+    }
+
+    /**
+     * @brief replace replaces the packet at a certain index position with a shared packet.
+     * @param index the index of the packet that has to be replaced.
+     * @param packet the shared packet.
+     */
+    void replace(int index, paco::SharedPacket packet)
+    {
+        detach();
+
+        paco::PacketType packetType = packet->packetType();
+        mData->packets.at(index) = std::move(packet);
+        mData->specification.replace_friend_class_only(index, packetType);
+    }
+
+    /**
+     * @brief removeAt removes an object at a certain index position.
+     * The object itself is destroyed when the last shared container referencing it releases it.
+     * @param index the index of the object that has to be removed.
+     */
+    void removeAt(int index)
+    {
+        if(index >= 0 && index < size())
+        {
+            detach();
+
+            mData->packets.erase(mData->packets.begin() + index);
+            mData->specification.removeAt(index);
+        }
+    }
+
+    /**
+     * @brief clear removes all objects, without touching the other copies.
+     */
+    void clear()
+    {
+        mData = std::make_shared<Data>();
+    }
+
+    /**
+     * @brief at
+     * @param index the index of the package with the object.
+     * @return returns the immutable package carrying the object at position i.
+     */
+    const paco::Packet* at(int index) const
+    {
+        return mData->packets.at(index).get();
+    }
+
+    /**
+     * @brief packet returns the shared packet at a certain index position, e.g. to append it to another shared container.
+     * @param index the index of the packet.
+     * @return the shared packet.
+     */
+    paco::SharedPacket packet(int index) const
+    {
+        return mData->packets.at(index);
+    }
+
+    /**
+     * @brief get<T> returns a const reference to the object at a certain index position.
+     * @param index the index of the object.
+     * @return a const reference to the object. If T and the object do not match then a std::bad_cast is thrown.
+     */
+    template <class T>
+    const T& get(int index) const
+    {
+        return at(index)->get_cref<T>();
+    }
+
+    /**
+     * @brief get_if returns a pointer to the object at a certain index position if it has type T.
+     * @param index the index of the object.
+     * @return a pointer to the object, or nullptr if the index is out of range or the object is not a T.
+     */
+    template <class T>
+    const T* get_if(int index) const
+    {
+        if(index >= 0 && index < size())
+        {
+            return mData->packets[index]->get_if<T>();
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief specification returns the specification of the objects of this container without copying it.
+     * @return the current specification of the container, valid until the container is modified.
+     */
+    const paco::Specification& specification() const
+    {
+        return mData->specification;
+    }
+
+    /**
+     * @brief getSpecification returns a specification of the objects of this container.
+     * @return the current specification of the container.
+     */
+    paco::Specification getSpecification() const
+    {
+        return mData->specification;
+    }
+
+    /**
+     * @brief matches checks if the objects of this container match an expected specification.
+     * @param specification the expected specification.
+     * @return true if the container matches the specification.
+     */
+    bool matches(const paco::Specification& specification) const
+    {
+        return mData->specification.equals(specification);
+    }
+
+    /**
+     * @brief isShared checks if other copies reference the same state.
+     * @return true if the next modification has to detach.
+     */
+    bool isShared() const
+    {
+        return mData.use_count() > 1;
+    }
+
+private:
+
+    /**
+     * @brief detach gives this copy its own list of packet pointers if the list is shared with other copies.
+     */
+    void detach()
+    {
+        if(mData.use_count() > 1)
+        {
+            mData = std::make_shared<Data>(*mData);
+        }
+        else
+        {
+            // pairs with the release of another copy that has just dropped its reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    }
+
+private:
+
+    /**
+     * @brief mData the state, shared between copies until one of them is modified.
+     */
+    std::shared_ptr<Data> mData;
+};
+
+}
+
+#endif // SHARED_CONTAINER_H
@@ -0,0 +1,616 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SHARED_MEMORY_RING_H
+#define SHARED_MEMORY_RING_H
+
+#if !defined(__unix__) && !defined(__APPLE__)
+    #error "paco::SharedMemoryRing requires POSIX shared memory"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Container.h"
+#include "ContainerCodec.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The SharedMemoryMessage class is a container read in place from a SharedMemoryRing.
+ * The message points into the shared segment and stays valid until it is released with SharedMemoryRing::release().
+ * It is laid out in the format of the ContainerCodec, so flat objects are read without copying them,
+ * and other objects are decoded with their registered codec.
+ */
+class SharedMemoryMessage
+{
+    friend class SharedMemoryRing;
+
+public:
+
+    /**
+     * @brief SharedMemoryMessage default constructor, an empty message.
+     */
+    SharedMemoryMessage()
+        : mData(nullptr), mSize(0), mRecordSize(0)
+    {
+        std::memset(&mHeader, 0, sizeof(mHeader));
+    }
+
+    /**
+     * @brief size returns the number of objects of the message.
+     * @return the number of objects.
+     */
+    int size() const
+    {
+        return mHeader.count;
+    }
+
+    /**
+     * @brief fingerprint returns the fingerprint of the specification of the message, see Specification::fingerprint().
+     * @return the fingerprint.
+     */
+    std::uint64_t fingerprint() const
+    {
+        return mHeader.fingerprint;
+    }
+
+    /**
+     * @brief matches checks the message against an expected specification without reading any object.
+     * The fingerprint is compared, which identifies the types by their name hash.
+     * @param specification the expected specification.
+     * @return true if the fingerprints are equal.
+     */
+    bool matches(const paco::Specification& specification) const
+    {
+        return mHeader.fingerprint == specification.fingerprint() && (int)mHeader.count == specification.size();
+    }
+
+    /**
+     * @brief typeHash returns the type name hash of an object, see PacketTypeDescriptor::hash().
+     * @param index the index of the object.
+     * @return the type name hash.
+     */
+    std::uint64_t typeHash(int index) const
+    {
+        return entry(index).typeHash;
+    }
+
+    /**
+     * @brief get<T> returns a reference to a flat object in the shared segment.
+     * Throws std::bad_cast if the object is not of type T, and std::runtime_error if it is malformed.
+     * @param index the index of the object.
+     * @return the object, valid until the message is released.
+     */
+    template <class T>
+    const T& get(int index) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value,
+                      "SharedMemoryMessage::get<T>() requires a flat type, use toContainer() for other types");
+
+        paco::ContainerCodec::Entry object = entry(index);
+
+        if(object.typeHash != paco::PacketTypeRegistry::descriptor<T>()->hash())
+        {
+            throw std::bad_cast();
+        }
+
+        if(object.size != sizeof(T) || reinterpret_cast<std::uintptr_t>(mData + object.offset) % alignof(T) != 0)
+        {
+            throw std::runtime_error("paco::SharedMemoryMessage: malformed or misaligned object");
+        }
+
+        return *reinterpret_cast<const T*>(mData + object.offset);
+    }
+
+    /**
+     * @brief data returns the encoded message.
+     * @return the encoded message, valid until the message is released.
+     */
+    const char* data() const
+    {
+        return mData;
+    }
+
+    /**
+     * @brief byteSize returns the size of the encoded message in bytes.
+     * @return the size in bytes.
+     */
+    std::size_t byteSize() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief specification returns the specification of the message.
+     * Throws std::runtime_error if a type has never been used in this process.
+     * @return the specification.
+     */
+    paco::Specification specification() const
+    {
+        return paco::ContainerCodec::specification(mData, mSize);
+    }
+
+    /**
+     * @brief toContainer copies the message into a container, see ContainerCodec::decode().
+     * @return the decoded container.
+     */
+    paco::Container toContainer() const
+    {
+        return paco::ContainerCodec::decode(mData, mSize);
+    }
+
+private:
+
+    paco::ContainerCodec::Entry entry(int index) const
+    {
+        if(index < 0 || index >= (int)mHeader.count)
+        {
+            throw std::out_of_range("paco::SharedMemoryMessage: index out of range");
+        }
+
+        paco::ContainerCodec::Entry object = paco::ContainerCodec::entry(mData, index);
+
+        if(object.offset > mHeader.size || object.size > mHeader.size - object.offset)
+        {
+            throw std::runtime_error("paco::SharedMemoryMessage: object outside of the message");
+        }
+
+        return object;
+    }
+
+private:
+
+    const char* mData;
+    std::size_t mSize;
+
+    /**
+     * @brief mRecordSize the number of bytes the message occupies in the ring, released by SharedMemoryRing::release().
+     */
+    std::size_t mRecordSize;
+
+    paco::ContainerCodec::Header mHeader;
+};
+
+
+/**
+ * @brief The SharedMemoryRing class passes containers from one process to another through a POSIX shared memory segment.
+ *
+ * The writer encodes a container with the ContainerCodec straight into the ring, the reader maps the same segment
+ * and reads the message in place, flat objects without any copy:
+ *
+ *  // process A
+ *  paco::SharedMemoryRing ring("/paco-frames", 1 << 20);
+ *  ring.write(container);
+ *  ring.close();
+ *
+ *  // process B
+ *  paco::SharedMemoryRing ring("/paco-frames");
+ *  paco::SharedMemoryMessage message;
+ *  while(ring.read(message))
+ *  {
+ *      const Frame& frame = message.get<Frame>(0);
+ *      ...
+ *      ring.release(message);
+ *  }
+ *
+ * The ring has one writer and one reader. Both only exchange a write and a read position, which are lock free
+ * atomics in the segment, so neither side ever blocks the other. Messages are read and released in order;
+ * the space of a message is reused only after it has been released. A message may take at most half of the ring.
+ *
+ * Messages are identified by the type name hashes of the ContainerCodec, so both processes have to use the same
+ * type names, and types that are not flat need a registered codec. Both processes must have the same byte order
+ * and layout of the flat types, i.e. run on the same machine from the same build.
+ */
+class SharedMemoryRing
+{
+public:
+
+    static const std::uint64_t Magic = 0x474e49524f434150ull; // "PACORING"
+    static const std::size_t Alignment = 8;
+
+    /**
+     * @brief SharedMemoryRing constructor, creates a segment as the writer.
+     * An existing segment of the same name is replaced. The segment is removed when the writer is destroyed,
+     * a reader that has already opened it keeps its mapping.
+     * Throws std::runtime_error if the segment cannot be created.
+     * @param name the name of the segment, e.g. "/paco-frames".
+     * @param capacity the number of bytes for messages, rounded up to a power of two. A single message may
+     * take at most half of it, see tryWrite().
+     */
+    SharedMemoryRing(const std::string& name, std::size_t capacity)
+        : mName(name), mOwner(true)
+    {
+        std::size_t size = 64;
+        while(size < capacity)
+        {
+            size *= 2;
+        }
+
+        ::shm_unlink(name.c_str());
+
+        int descriptor = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(descriptor < 0)
+        {
+            fail("shm_open");
+        }
+
+        mMappedSize = sizeof(Control) + size;
+
+        if(::ftruncate(descriptor, mMappedSize) != 0)
+        {
+            int error = errno;
+            ::close(descriptor);
+            errno = error;
+            ::shm_unlink(name.c_str());
+            fail("ftruncate");
+        }
+
+        map(descriptor);
+
+        mControl = new(mMapping) Control();
+        mControl->capacity = size;
+        mControl->head.store(0, std::memory_order_relaxed);
+        mControl->tail.store(0, std::memory_order_relaxed);
+        mControl->closed.store(0, std::memory_order_relaxed);
+        mControl->magic.store(Magic, std::memory_order_release);
+    }
+
+    /**
+     * @brief SharedMemoryRing constructor, opens an existing segment as the reader.
+     * Throws std::runtime_error if the segment does not exist or is not a ring.
+     * @param name the name of the segment.
+     */
+    explicit SharedMemoryRing(const std::string& name)
+        : mName(name), mOwner(false)
+    {
+        int descriptor = ::shm_open(name.c_str(), O_RDWR, 0600);
+        if(descriptor < 0)
+        {
+            fail("shm_open");
+        }
+
+        struct stat status;
+        if(::fstat(descriptor, &status) != 0 || status.st_size < (off_t)sizeof(Control))
+        {
+            ::close(descriptor);
+            throw std::runtime_error("paco::SharedMemoryRing: " + name + " is not a ring");
+        }
+
+        mMappedSize = status.st_size;
+        map(descriptor);
+
+        mControl = static_cast<Control*>(mMapping);
+
+        if(mControl->magic.load(std::memory_order_acquire) != Magic || sizeof(Control) + mControl->capacity != mMappedSize)
+        {
+            ::munmap(mMapping, mMappedSize);
+            throw std::runtime_error("paco::SharedMemoryRing: " + name + " is not a ring");
+        }
+    }
+
+    /**
+     * @brief ~SharedMemoryRing destructor, unmaps the segment and removes it if this is the writer.
+     */
+    ~SharedMemoryRing()
+    {
+        ::munmap(mMapping, mMappedSize);
+
+        if(mOwner)
+        {
+            ::shm_unlink(mName.c_str());
+        }
+    }
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    /**
+     * @brief capacity returns the number of bytes available for messages.
+     * @return the capacity in bytes.
+     */
+    std::size_t capacity() const
+    {
+        return mControl->capacity;
+    }
+
+    /**
+     * @brief tryWrite writes a container if there is space.
+     * Throws std::length_error if the encoded container with its size takes more than half of the capacity,
+     * and std::runtime_error if it holds a type that is neither flat nor has a registered codec.
+     * @param container the container.
+     * @return false if the ring is full or closed.
+     */
+    bool tryWrite(const paco::Container& container)
+    {
+        return tryWrite(container, paco::ContainerCodec::encodedSize(container));
+    }
+
+    /**
+     * @brief write writes a container and waits while the ring is full, throws like tryWrite().
+     * @param container the container.
+     * @return false if the ring has been closed.
+     */
+    bool write(const paco::Container& container)
+    {
+        std::size_t size = paco::ContainerCodec::encodedSize(container);
+
+        while(!tryWrite(container, size))
+        {
+            if(isClosed())
+            {
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief tryRead reads the next message if there is one.
+     * Throws std::runtime_error if the ring holds a malformed message.
+     * @param message receives the message, valid until it is released.
+     * @return false if the ring is empty.
+     */
+    bool tryRead(paco::SharedMemoryMessage& message)
+    {
+        std::uint64_t tail = mRead;
+        std::uint64_t head = mControl->head.load(std::memory_order_acquire);
+
+        std::uint64_t released = mControl->tail.load(std::memory_order_relaxed);
+        if(tail < released)
+        {
+            // another reader has consumed messages before this one opened the ring
+            tail = mRead = released;
+        }
+
+        if(tail == head)
+        {
+            return false;
+        }
+
+        std::size_t capacity = mControl->capacity;
+        std::size_t offset = tail & (capacity - 1);
+        std::uint64_t size;
+        std::memcpy(&size, data() + offset, sizeof(size));
+
+        std::size_t skipped = 0;
+        if(size == Wrap)
+        {
+            // the writer jumped to the start of the ring, the rest of the ring belongs to this message
+            skipped = capacity - offset;
+            offset = 0;
+            std::memcpy(&size, data(), sizeof(size));
+        }
+
+        std::size_t record = align(sizeof(std::uint64_t) + size);
+
+        if(skipped + record > head - tail || size < sizeof(paco::ContainerCodec::Header))
+        {
+            throw std::runtime_error("paco::SharedMemoryRing: malformed message");
+        }
+
+        message.mData = data() + offset + sizeof(std::uint64_t);
+        message.mSize = size;
+        message.mRecordSize = skipped + record;
+        message.mHeader = paco::ContainerCodec::header(message.mData, message.mSize);
+
+        mRead = tail + message.mRecordSize;
+
+        return true;
+    }
+
+    /**
+     * @brief read reads the next message and waits while the ring is empty.
+     * @param message receives the message, valid until it is released.
+     * @return false if the ring has been closed and all messages have been read.
+     */
+    bool read(paco::SharedMemoryMessage& message)
+    {
+        while(!tryRead(message))
+        {
+            // the writer closes after its last write, so the ring is checked once more after seeing the flag
+            if(isClosed())
+            {
+                return tryRead(message);
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief release hands the space of a message back to the writer. Messages have to be released in the order
+     * they have been read; the message must not be used afterwards.
+     * @param message the oldest unreleased message.
+     */
+    void release(paco::SharedMemoryMessage& message)
+    {
+        mControl->tail.fetch_add(message.mRecordSize, std::memory_order_release);
+        message = paco::SharedMemoryMessage();
+    }
+
+    /**
+     * @brief close tells the reader that no more messages will be written.
+     */
+    void close()
+    {
+        mControl->closed.store(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief isClosed checks if the writer has closed the ring.
+     * @return true if the ring is closed.
+     */
+    bool isClosed() const
+    {
+        return mControl->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * @brief remove removes a segment by name, e.g. one left behind by a writer that crashed.
+     * @param name the name of the segment.
+     */
+    static void remove(const std::string& name)
+    {
+        ::shm_unlink(name.c_str());
+    }
+
+private:
+
+    /**
+     * @brief Wrap marks the end of the used part of the ring, the next message starts at offset 0.
+     */
+    static constexpr std::uint64_t Wrap = ~0ull;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "paco::SharedMemoryRing requires lock free 64 bit atomics");
+
+    /**
+     * @brief The Control struct is the beginning of the segment, followed by the messages.
+     * The write and read positions count bytes since the segment was created and are on separate cache lines.
+     */
+    struct alignas(64) Control
+    {
+        std::atomic<std::uint64_t> magic;
+        std::uint64_t capacity;
+        std::atomic<std::uint32_t> closed;
+
+        alignas(64) std::atomic<std::uint64_t> head;
+        alignas(64) std::atomic<std::uint64_t> tail;
+    };
+
+    /**
+     * @brief tryWrite encodes a container of a measured size straight into the free space at the head, so every
+     * payload is copied once. Each message is stored as its size followed by the encoded container, padded to Alignment. A message that does not fit before the end of the ring is
+     * stored at the start, behind a Wrap marker.
+     *
+     * A record of at most half the capacity always fits into the empty ring, wherever the head is, because the
+     * skipped end is smaller than the record. A larger record could fit only at some positions, so a writer
+     * waiting for space could wait forever.
+     */
+    bool tryWrite(const paco::Container& container, std::size_t encodedSize)
+    {
+        std::size_t capacity = mControl->capacity;
+        std::size_t record = align(sizeof(std::uint64_t) + encodedSize);
+
+        if(record > capacity / 2)
+        {
+            throw std::length_error("paco::SharedMemoryRing: the container is larger than half of the ring");
+        }
+
+        if(isClosed())
+        {
+            return false;
+        }
+
+        std::uint64_t head = mControl->head.load(std::memory_order_relaxed);
+        std::uint64_t tail = mControl->tail.load(std::memory_order_acquire);
+        std::size_t offset = head & (capacity - 1);
+        std::size_t skipped = offset + record > capacity ? capacity - offset : 0;
+
+        if(skipped + record > capacity - (head - tail))
+        {
+            return false;
+        }
+
+        if(skipped > 0)
+        {
+            std::memcpy(data() + offset, &Wrap, sizeof(Wrap));
+            offset = 0;
+        }
+
+        // the space is not published before the head moves, so a throwing codec leaves the ring unchanged
+        paco::PacketWriter writer(data() + offset + sizeof(std::uint64_t), record - sizeof(std::uint64_t));
+        paco::ContainerCodec::encode(container, writer);
+
+        std::uint64_t size = writer.size();
+        std::memcpy(data() + offset, &size, sizeof(size));
+
+        mControl->head.store(head + skipped + align(sizeof(std::uint64_t) + size), std::memory_order_release);
+
+        return true;
+    }
+
+    void map(int descriptor)
+    {
+        mMapping = ::mmap(nullptr, mMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        int error = errno;
+        ::close(descriptor);
+
+        if(mMapping == MAP_FAILED)
+        {
+            errno = error;
+
+            if(mOwner)
+            {
+                ::shm_unlink(mName.c_str());
+            }
+
+            fail("mmap");
+        }
+    }
+
+    char* data() const
+    {
+        return reinterpret_cast<char*>(mMapping) + sizeof(Control);
+    }
+
+    static std::size_t align(std::size_t size)
+    {
+        return (size + Alignment - 1) / Alignment * Alignment;
+    }
+
+    void fail(const char* call) const
+    {
+        throw std::runtime_error("paco::SharedMemoryRing: " + std::string(call) + " failed for " + mName + ": " + std::strerror(errno));
+    }
+
+private:
+
+    std::string mName;
+
+    /**
+     * @brief mOwner true for the writer, which created the segment.
+     */
+    bool mOwner;
+
+    void* mMapping;
+    std::size_t mMappedSize;
+    Control* mControl;
+
+    /**
+     * @brief mRead the read position behind the last message returned by tryRead(), ahead of the released tail.
+     */
+    std::uint64_t mRead = 0;
+};
+
+}
+
+#endif // SHARED_MEMORY_RING_H
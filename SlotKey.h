@@ -0,0 +1,455 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SLOT_KEY_H
+#define SLOT_KEY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MemoryResource.h"
+#include "PacoString.h"
+#include "PacketTypeRegistry.h"
+
+namespace paco
+{
+
+/**
+ * @brief The SlotKey class names an element of a container, see Container::append<T>(key, value).
+ * A key is an interned description, see PacketTypeRegistry::internDescription(): equal names give the same pointer,
+ * so comparing and hashing keys never touches the characters.
+ *
+ * Creating a key from a name interns the name, which locks the registry. Lookups by name like
+ * container.get<T>("pose") use find() instead, which neither locks nor interns, so looking up unknown names does
+ * not grow the registry. Keys used on hot paths are still best created once and reused, which saves hashing the name:
+ *
+ *  static const paco::SlotKey Pose("pose");
+ *  container.get<Pose3d>(Pose);
+ */
+class SlotKey
+{
+public:
+
+    /**
+     * @brief SlotKey default constructor, creates the null key that names no element.
+     */
+    SlotKey()
+        : mName(nullptr)
+    {
+    }
+
+    /**
+     * @brief SlotKey creates the key of a name. An empty name gives the null key.
+     * @param name the name of the key.
+     */
+    SlotKey(const paco::String& name)
+        : mName(paco::PacketTypeRegistry::instance().internDescription(name))
+    {
+    }
+
+    /**
+     * @brief SlotKey creates the key of a name. An empty name gives the null key.
+     * @param name the name of the key.
+     */
+    SlotKey(const char* name)
+        : SlotKey(paco::String(name))
+    {
+    }
+
+    /**
+     * @brief SlotKey is not constructible from nullptr or the literal 0, so that e.g. container.get<T>(0) never
+     * silently becomes a keyed access. Use the default constructor for the null key.
+     */
+    SlotKey(std::nullptr_t) = delete;
+
+    /**
+     * @brief SlotKey creates the key of a UTF-8 name. An empty name gives the null key.
+     * @param name the name of the key.
+     */
+    SlotKey(std::string_view name)
+        : SlotKey(paco::fromUtf8(name))
+    {
+    }
+
+#ifndef PACO_NO_QT
+    /**
+     * @brief SlotKey creates the key of a UTF-8 name. An empty name gives the null key.
+     * @param name the name of the key.
+     */
+    SlotKey(const std::string& name)
+        : SlotKey(paco::fromUtf8(name))
+    {
+    }
+#endif
+
+    /**
+     * @brief find returns the key of a UTF-8 name without interning it, see PacketTypeRegistry::findDescription().
+     * @param name the name of the key.
+     * @return the key, or the null key if no key of that name has been created yet, so no element can have it.
+     */
+    static SlotKey find(std::string_view name)
+    {
+        return fromInterned(paco::PacketTypeRegistry::instance().findDescription(name));
+    }
+
+    /**
+     * @brief fromInterned creates a key from a description that has already been interned.
+     * @param name the interned description, or nullptr for the null key.
+     * @return the key.
+     */
+    static SlotKey fromInterned(const paco::String* name)
+    {
+        SlotKey key;
+        key.mName = name;
+
+        return key;
+    }
+
+    /**
+     * @brief isNull checks if this is the null key.
+     * @return true if the key names no element.
+     */
+    bool isNull() const
+    {
+        return mName == nullptr;
+    }
+
+    /**
+     * @brief name returns the name of the key.
+     * @return the name of the key, empty for the null key.
+     */
+    paco::String name() const
+    {
+        return mName != nullptr ? *mName : paco::String();
+    }
+
+    /**
+     * @brief interned returns the interned description of the key.
+     * @return the interned description, nullptr for the null key.
+     */
+    const paco::String* interned() const
+    {
+        return mName;
+    }
+
+    /**
+     * @brief hash returns a hash of the key, only valid within one process.
+     * @return the hash of the key.
+     */
+    std::uint64_t hash() const
+    {
+        std::uint64_t hash = (std::uint64_t)(std::uintptr_t)mName;
+
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    bool operator==(const SlotKey& other) const
+    {
+        return mName == other.mName;
+    }
+
+    bool operator!=(const SlotKey& other) const
+    {
+        return mName != other.mName;
+    }
+
+private:
+
+    /**
+     * @brief mName is the interned description, or nullptr.
+     */
+    const paco::String* mName;
+};
+
+
+/**
+ * @brief IsSlotKeyName_T checks if Name is a UTF-8 name that read only lookups take without creating a SlotKey,
+ * e.g. a string literal, std::string or std::string_view.
+ */
+template <class Name>
+struct IsSlotKeyName_T
+    : std::integral_constant<bool, std::is_convertible<const Name&, std::string_view>::value
+                                   && !std::is_same<typename std::decay<Name>::type, std::nullptr_t>::value
+                                   && !std::is_same<typename std::decay<Name>::type, paco::SlotKey>::value>
+{
+};
+
+
+/**
+ * @brief The SlotKeyIndex class maps the keys of a container to the positions of their elements.
+ * It is an open addressing hash table with linear probing: one flat array of (key, index) entries,
+ * at most half full, so a lookup usually inspects one or two entries of the same cache line.
+ * Removed entries are filled by shifting back the following entries of their probe sequence, there are no tombstones.
+ *
+ * The positions are not updated automatically, the container calls shift() when it moves elements.
+ */
+class SlotKeyIndex
+{
+public:
+
+    /**
+     * @brief SlotKeyIndex constructor, creates an empty index that does not allocate.
+     * @param resource the memory resource of the table, nullptr for the global operator new.
+     */
+    explicit SlotKeyIndex(std::pmr::memory_resource* resource = nullptr)
+        : mEntries(paco::ResourceAllocator_T<Entry>(resource)), mSize(0)
+    {
+    }
+
+    SlotKeyIndex(const SlotKeyIndex& other) = default;
+    SlotKeyIndex& operator=(const SlotKeyIndex& other) = default;
+
+    /**
+     * @brief SlotKeyIndex move constructor.
+     * @param other the index to move from, empty afterwards.
+     */
+    SlotKeyIndex(SlotKeyIndex&& other)
+        : mEntries(std::move(other.mEntries)), mSize(other.mSize)
+    {
+        other.mEntries.clear();
+        other.mSize = 0;
+    }
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the index to move from, empty afterwards.
+     * @return this index.
+     */
+    SlotKeyIndex& operator=(SlotKeyIndex&& other)
+    {
+        if(this != &other)
+        {
+            mEntries = std::move(other.mEntries);
+            mSize = other.mSize;
+
+            other.mEntries.clear();
+            other.mSize = 0;
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief size returns the number of keys.
+     * @return the number of keys.
+     */
+    int size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief find returns the position of the element with a key.
+     * @param key the key.
+     * @return the position, or -1 if no element has the key.
+     */
+    int find(const paco::SlotKey& key) const
+    {
+        if(mSize == 0 || key.isNull())
+        {
+            return -1;
+        }
+
+        const std::size_t mask = mEntries.size() - 1;
+
+        for(std::size_t i = key.hash() & mask; mEntries[i].key != nullptr; i = (i + 1) & mask)
+        {
+            if(mEntries[i].key == key.interned())
+            {
+                return mEntries[i].index;
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * @brief insert adds a key. The key must not be null.
+     * @param key the key.
+     * @param index the position of the element with the key.
+     * @return false if the key already exists, the index is unchanged then.
+     */
+    bool insert(const paco::SlotKey& key, int index)
+    {
+        if(2 * (mSize + 1) > (int)mEntries.size())
+        {
+            grow();
+        }
+
+        const std::size_t mask = mEntries.size() - 1;
+        std::size_t i = key.hash() & mask;
+
+        for(; mEntries[i].key != nullptr; i = (i + 1) & mask)
+        {
+            if(mEntries[i].key == key.interned())
+            {
+                return false;
+            }
+        }
+
+        mEntries[i].key = key.interned();
+        mEntries[i].index = index;
+        mSize++;
+
+        return true;
+    }
+
+    /**
+     * @brief erase removes a key.
+     * @param key the key.
+     */
+    void erase(const paco::SlotKey& key)
+    {
+        if(mSize == 0 || key.isNull())
+        {
+            return;
+        }
+
+        const std::size_t mask = mEntries.size() - 1;
+        std::size_t hole = key.hash() & mask;
+
+        for(; mEntries[hole].key != key.interned(); hole = (hole + 1) & mask)
+        {
+            if(mEntries[hole].key == nullptr)
+            {
+                return;
+            }
+        }
+
+        for(std::size_t next = (hole + 1) & mask; mEntries[next].key != nullptr; next = (next + 1) & mask)
+        {
+            std::size_t home = paco::SlotKey::fromInterned(mEntries[next].key).hash() & mask;
+
+            // move the entry into the hole unless its home lies cyclically between the hole and its position
+            if(((next - home) & mask) >= ((next - hole) & mask))
+            {
+                mEntries[hole] = mEntries[next];
+                hole = next;
+            }
+        }
+
+        mEntries[hole] = Entry();
+        mSize--;
+    }
+
+    /**
+     * @brief shift adds delta to every position at or after first, used when elements are inserted or removed.
+     * @param first the first position to shift.
+     * @param delta the distance, +1 for an insert, -1 for a removal.
+     */
+    void shift(int first, int delta)
+    {
+        if(mSize == 0)
+        {
+            return;
+        }
+
+        for(std::size_t i = 0; i < mEntries.size(); i++)
+        {
+            if(mEntries[i].key != nullptr && mEntries[i].index >= first)
+            {
+                mEntries[i].index += delta;
+            }
+        }
+    }
+
+    /**
+     * @brief clear removes all keys and keeps the table like the storage of the container, so a recycled container
+     * does not allocate it again. The table is freed with the index.
+     */
+    void clear()
+    {
+        if(mSize > 0)
+        {
+            std::fill(mEntries.begin(), mEntries.end(), Entry());
+            mSize = 0;
+        }
+    }
+
+    /**
+     * @brief memoryUsage returns the size of the table in bytes.
+     * @return the size of the table in bytes.
+     */
+    std::size_t memoryUsage() const
+    {
+        return mEntries.capacity() * sizeof(Entry);
+    }
+
+private:
+
+    /**
+     * @brief The Entry struct is one bucket of the table, empty if key is nullptr.
+     */
+    struct Entry
+    {
+        Entry()
+            : key(nullptr), index(-1)
+        {
+        }
+
+        const paco::String* key;
+        int index;
+    };
+
+    typedef std::vector<Entry, paco::ResourceAllocator_T<Entry> > Entries;
+
+    /**
+     * @brief grow doubles the table, starting with 8 entries, and reinserts all keys.
+     */
+    void grow()
+    {
+        Entries entries(mEntries.get_allocator());
+        entries.swap(mEntries);
+        mEntries.resize(entries.empty() ? 8 : 2 * entries.size());
+
+        const std::size_t mask = mEntries.size() - 1;
+
+        for(std::size_t e = 0; e < entries.size(); e++)
+        {
+            if(entries[e].key != nullptr)
+            {
+                std::size_t i = paco::SlotKey::fromInterned(entries[e].key).hash() & mask;
+
+                while(mEntries[i].key != nullptr)
+                {
+                    i = (i + 1) & mask;
+                }
+
+                mEntries[i] = entries[e];
+            }
+        }
+    }
+
+private:
+
+    /**
+     * @brief mEntries the table, its size is zero or a power of two.
+     */
+    Entries mEntries;
+
+    /**
+     * @brief mSize the number of keys.
+     */
+    int mSize;
+};
+
+}
+
+#endif // SLOT_KEY_H
@@ -0,0 +1,721 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SLOT_MAP_CONTAINER_H
+#define SLOT_MAP_CONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Container.h"
+#include "Instrumentation.h"
+#include "Packet.h"
+#include "PacketSlot.h"
+#include "PacketType.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The SlotHandle struct refers to one object of a SlotMapContainer.
+ * A handle stays valid while other objects are inserted or removed. Once its object is removed the handle is stale:
+ * the slot may be reused, but with a new generation, so a stale handle never refers to another object.
+ */
+struct SlotHandle
+{
+    SlotHandle()
+        : index(-1), generation(0)
+    {
+    }
+
+    SlotHandle(int index, std::uint32_t generation)
+        : index(index), generation(generation)
+    {
+    }
+
+    /**
+     * @brief isNull checks if this is the null handle, returned e.g. by SlotMapContainer::next() at the end.
+     * @return true if the handle refers to no slot.
+     */
+    bool isNull() const
+    {
+        return index < 0;
+    }
+
+    bool operator==(const SlotHandle& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const SlotHandle& other) const
+    {
+        return !(*this == other);
+    }
+
+    /**
+     * @brief index the slot of the object.
+     */
+    int index;
+
+    /**
+     * @brief generation the generation of the slot when the object was added.
+     */
+    std::uint32_t generation;
+};
+
+
+/**
+ * @brief The SlotMapContainer class is a container that addresses its objects by stable handles instead of positions.
+ *
+ * The objects live in a slot map: slots are never moved between objects, removed slots are put on a free list
+ * and reused, and every slot carries a generation that is incremented when its object is removed.
+ * The order of the objects is kept in a doubly linked list through the slots. Therefore
+ *
+ * - append, insert before a handle, remove and replace are O(1),
+ * - a handle stays valid until its own object is removed, no matter how many objects are inserted or removed,
+ * - stale handles are detected and rejected with std::out_of_range.
+ *
+ * Iterating visits the objects in order, and getSpecification() describes them in order, so a SlotMapContainer
+ * can be matched against a Specification like a Container. The specification is rebuilt lazily after a modification.
+ *
+ * Packets are stored in PacketSlots like in a Container. Packet pointers returned by at() are invalidated when
+ * objects are added, handles are not.
+ */
+class SlotMapContainer
+{
+private:
+
+    /**
+     * template_type_must_be_specified_when_calling_append is a helper to force the programmer
+     * to use angle brackets <type> in append<type>(value). If not specified the compiler will not be able to compile.
+     */
+    template <typename T>
+    struct template_type_must_be_specified_when_calling_append
+    {
+        using type = T;
+    };
+
+    /**
+     * @brief The Entry struct is one slot of the slot map.
+     */
+    struct Entry
+    {
+        Entry()
+            : generation(0), previous(-1), next(-1)
+        {
+        }
+
+        /**
+         * @brief slot the packet, empty if the slot is free.
+         */
+        paco::PacketSlot slot;
+
+        /**
+         * @brief generation is incremented whenever the object of the slot is removed.
+         */
+        std::uint32_t generation;
+
+        /**
+         * @brief previous the previous slot in order, or -1.
+         */
+        int previous;
+
+        /**
+         * @brief next the next slot in order, or -1. For free slots the next free slot.
+         */
+        int next;
+    };
+
+public:
+
+    /**
+     * @brief The Iterator class visits the packets of a SlotMapContainer in order.
+     */
+    class Iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef paco::Packet* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef paco::Packet* const* pointer;
+        typedef paco::Packet* reference;
+
+        Iterator(const SlotMapContainer* container, int index)
+            : mContainer(container), mIndex(index)
+        {
+        }
+
+        paco::Packet* operator*() const
+        {
+            return mContainer->mEntries[mIndex].slot.packet();
+        }
+
+        Iterator& operator++()
+        {
+            mIndex = mContainer->mEntries[mIndex].next;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        /**
+         * @brief handle returns the handle of the current object.
+         * @return the handle of the current object.
+         */
+        paco::SlotHandle handle() const
+        {
+            return paco::SlotHandle(mIndex, mContainer->mEntries[mIndex].generation);
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return mIndex == other.mIndex;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return mIndex != other.mIndex;
+        }
+
+    private:
+
+        const SlotMapContainer* mContainer;
+        int mIndex;
+    };
+
+    /**
+     * @brief SlotMapContainer default constructor.
+     */
+    SlotMapContainer()
+        : mFirst(-1), mLast(-1), mFree(-1), mSize(0), mSpecificationValid(true)
+    {
+    }
+
+    /**
+     * @brief SlotMapContainer moves all objects of a container into a new slot map container, keeping their order.
+     * The packets are moved slot by slot, heap packets are taken over without a copy.
+     * Keys of the container are not kept.
+     * @param container the container to move from, empty afterwards.
+     */
+    explicit SlotMapContainer(paco::Container&& container)
+        : SlotMapContainer()
+    {
+        mEntries.reserve(container.mSlots.size());
+
+        for(std::size_t i = 0; i < container.mSlots.size(); i++)
+        {
+            int index = allocate();
+            mEntries[index].slot = std::move(container.mSlots[i]);
+            link(index, -1);
+        }
+
+        container.clear();
+    }
+
+    /**
+     * @brief SlotMapContainer move constructor.
+     * @param other the container to move from, empty afterwards.
+     */
+    SlotMapContainer(SlotMapContainer&& other)
+        : SlotMapContainer()
+    {
+        swap(other);
+    }
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the container to move from, empty afterwards.
+     * @return this container.
+     */
+    SlotMapContainer& operator=(SlotMapContainer&& other)
+    {
+        if(this != &other)
+        {
+            SlotMapContainer moved(std::move(other));
+            swap(moved);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief swap exchanges the objects of two containers. Handles keep referring to their objects.
+     * @param other the other container.
+     */
+    void swap(SlotMapContainer& other)
+    {
+        std::swap(mEntries, other.mEntries);
+        std::swap(mFirst, other.mFirst);
+        std::swap(mLast, other.mLast);
+        std::swap(mFree, other.mFree);
+        std::swap(mSize, other.mSize);
+        std::swap(mSpecification, other.mSpecification);
+        std::swap(mSpecificationValid, other.mSpecificationValid);
+    }
+
+    /**
+     * @brief size
+     * @return the number of objects in the container.
+     */
+    int size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief append appends an object. Pass an rvalue to move the object into the container.
+     * @return the handle of the object.
+     */
+    template <class T>
+    paco::SlotHandle append(typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        return emplaceBefore<T>(-1, std::move(value));
+    }
+
+    /**
+     * @brief emplace constructs an object from args at the end of the container.
+     * @param args the constructor arguments of the object.
+     * @return the handle of the object.
+     */
+    template <class T, class... Args>
+    paco::SlotHandle emplace(Args&&... args)
+    {
+        return emplaceBefore<T>(-1, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief insert inserts an object in front of another one in O(1).
+     * Throws std::out_of_range if the handle is stale, the container is unchanged then.
+     * @param before the handle of the object the new one is inserted in front of, the null handle to append.
+     * @return the handle of the new object.
+     */
+    template <class T>
+    paco::SlotHandle insert(paco::SlotHandle before, typename template_type_must_be_specified_when_calling_append<T>::type value)
+    {
+        int next = before.isNull() ? -1 : checkedIndex(before);
+
+        return emplaceBefore<T>(next, std::move(value));
+    }
+
+    /**
+     * @brief remove removes an object in O(1). Its handle and all copies of it become stale.
+     * Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of the object.
+     */
+    void remove(paco::SlotHandle handle)
+    {
+        int index = checkedIndex(handle);
+        Entry& entry = mEntries[index];
+
+        if(entry.previous >= 0)
+        {
+            mEntries[entry.previous].next = entry.next;
+        }
+        else
+        {
+            mFirst = entry.next;
+        }
+
+        if(entry.next >= 0)
+        {
+            mEntries[entry.next].previous = entry.previous;
+        }
+        else
+        {
+            mLast = entry.previous;
+        }
+
+        entry.slot.reset();
+        entry.generation++;
+        entry.previous = -1;
+        entry.next = mFree;
+        mFree = index;
+
+        mSize--;
+        mSpecificationValid = false;
+    }
+
+    /**
+     * @brief replace replaces an object in O(1), the handle stays valid.
+     * The new packet is constructed before the old one is destroyed, so the container is unchanged if that throws.
+     * Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of the object.
+     */
+    template <class T>
+    void replace(paco::SlotHandle handle, T value)
+    {
+        paco::PacketSlot& slot = mEntries[checkedIndex(handle)].slot;
+        slot = paco::PacketSlot(paco::PacketSlot::InPlace_T<T>(), std::move(value));
+        mSpecificationValid = false;
+        paco::Instrumentation::countReplace(paco::PacketTypeRegistry::descriptor<T>());
+    }
+
+    /**
+     * @brief clear removes all objects, all handles become stale.
+     */
+    void clear()
+    {
+        for(int index = mFirst; index >= 0; )
+        {
+            Entry& entry = mEntries[index];
+            int next = entry.next;
+
+            entry.slot.reset();
+            entry.generation++;
+            entry.previous = -1;
+            entry.next = mFree;
+            mFree = index;
+
+            index = next;
+        }
+
+        mFirst = -1;
+        mLast = -1;
+        mSize = 0;
+        mSpecificationValid = false;
+    }
+
+    /**
+     * @brief contains checks if a handle refers to an object of this container.
+     * @param handle the handle.
+     * @return false if the handle is null or stale.
+     */
+    bool contains(paco::SlotHandle handle) const
+    {
+        return handle.index >= 0
+                && handle.index < (int)mEntries.size()
+                && mEntries[handle.index].generation == handle.generation
+                && mEntries[handle.index].slot.packet() != nullptr;
+    }
+
+    /**
+     * @brief at returns the package carrying an object. Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of the object.
+     * @return the package, valid until an object is added.
+     */
+    paco::Packet* at(paco::SlotHandle handle)
+    {
+        return mEntries[checkedIndex(handle)].slot.packet();
+    }
+
+    /**
+     * @brief at returns the package carrying an object. Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of the object.
+     * @return the package, valid until an object is added.
+     */
+    const paco::Packet* at(paco::SlotHandle handle) const
+    {
+        return mEntries[checkedIndex(handle)].slot.packet();
+    }
+
+    /**
+     * @brief get returns a reference to an object.
+     * Throws std::out_of_range if the handle is stale and std::bad_cast if the object is not a T.
+     * @param handle the handle of the object.
+     * @return a reference to the object, valid until an object is added.
+     */
+    template <class T>
+    T& get(paco::SlotHandle handle)
+    {
+        return at(handle)->get_ref<T>();
+    }
+
+    /**
+     * @brief get returns a const reference to an object.
+     * Throws std::out_of_range if the handle is stale and std::bad_cast if the object is not a T.
+     * @param handle the handle of the object.
+     * @return a const reference to the object, valid until an object is added.
+     */
+    template <class T>
+    const T& get(paco::SlotHandle handle) const
+    {
+        return at(handle)->get_cref<T>();
+    }
+
+    /**
+     * @brief get_if returns a pointer to an object if it has type T. Never throws.
+     * @param handle the handle of the object.
+     * @return a pointer to the object, or nullptr if the handle is stale or the object is not a T.
+     */
+    template <class T>
+    T* get_if(paco::SlotHandle handle)
+    {
+        return contains(handle) ? mEntries[handle.index].slot.packet()->get_if<T>() : nullptr;
+    }
+
+    /**
+     * @brief first returns the handle of the first object.
+     * @return the handle, or the null handle if the container is empty.
+     */
+    paco::SlotHandle first() const
+    {
+        return handleOf(mFirst);
+    }
+
+    /**
+     * @brief last returns the handle of the last object.
+     * @return the handle, or the null handle if the container is empty.
+     */
+    paco::SlotHandle last() const
+    {
+        return handleOf(mLast);
+    }
+
+    /**
+     * @brief next returns the handle of the object after another one. Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of an object.
+     * @return the handle, or the null handle at the end.
+     */
+    paco::SlotHandle next(paco::SlotHandle handle) const
+    {
+        return handleOf(mEntries[checkedIndex(handle)].next);
+    }
+
+    /**
+     * @brief previous returns the handle of the object before another one. Throws std::out_of_range if the handle is stale.
+     * @param handle the handle of an object.
+     * @return the handle, or the null handle at the beginning.
+     */
+    paco::SlotHandle previous(paco::SlotHandle handle) const
+    {
+        return handleOf(mEntries[checkedIndex(handle)].previous);
+    }
+
+    /**
+     * @brief begin returns an iterator to the first packet, see Iterator::handle().
+     */
+    Iterator begin() const
+    {
+        return Iterator(this, mFirst);
+    }
+
+    /**
+     * @brief end returns the iterator behind the last packet.
+     */
+    Iterator end() const
+    {
+        return Iterator(this, -1);
+    }
+
+    /**
+     * @brief specification returns the specification of the objects in order without copying it.
+     * It is rebuilt on the first call after a modification.
+     * @return the specification, valid until the container is modified.
+     */
+    const Specification& specification() const
+    {
+        if(!mSpecificationValid)
+        {
+            mSpecification.clear_friend_class_only();
+
+            for(int index = mFirst; index >= 0; index = mEntries[index].next)
+            {
+                mSpecification.append_friend_class_only(mEntries[index].slot.packet()->packetType());
+            }
+
+            mSpecificationValid = true;
+        }
+
+        return mSpecification;
+    }
+
+    /**
+     * @brief getSpecification returns a copy of the specification of the objects in order.
+     * @return the current specification of the container.
+     */
+    Specification getSpecification() const
+    {
+        return specification();
+    }
+
+    /**
+     * @brief matches checks if the objects of this container match an expected specification, in order.
+     * @param specification the expected specification.
+     * @return true if the container matches the specification.
+     */
+    bool matches(const Specification& specification) const
+    {
+        return this->specification().equals(specification);
+    }
+
+    /**
+     * @brief toContainer moves all objects into a Container, in order. This container is empty afterwards
+     * and all handles are stale.
+     * @return the container.
+     */
+    paco::Container toContainer()
+    {
+        paco::Container container;
+        container.mSlots.reserve(mSize);
+
+        for(int index = mFirst; index >= 0; index = mEntries[index].next)
+        {
+            container.mSlots.push_back(std::move(mEntries[index].slot));
+
+            paco::PacketType packetType = container.mSlots.back().packet()->packetType();
+            container.mSpecification.append_friend_class_only(packetType);
+            container.mTypes.append(packetType.typeId(), container.mSlots.size() - 1, container.mSpecification);
+        }
+
+        clear();
+
+        return container;
+    }
+
+private:
+
+    /**
+     * @brief emplaceBefore constructs a new object in a free slot and links it in front of next, or at the end for -1.
+     */
+    template <class T, class... Args>
+    paco::SlotHandle emplaceBefore(int next, Args&&... args)
+    {
+        int index = allocate();
+
+        try
+        {
+            mEntries[index].slot.emplace<T>(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            mEntries[index].next = mFree;
+            mFree = index;
+            throw;
+        }
+
+        link(index, next);
+        paco::Instrumentation::countAppend(paco::PacketTypeRegistry::descriptor<T>());
+
+        return paco::SlotHandle(index, mEntries[index].generation);
+    }
+
+    /**
+     * @brief allocate takes a slot from the free list, or adds a new one.
+     * @return the index of the empty slot.
+     */
+    int allocate()
+    {
+        if(mFree >= 0)
+        {
+            int index = mFree;
+            mFree = mEntries[index].next;
+
+            return index;
+        }
+
+        mEntries.emplace_back();
+
+        return mEntries.size() - 1;
+    }
+
+    /**
+     * @brief link inserts an occupied slot into the order in front of next, or at the end for -1.
+     */
+    void link(int index, int next)
+    {
+        Entry& entry = mEntries[index];
+        entry.next = next;
+        entry.previous = next >= 0 ? mEntries[next].previous : mLast;
+
+        if(entry.previous >= 0)
+        {
+            mEntries[entry.previous].next = index;
+        }
+        else
+        {
+            mFirst = index;
+        }
+
+        if(next >= 0)
+        {
+            mEntries[next].previous = index;
+        }
+        else
+        {
+            mLast = index;
+        }
+
+        mSize++;
+        mSpecificationValid = false;
+    }
+
+    /**
+     * @brief checkedIndex returns the slot of a handle, throws std::out_of_range if the handle is null or stale.
+     */
+    int checkedIndex(paco::SlotHandle handle) const
+    {
+        if(!contains(handle))
+        {
+            throw std::out_of_range("paco::SlotMapContainer: stale handle");
+        }
+
+        return handle.index;
+    }
+
+    /**
+     * @brief handleOf returns the handle of an occupied slot, or the null handle for -1.
+     */
+    paco::SlotHandle handleOf(int index) const
+    {
+        return index >= 0 ? paco::SlotHandle(index, mEntries[index].generation) : paco::SlotHandle();
+    }
+
+private:
+
+    /**
+     * @brief mEntries the slots, occupied and free.
+     */
+    std::vector<Entry> mEntries;
+
+    /**
+     * @brief mFirst the first slot in order, or -1.
+     */
+    int mFirst;
+
+    /**
+     * @brief mLast the last slot in order, or -1.
+     */
+    int mLast;
+
+    /**
+     * @brief mFree the first free slot, or -1.
+     */
+    int mFree;
+
+    /**
+     * @brief mSize the number of objects.
+     */
+    int mSize;
+
+    /**
+     * @brief mSpecification the cached specification of the objects in order.
+     */
+    mutable Specification mSpecification;
+
+    /**
+     * @brief mSpecificationValid is false if mSpecification has to be rebuilt.
+     */
+    mutable bool mSpecificationValid;
+};
+
+}
+
+#endif // SLOT_MAP_CONTAINER_H
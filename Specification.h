@@ -11,8 +11,11 @@
 #ifndef CONTAINERSPECIFICATION_H
 #define CONTAINERSPECIFICATION_H
 
+#include "MemoryResource.h"
 #include "Packet.h"
 #include "PacketType.h"
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace paco
@@ -26,6 +29,14 @@ namespace paco
 class Specification
 {
     friend class Container;
+    friend class ContainerCodec;
+    friend class ConcurrentContainer;
+    friend class SharedContainer;
+    friend class SlotMapContainer;
+    friend class SpecificationPattern;
+    friend class SpecificationRouter;
+    friend class SignatureBatch;
+    friend class TypeIndex;
 
 public:
     /**
@@ -33,7 +44,52 @@ public:
      */
     Specification()
     {
+        mFingerprint = 0;
+        mPower = 1;
+    }
+
+    /**
+     * @brief Specification constructor that allocates from a memory resource, used by Container.
+     * Copies of the specification allocate with the global operator new again.
+     * @param resource the memory resource, nullptr for the global operator new.
+     */
+    explicit Specification(std::pmr::memory_resource* resource)
+        : mPacketTypes(paco::ResourceAllocator_T<paco::PacketType>(resource))
+    {
+        mFingerprint = 0;
+        mPower = 1;
+    }
+
+    Specification(const Specification& other) = default;
+    Specification& operator=(const Specification& other) = default;
+
+    /**
+     * @brief Specification move constructor.
+     * @param other the specification to move from, empty afterwards.
+     */
+    Specification(Specification&& other) noexcept
+        : mPacketTypes(std::move(other.mPacketTypes)), mFingerprint(other.mFingerprint), mPower(other.mPower)
+    {
+        other.clear_friend_class_only();
+    }
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the specification to move from, empty afterwards.
+     * @return this specification.
+     */
+    Specification& operator=(Specification&& other) noexcept
+    {
+        if(this != &other)
+        {
+            mPacketTypes = std::move(other.mPacketTypes);
+            mFingerprint = other.mFingerprint;
+            mPower = other.mPower;
 
+            other.clear_friend_class_only();
+        }
+
+        return *this;
     }
 
     /**
@@ -48,7 +104,7 @@ public:
      * @brief size returns the number of elements in this specification.
      * @return the number of elements in this specification.
      */
-    int size()
+    int size() const
     {
         return mPacketTypes.size();
     }
@@ -58,10 +114,10 @@ public:
      * @param description is the description of the object that is expected here.
      */
     template <class type>
-    void append(QString description = "")
+    void append(paco::String description = "")
     {
 
-        mPacketTypes.push_back(paco::PacketType_T<type>(description));
+        append_friend_class_only(paco::PacketType_T<type>(description));
     }
 
     /**
@@ -69,10 +125,10 @@ public:
      * @param description is the description of the object that is expected here.
      */
     template <class type>
-    void insert(int index, QString description = "")
+    void insert(int index, paco::String description = "")
     {
 
-        mPacketTypes.insert(mPacketTypes.begin() + index, paco::PacketType_T<type>(description));
+        insert_friend_class_only(index, paco::PacketType_T<type>(description));
     }
 
     /**
@@ -84,6 +140,7 @@ public:
         if(index >= 0 && index < mPacketTypes.size())
         {
             mPacketTypes.erase(mPacketTypes.begin() + index);
+            rehash();
         }
     }
 
@@ -92,16 +149,119 @@ public:
      * @param index is the index location.
      * @return the packet type at a certain index.
      */
-    paco::PacketType at(int index)
+    paco::PacketType at(int index) const
     {
         return mPacketTypes.at(index);
     }
 
+    /**
+     * @brief fingerprint returns a hash of the ordered packet types of this specification.
+     * The fingerprint is kept up to date on every modification, so reading it is free. Equal specifications
+     * always have equal fingerprints, different fingerprints always mean different specifications.
+     * It is computed from PacketTypeDescriptor::hash() and is therefore stable across processes.
+     * @return the fingerprint of this specification.
+     */
+    std::uint64_t fingerprint() const
+    {
+        return mFingerprint;
+    }
+
+    /**
+     * @brief equals checks if this specification has the same packet types in the same order as another one.
+     * Descriptions are not compared. Specifications with different fingerprints are rejected immediately,
+     * otherwise each element is compared by its type id.
+     * @param other the specification to compare with.
+     * @return true if both specifications match.
+     */
+    bool equals(const Specification& other) const
+    {
+        if(mFingerprint != other.mFingerprint || mPacketTypes.size() != other.mPacketTypes.size())
+        {
+            return false;
+        }
+
+        for(std::size_t i = 0; i < mPacketTypes.size(); i++)
+        {
+            if(mPacketTypes[i] != other.mPacketTypes[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
 private:
     void append_friend_class_only(paco::PacketType packetType)
     {
 
         mPacketTypes.push_back(packetType);
+        mFingerprint += packetType.descriptor()->hash() * mPower;
+        mPower *= FingerprintBase;
+    }
+
+    void insert_friend_class_only(int index, paco::PacketType packetType)
+    {
+        mPacketTypes.insert(mPacketTypes.begin() + index, packetType);
+        rehash();
+    }
+
+    void replace_friend_class_only(int index, paco::PacketType packetType)
+    {
+        paco::PacketType& old = mPacketTypes.at(index);
+        mFingerprint += (packetType.descriptor()->hash() - old.descriptor()->hash()) * power(index);
+        old = packetType;
+    }
+
+    void clear_friend_class_only()
+    {
+        mPacketTypes.clear();
+        mFingerprint = 0;
+        mPower = 1;
+    }
+
+    /**
+     * @brief FingerprintBase is the base of the polynomial fingerprint sum(hash(type_i) * FingerprintBase^i).
+     */
+    static const std::uint64_t FingerprintBase = 1099511628211ull;
+
+    /**
+     * @brief power computes FingerprintBase^exponent modulo 2^64.
+     * @param exponent the exponent.
+     * @return FingerprintBase^exponent.
+     */
+    static std::uint64_t power(int exponent)
+    {
+        std::uint64_t result = 1;
+        std::uint64_t base = FingerprintBase;
+
+        while(exponent > 0)
+        {
+            if(exponent & 1)
+            {
+                result *= base;
+            }
+
+            base *= base;
+            exponent >>= 1;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief rehash recomputes the fingerprint after the packet types have been shifted by insert or removeAt.
+     */
+    void rehash()
+    {
+        mFingerprint = 0;
+        mPower = 1;
+
+        for(std::size_t i = 0; i < mPacketTypes.size(); i++)
+        {
+            mFingerprint += mPacketTypes[i].descriptor()->hash() * mPower;
+            mPower *= FingerprintBase;
+        }
     }
 
 private:
@@ -109,10 +269,40 @@ private:
     /**
      * @brief mPacketTypes the list containing the packet types.
      */
-    std::vector<paco::PacketType> mPacketTypes;
+    std::vector<paco::PacketType, paco::ResourceAllocator_T<paco::PacketType> > mPacketTypes;
+
+    /**
+     * @brief mFingerprint the fingerprint of mPacketTypes, see fingerprint().
+     */
+    std::uint64_t mFingerprint;
+
+    /**
+     * @brief mPower is FingerprintBase^size(), the weight of the next appended packet type.
+     */
+    std::uint64_t mPower;
 
 };
 
+/**
+ * @brief operator == checks if two specifications have the same packet types.
+ * @param lhs
+ * @param rhs
+ * @return true if both specifications match.
+ */
+inline bool operator==(const Specification& lhs, const Specification& rhs)
+{
+    return lhs.equals(rhs);
+}
+
+/**
+ * @brief operator != checks if two specifications do NOT have the same packet types.
+ * @param lhs
+ * @param rhs
+ * @return true if both specifications do NOT match.
+ */
+inline bool operator!=(const Specification& lhs, const Specification& rhs)
+{ return !(lhs == rhs); }
+
 }
 
 #endif // CONTAINERSPECIFICATION_H
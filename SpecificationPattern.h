@@ -0,0 +1,628 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SPECIFICATION_PATTERN_H
+#define SPECIFICATION_PATTERN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "Container.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The SpecificationPattern class describes a set of specifications, like a regular expression over packet types.
+ * Every slot of a pattern either expects one packet type or accepts any type, and is required, optional or repeated:
+ *
+ *  paco::SpecificationPattern pattern;
+ *  pattern.append<int>();              // an int
+ *  pattern.appendAny();                // followed by any one object
+ *  pattern.appendOptional<double>();   // maybe a double
+ *  pattern.appendRepeated<QString>();  // and any number of strings
+ *
+ * appendRest() accepts any remaining objects, so SpecificationPattern::prefix(specification) matches all
+ * specifications that start with the given one. Patterns only compare type ids, descriptions are ignored.
+ */
+class SpecificationPattern
+{
+    friend class SpecificationRouter;
+
+public:
+
+    /**
+     * @brief The Quantifier enum tells how often a slot may occur.
+     */
+    enum Quantifier
+    {
+        One,
+        Optional,
+        Repeated
+    };
+
+    /**
+     * @brief SpecificationPattern constructor, the empty pattern only matches the empty specification.
+     */
+    SpecificationPattern()
+    {
+    }
+
+    /**
+     * @brief SpecificationPattern constructor, the pattern matches exactly the packet types of a specification.
+     * @param specification the expected specification.
+     */
+    explicit SpecificationPattern(const paco::Specification& specification)
+    {
+        for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+        {
+            appendSlot(specification.mPacketTypes[i].typeId(), One);
+        }
+    }
+
+    /**
+     * @brief prefix returns a pattern that matches all specifications starting with the packet types of a specification.
+     * @param specification the expected beginning.
+     * @return the pattern.
+     */
+    static SpecificationPattern prefix(const paco::Specification& specification)
+    {
+        SpecificationPattern pattern(specification);
+        pattern.appendRest();
+
+        return pattern;
+    }
+
+    /**
+     * @brief append<T> appends a slot that expects exactly one object of type T.
+     */
+    template <class T>
+    void append()
+    {
+        appendSlot(paco::PacketTypeRegistry::id<T>(), One);
+    }
+
+    /**
+     * @brief appendOptional<T> appends a slot that accepts zero or one object of type T.
+     */
+    template <class T>
+    void appendOptional()
+    {
+        appendSlot(paco::PacketTypeRegistry::id<T>(), Optional);
+    }
+
+    /**
+     * @brief appendRepeated<T> appends a slot that accepts any number of objects of type T, including none.
+     */
+    template <class T>
+    void appendRepeated()
+    {
+        appendSlot(paco::PacketTypeRegistry::id<T>(), Repeated);
+    }
+
+    /**
+     * @brief appendAny appends a slot that accepts objects of any type.
+     * @param quantifier how many objects the slot accepts.
+     */
+    void appendAny(Quantifier quantifier = One)
+    {
+        appendSlot(AnyType, quantifier);
+    }
+
+    /**
+     * @brief appendRest appends a slot that accepts any remaining objects, which turns the pattern into a prefix match.
+     */
+    void appendRest()
+    {
+        appendSlot(AnyType, Repeated);
+    }
+
+    /**
+     * @brief size returns the number of slots of this pattern.
+     * @return the number of slots.
+     */
+    int size() const
+    {
+        return mSlots.size();
+    }
+
+    /**
+     * @brief matches checks if a specification is matched by this pattern.
+     * Patterns that are routed often should be compiled into a SpecificationRouter instead.
+     * @param specification the specification to check.
+     * @return true if the pattern matches.
+     */
+    bool matches(const paco::Specification& specification) const
+    {
+        // the states are the slot positions that may be reached, position size() accepts
+        std::vector<char> states(mSlots.size() + 1, 0);
+        std::vector<char> next(mSlots.size() + 1, 0);
+
+        states[0] = 1;
+        close(states);
+
+        for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+        {
+            paco::TypeId id = specification.mPacketTypes[i].typeId();
+            bool alive = false;
+
+            std::fill(next.begin(), next.end(), 0);
+
+            for(std::size_t position = 0; position < mSlots.size(); position++)
+            {
+                int target = states[position] ? step(position, id) : -1;
+
+                if(target >= 0)
+                {
+                    next[target] = 1;
+                    alive = true;
+                }
+            }
+
+            if(!alive)
+            {
+                return false;
+            }
+
+            close(next);
+            states.swap(next);
+        }
+
+        return states[mSlots.size()] != 0;
+    }
+
+    /**
+     * @brief matches checks if the specification of a container is matched by this pattern.
+     * @param container the container to check.
+     * @return true if the pattern matches.
+     */
+    bool matches(const paco::Container& container) const
+    {
+        return matches(container.specification());
+    }
+
+private:
+
+    /**
+     * @brief AnyType is the type id of slots that accept any type.
+     */
+    static constexpr paco::TypeId AnyType = -1;
+
+    /**
+     * @brief The Slot struct is one slot of the pattern.
+     */
+    struct Slot
+    {
+        paco::TypeId type;
+        Quantifier quantifier;
+    };
+
+    void appendSlot(paco::TypeId type, Quantifier quantifier)
+    {
+        Slot slot;
+        slot.type = type;
+        slot.quantifier = quantifier;
+
+        mSlots.push_back(slot);
+    }
+
+    /**
+     * @brief step returns the position reached by consuming an object of a type at a position, or -1.
+     */
+    int step(std::size_t position, paco::TypeId id) const
+    {
+        const Slot& slot = mSlots[position];
+
+        if(slot.type != AnyType && slot.type != id)
+        {
+            return -1;
+        }
+
+        return slot.quantifier == Repeated ? position : position + 1;
+    }
+
+    /**
+     * @brief close adds the positions reached by skipping optional and repeated slots.
+     */
+    void close(std::vector<char>& states) const
+    {
+        for(std::size_t position = 0; position < mSlots.size(); position++)
+        {
+            if(states[position] && mSlots[position].quantifier != One)
+            {
+                states[position + 1] = 1;
+            }
+        }
+    }
+
+private:
+
+    /**
+     * @brief mSlots the slots of the pattern.
+     */
+    std::vector<Slot> mSlots;
+};
+
+
+/**
+ * @brief The SpecificationRouter class finds the first of many patterns that matches a container.
+ *
+ * All patterns are compiled into one deterministic automaton over type ids, so routing a container is a single
+ * pass over its packet types with one table lookup per object, no matter how many patterns have been added:
+ *
+ *  paco::SpecificationRouter router;
+ *  router.add(paco::SpecificationPattern(imageSpecification), [](paco::Container& c) { ... });
+ *  router.add(paco::SpecificationPattern::prefix(headerSpecification), [](paco::Container& c) { ... });
+ *  router.compile();
+ *
+ *  router.dispatch(container);
+ *
+ * If several patterns match, the one added first wins. compile() must be called after adding patterns,
+ * afterwards route() and dispatch() do not modify the router and may be called from several threads.
+ *
+ * The automaton is built by subset construction, which is linear in the number of patterns for exact and prefix
+ * patterns. Many overlapping optional or repeated slots of the same types can make it larger.
+ */
+class SpecificationRouter
+{
+public:
+
+    /**
+     * @brief Handler is called for the containers routed to a pattern.
+     */
+    typedef std::function<void(paco::Container&)> Handler;
+
+    /**
+     * @brief SpecificationRouter constructor.
+     */
+    SpecificationRouter()
+        : mCompiled(true), mWidth(1)
+    {
+        mTransitions.push_back(Dead);
+        mRoutes.push_back(-1);
+    }
+
+    /**
+     * @brief add adds a pattern.
+     * @param pattern the pattern.
+     * @param handler the handler called by dispatch(), may be empty.
+     * @return the route id of the pattern, the ids count up from 0 in the order the patterns are added.
+     */
+    int add(const paco::SpecificationPattern& pattern, Handler handler = Handler())
+    {
+        mPatterns.push_back(pattern);
+        mHandlers.push_back(handler);
+        mCompiled = false;
+
+        return mPatterns.size() - 1;
+    }
+
+    /**
+     * @brief size returns the number of patterns.
+     * @return the number of patterns.
+     */
+    int size() const
+    {
+        return mPatterns.size();
+    }
+
+    /**
+     * @brief compile builds the automaton of all patterns.
+     */
+    void compile()
+    {
+        if(mCompiled)
+        {
+            return;
+        }
+
+        buildColumns();
+
+        mTransitions.clear();
+        mRoutes.clear();
+
+        // a state of the automaton is the set of (pattern, position) pairs that may be reached
+        std::map<std::vector<int>, int> states;
+        std::vector<std::vector<int> > pending;
+
+        std::vector<int> start;
+        for(std::size_t p = 0; p < mPatterns.size(); p++)
+        {
+            start.push_back(mOffsets[p]);
+        }
+
+        state(closure(start), states, pending);
+
+        for(std::size_t s = 0; s < pending.size(); s++)
+        {
+            // pending grows while states are discovered, so the set is copied
+            std::vector<int> current = pending[s];
+
+            for(int column = 0; column < mWidth; column++)
+            {
+                std::vector<int> next;
+
+                for(std::size_t i = 0; i < current.size(); i++)
+                {
+                    int target = step(current[i], column);
+
+                    if(target >= 0)
+                    {
+                        next.push_back(target);
+                    }
+                }
+
+                mTransitions[s * mWidth + column] = next.empty() ? Dead : state(closure(next), states, pending);
+            }
+        }
+
+        mCompiled = true;
+    }
+
+    /**
+     * @brief route returns the first pattern that matches a specification.
+     * Throws std::logic_error if patterns have been added since the last compile().
+     * @param specification the specification.
+     * @return the route id of the pattern, or -1 if no pattern matches.
+     */
+    int route(const paco::Specification& specification) const
+    {
+        if(!mCompiled)
+        {
+            throw std::logic_error("paco::SpecificationRouter: compile() has not been called after adding a pattern");
+        }
+
+        int state = 0;
+        const int other = mWidth - 1;
+
+        for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+        {
+            paco::TypeId id = specification.mPacketTypes[i].typeId();
+            int column = id < (int)mColumns.size() ? mColumns[id] : other;
+
+            state = mTransitions[state * mWidth + column];
+
+            if(state == Dead)
+            {
+                return -1;
+            }
+        }
+
+        return mRoutes[state];
+    }
+
+    /**
+     * @brief route returns the first pattern that matches the specification of a container.
+     * @param container the container.
+     * @return the route id of the pattern, or -1 if no pattern matches.
+     */
+    int route(const paco::Container& container) const
+    {
+        return route(container.specification());
+    }
+
+    /**
+     * @brief dispatch calls the handler of the first pattern that matches a container.
+     * @param container the container.
+     * @return the route id of the pattern, or -1 if no pattern matches.
+     */
+    int dispatch(paco::Container& container) const
+    {
+        int id = route(container);
+
+        if(id >= 0 && mHandlers[id])
+        {
+            mHandlers[id](container);
+        }
+
+        return id;
+    }
+
+    /**
+     * @brief stateCount returns the number of states of the compiled automaton.
+     * @return the number of states.
+     */
+    int stateCount() const
+    {
+        return mRoutes.size();
+    }
+
+private:
+
+    /**
+     * @brief Dead is the transition into the state that no pattern can match anymore.
+     */
+    static constexpr int Dead = -1;
+
+    /**
+     * @brief buildColumns assigns a column of the transition table to every type id named by a pattern.
+     * All other type ids share the last column.
+     */
+    void buildColumns()
+    {
+        mColumns.clear();
+        mOffsets.clear();
+        mOwners.clear();
+        mWidth = 0;
+
+        for(std::size_t p = 0; p < mPatterns.size(); p++)
+        {
+            const std::vector<paco::SpecificationPattern::Slot>& slots = mPatterns[p].mSlots;
+
+            mOffsets.push_back(mOwners.size());
+
+            for(std::size_t i = 0; i < slots.size(); i++)
+            {
+                paco::TypeId type = slots[i].type;
+
+                if(type >= (int)mColumns.size())
+                {
+                    mColumns.resize(type + 1, -1);
+                }
+
+                if(type != paco::SpecificationPattern::AnyType && mColumns[type] < 0)
+                {
+                    mColumns[type] = mWidth++;
+                }
+            }
+
+            // one position per slot and one accepting position behind the last slot
+            mOwners.insert(mOwners.end(), slots.size() + 1, p);
+        }
+
+        int other = mWidth++;
+        mTypes.assign(mWidth, paco::SpecificationPattern::AnyType);
+
+        for(std::size_t type = 0; type < mColumns.size(); type++)
+        {
+            if(mColumns[type] < 0)
+            {
+                mColumns[type] = other;
+            }
+            else
+            {
+                mTypes[mColumns[type]] = type;
+            }
+        }
+    }
+
+    /**
+     * @brief slot returns the slot at a global position, or nullptr for the accepting position of a pattern.
+     */
+    const paco::SpecificationPattern::Slot* slot(int position) const
+    {
+        int pattern = mOwners[position];
+        std::size_t index = position - mOffsets[pattern];
+        const std::vector<paco::SpecificationPattern::Slot>& slots = mPatterns[pattern].mSlots;
+
+        return index < slots.size() ? &slots[index] : nullptr;
+    }
+
+    /**
+     * @brief step returns the global position reached by consuming an object of a column, or -1.
+     */
+    int step(int position, int column) const
+    {
+        const paco::SpecificationPattern::Slot* current = slot(position);
+
+        if(current == nullptr || (current->type != paco::SpecificationPattern::AnyType && current->type != mTypes[column]))
+        {
+            return -1;
+        }
+
+        return current->quantifier == paco::SpecificationPattern::Repeated ? position : position + 1;
+    }
+
+    /**
+     * @brief closure adds the positions reached by skipping optional and repeated slots, sorted and unique.
+     */
+    std::vector<int> closure(std::vector<int> positions) const
+    {
+        for(std::size_t i = 0; i < positions.size(); i++)
+        {
+            const paco::SpecificationPattern::Slot* current = slot(positions[i]);
+
+            if(current != nullptr && current->quantifier != paco::SpecificationPattern::One)
+            {
+                positions.push_back(positions[i] + 1);
+            }
+        }
+
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+        return positions;
+    }
+
+    /**
+     * @brief state returns the id of the state of a set of positions and creates it if needed.
+     */
+    int state(const std::vector<int>& positions, std::map<std::vector<int>, int>& states,
+              std::vector<std::vector<int> >& pending)
+    {
+        std::map<std::vector<int>, int>::iterator it = states.find(positions);
+
+        if(it != states.end())
+        {
+            return it->second;
+        }
+
+        int id = pending.size();
+        int route = -1;
+
+        for(std::size_t i = 0; i < positions.size() && route < 0; i++)
+        {
+            // positions are sorted by pattern, so the first accepting one is the pattern added first
+            if(slot(positions[i]) == nullptr)
+            {
+                route = mOwners[positions[i]];
+            }
+        }
+
+        states[positions] = id;
+        pending.push_back(positions);
+        mTransitions.resize(pending.size() * mWidth, Dead);
+        mRoutes.push_back(route);
+
+        return id;
+    }
+
+private:
+
+    std::vector<paco::SpecificationPattern> mPatterns;
+    std::vector<Handler> mHandlers;
+
+    bool mCompiled;
+
+    /**
+     * @brief mColumns the column of the transition table of every type id.
+     */
+    std::vector<int> mColumns;
+
+    /**
+     * @brief mTypes the type id of every column, AnyType for the last column of all other types.
+     */
+    std::vector<paco::TypeId> mTypes;
+
+    /**
+     * @brief mWidth the number of columns of the transition table.
+     */
+    int mWidth;
+
+    /**
+     * @brief mOffsets the first global position of every pattern.
+     */
+    std::vector<int> mOffsets;
+
+    /**
+     * @brief mOwners the pattern of every global position.
+     */
+    std::vector<int> mOwners;
+
+    /**
+     * @brief mTransitions the transition table, mWidth columns per state.
+     */
+    std::vector<int> mTransitions;
+
+    /**
+     * @brief mRoutes the route id accepted in every state, or -1.
+     */
+    std::vector<int> mRoutes;
+};
+
+}
+
+#endif // SPECIFICATION_PATTERN_H
@@ -0,0 +1,270 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef STATIC_CONTAINER_H
+#define STATIC_CONTAINER_H
+
+#include <cstddef>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+
+#include "Container.h"
+#include "Packet.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The IndexSequence_T template struct is a compile time list of indices, like std::index_sequence of C++14.
+ */
+template <std::size_t... Is>
+struct IndexSequence_T
+{
+};
+
+/**
+ * @brief The MakeIndexSequence_T template struct creates IndexSequence_T<0, ..., N-1>.
+ */
+template <std::size_t N, std::size_t... Is>
+struct MakeIndexSequence_T : MakeIndexSequence_T<N - 1, N - 1, Is...>
+{
+};
+
+template <std::size_t... Is>
+struct MakeIndexSequence_T<0, Is...>
+{
+    typedef IndexSequence_T<Is...> type;
+};
+
+
+/**
+ * @brief The StaticContainer template class is a container whose element types are fixed at compile time.
+ *
+ * The objects are stored directly in a std::tuple, so get<I>() is a plain member access without virtual calls,
+ * RTTI or type checks, and the compiler can inline everything. The specification is derived from Ts... .
+ *
+ * At the boundary to dynamic code a Container is converted with from(), which checks the specification once
+ * and then moves or copies the objects without any further checks, and back with toContainer():
+ *
+ *  typedef paco::StaticContainer<int, double, QList<int>*> Record;
+ *
+ *  Record record = Record::from(std::move(container)); // throws std::bad_cast on a specification mismatch
+ *  record.get<1>() *= 2.0;
+ *  paco::Container result = std::move(record).toContainer();
+ */
+template <class... Ts>
+class StaticContainer
+{
+private:
+
+    typedef typename paco::MakeIndexSequence_T<sizeof...(Ts)>::type Indices;
+
+public:
+
+    /**
+     * @brief type<I> is the type of the object at index I.
+     */
+    template <std::size_t I>
+    using type = typename std::tuple_element<I, std::tuple<Ts...> >::type;
+
+    /**
+     * @brief StaticContainer default constructor, value initializes all objects.
+     */
+    StaticContainer()
+        : mData()
+    {
+    }
+
+    /**
+     * @brief StaticContainer constructs the container from its objects.
+     * @param values the objects, pass rvalues to move them into the container.
+     */
+    explicit StaticContainer(Ts... values)
+        : mData(std::move(values)...)
+    {
+    }
+
+    /**
+     * @brief size returns the number of elements, known at compile time.
+     * @return the number of elements.
+     */
+    static constexpr int size()
+    {
+        return sizeof...(Ts);
+    }
+
+    /**
+     * @brief get<I> returns the object at index I, checked at compile time.
+     * @return a reference to the object at index I.
+     */
+    template <std::size_t I>
+    type<I>& get()
+    {
+        return std::get<I>(mData);
+    }
+
+    /**
+     * @brief get<I> returns the object at index I, checked at compile time.
+     * @return a const reference to the object at index I.
+     */
+    template <std::size_t I>
+    const type<I>& get() const
+    {
+        return std::get<I>(mData);
+    }
+
+    /**
+     * @brief tuple returns the underlying tuple, e.g. for std::tie.
+     * @return the tuple of all objects.
+     */
+    std::tuple<Ts...>& tuple()
+    {
+        return mData;
+    }
+
+    /**
+     * @brief specification returns the specification derived from Ts... . It is built once per instantiation.
+     * @return the specification of every StaticContainer<Ts...>.
+     */
+    static const paco::Specification& specification()
+    {
+        static const paco::Specification specification = createSpecification();
+        return specification;
+    }
+
+    /**
+     * @brief matches checks if a dynamic container can be converted into this static container.
+     * @param container the dynamic container.
+     * @return true if the specification of the container equals specification().
+     */
+    static bool matches(const paco::Container& container)
+    {
+        return container.matches(specification());
+    }
+
+    /**
+     * @brief from moves the objects of a dynamic container into a new static container.
+     * The specification is checked once, afterwards the objects are moved without any checks.
+     * @param container the dynamic container, its objects are moved from.
+     * @return the static container. If the specifications do not match then a std::bad_cast is thrown.
+     */
+    static StaticContainer from(paco::Container&& container)
+    {
+        if(!matches(container))
+        {
+            throw std::bad_cast();
+        }
+
+        return StaticContainer(container, Indices(), std::true_type());
+    }
+
+    /**
+     * @brief from copies the objects of a dynamic container into a new static container.
+     * The specification is checked once, afterwards the objects are copied without any checks.
+     * @param container the dynamic container.
+     * @return the static container. If the specifications do not match then a std::bad_cast is thrown.
+     */
+    static StaticContainer from(const paco::Container& container)
+    {
+        if(!matches(container))
+        {
+            throw std::bad_cast();
+        }
+
+        return StaticContainer(const_cast<paco::Container&>(container), Indices(), std::false_type());
+    }
+
+    /**
+     * @brief toContainer copies the objects into a new dynamic container.
+     * @return the dynamic container.
+     */
+    paco::Container toContainer() const &
+    {
+        paco::Container container;
+        appendTo(container, Indices());
+
+        return container;
+    }
+
+    /**
+     * @brief toContainer moves the objects into a new dynamic container.
+     * @return the dynamic container.
+     */
+    paco::Container toContainer() &&
+    {
+        paco::Container container;
+        moveTo(container, Indices());
+
+        return container;
+    }
+
+private:
+
+    /**
+     * @brief StaticContainer constructs the objects from the packets of a container that has already been checked.
+     */
+    template <std::size_t... Is>
+    StaticContainer(paco::Container& container, paco::IndexSequence_T<Is...>, std::true_type)
+        : mData(std::move(static_cast<paco::Packet_T<type<Is> >*>(container.at(Is))->dataRef())...)
+    {
+    }
+
+    template <std::size_t... Is>
+    StaticContainer(paco::Container& container, paco::IndexSequence_T<Is...>, std::false_type)
+        : mData(static_cast<const paco::Packet_T<type<Is> >*>(container.at(Is))->dataRef()...)
+    {
+    }
+
+    /**
+     * @brief createSpecification builds the specification from Ts... .
+     */
+    static paco::Specification createSpecification()
+    {
+        paco::Specification specification;
+
+        int expand[] = {0, (specification.append<Ts>(), 0)...};
+        (void)expand;
+
+        return specification;
+    }
+
+    /**
+     * @brief appendTo appends copies of all objects to a container.
+     */
+    template <std::size_t... Is>
+    void appendTo(paco::Container& container, paco::IndexSequence_T<Is...>) const
+    {
+        int expand[] = {0, (container.append<type<Is> >(std::get<Is>(mData)), 0)...};
+        (void)expand;
+    }
+
+    /**
+     * @brief moveTo moves all objects to a container.
+     */
+    template <std::size_t... Is>
+    void moveTo(paco::Container& container, paco::IndexSequence_T<Is...>)
+    {
+        int expand[] = {0, (container.append<type<Is> >(std::move(std::get<Is>(mData))), 0)...};
+        (void)expand;
+    }
+
+private:
+
+    /**
+     * @brief mData the objects.
+     */
+    std::tuple<Ts...> mData;
+};
+
+}
+
+#endif // STATIC_CONTAINER_H
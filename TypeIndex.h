@@ -0,0 +1,532 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef TYPE_INDEX_H
+#define TYPE_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MemoryResource.h"
+#include "Packet.h"
+#include "PacketSlot.h"
+#include "PacketTypeRegistry.h"
+#include "Specification.h"
+
+namespace paco
+{
+
+/**
+ * @brief The TypeIndex class keeps the positions of the elements of a container per type id.
+ * The positions of each type are kept in ascending order, so the first element of a type, the number of elements
+ * of a type and all elements of a type are found without looking at any other element.
+ *
+ * The lists are kept in a small vector sorted by type id that only holds the types of the container, so the index
+ * does not grow with the number of types registered in the process. Containers with up to Threshold elements
+ * have no lists at all: their lookups scan the type ids of the specification, which needs no memory and is as fast
+ * for so few elements. The lists are built from the specification when the container grows beyond Threshold.
+ *
+ * Appending is a push_back onto the list of the type. Inserting and removing shift the positions behind the
+ * modified element, which is as expensive as shifting the elements themselves.
+ */
+class TypeIndex
+{
+public:
+
+    /**
+     * @brief Positions is the list of the positions of one type.
+     */
+    typedef std::vector<int, paco::ResourceAllocator_T<int> > Positions;
+
+    /**
+     * @brief Threshold is the number of elements up to which no lists are built.
+     */
+    static const int Threshold = 16;
+
+    /**
+     * @brief TypeIndex constructor.
+     * @param resource the memory resource of the lists, nullptr for the global operator new.
+     */
+    explicit TypeIndex(std::pmr::memory_resource* resource = nullptr)
+        : mEntries(paco::ResourceAllocator_T<Entry>(resource)), mBuilt(false)
+    {
+    }
+
+    TypeIndex(const TypeIndex& other) = default;
+    TypeIndex& operator=(const TypeIndex& other) = default;
+
+    /**
+     * @brief TypeIndex move constructor.
+     * @param other the index to move from, empty and not built afterwards.
+     */
+    TypeIndex(TypeIndex&& other) noexcept
+        : mEntries(std::move(other.mEntries)), mBuilt(other.mBuilt)
+    {
+        other.mEntries.clear();
+        other.mBuilt = false;
+    }
+
+    /**
+     * @brief operator= move assignment.
+     * @param other the index to move from, empty and not built afterwards.
+     * @return this index.
+     */
+    TypeIndex& operator=(TypeIndex&& other) noexcept
+    {
+        if(this != &other)
+        {
+            mEntries = std::move(other.mEntries);
+            mBuilt = other.mBuilt;
+
+            other.mEntries.clear();
+            other.mBuilt = false;
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief isBuilt checks if the lists have been built, which is the case once the container has had more than
+     * Threshold elements.
+     * @return true if positions() can be used, false if lookups scan the specification.
+     */
+    bool isBuilt() const
+    {
+        return mBuilt;
+    }
+
+    /**
+     * @brief positions returns the ascending positions of the elements of a type, only if isBuilt().
+     * @param id the type id.
+     * @return the positions, or nullptr if the type has never been in the container.
+     */
+    const Positions* positions(paco::TypeId id) const
+    {
+        const Entry* entry = find(id);
+
+        return entry != nullptr ? &entry->positions : nullptr;
+    }
+
+    /**
+     * @brief count returns the number of elements of a type.
+     * @param id the type id.
+     * @param specification the specification of the container.
+     * @return the number of elements of the type.
+     */
+    int count(paco::TypeId id, const paco::Specification& specification) const
+    {
+        if(!mBuilt)
+        {
+            int count = 0;
+
+            for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+            {
+                count += specification.mPacketTypes[i].typeId() == id;
+            }
+
+            return count;
+        }
+
+        const Positions* list = positions(id);
+
+        return list != nullptr ? list->size() : 0;
+    }
+
+    /**
+     * @brief first returns the position of the first element of a type.
+     * @param id the type id.
+     * @param specification the specification of the container.
+     * @return the position, or -1 if there is no element of the type.
+     */
+    int first(paco::TypeId id, const paco::Specification& specification) const
+    {
+        if(!mBuilt)
+        {
+            for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+            {
+                if(specification.mPacketTypes[i].typeId() == id)
+                {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+
+        const Positions* list = positions(id);
+
+        return list != nullptr && !list->empty() ? list->front() : -1;
+    }
+
+    /**
+     * @brief append adds an element that has been appended behind all other elements.
+     * @param id the type id of the element.
+     * @param position the position of the element.
+     * @param specification the specification of the container, already holding the element.
+     */
+    void append(paco::TypeId id, int position, const paco::Specification& specification)
+    {
+        if(mBuilt)
+        {
+            list(id).push_back(position);
+        }
+        else if(specification.size() > Threshold)
+        {
+            build(specification);
+        }
+    }
+
+    /**
+     * @brief insert adds an element at any position. Call shift() first if the element moved others.
+     * @param id the type id of the element.
+     * @param position the position of the element.
+     * @param specification the specification of the container, already holding the element.
+     */
+    void insert(paco::TypeId id, int position, const paco::Specification& specification)
+    {
+        if(mBuilt)
+        {
+            Positions& positions = list(id);
+            positions.insert(std::lower_bound(positions.begin(), positions.end(), position), position);
+        }
+        else if(specification.size() > Threshold)
+        {
+            build(specification);
+        }
+    }
+
+    /**
+     * @brief erase removes an element. Call shift() afterwards if removing the element moves others.
+     * @param id the type id of the element.
+     * @param position the position of the element.
+     */
+    void erase(paco::TypeId id, int position)
+    {
+        Entry* entry = find(id);
+
+        if(entry != nullptr)
+        {
+            Positions& positions = entry->positions;
+            Positions::iterator it = std::lower_bound(positions.begin(), positions.end(), position);
+
+            if(it != positions.end() && *it == position)
+            {
+                positions.erase(it);
+            }
+        }
+    }
+
+    /**
+     * @brief shift adds delta to every position at or after first, used when elements are inserted or removed.
+     * @param first the first position to shift.
+     * @param delta the distance, +1 for an insert, -1 for a removal.
+     */
+    void shift(int first, int delta)
+    {
+        for(std::size_t i = 0; i < mEntries.size(); i++)
+        {
+            Positions& positions = mEntries[i].positions;
+
+            for(Positions::iterator it = std::lower_bound(positions.begin(), positions.end(), first); it != positions.end(); ++it)
+            {
+                *it += delta;
+            }
+        }
+    }
+
+    /**
+     * @brief clear removes all elements and keeps the lists for reuse.
+     */
+    void clear()
+    {
+        for(std::size_t i = 0; i < mEntries.size(); i++)
+        {
+            mEntries[i].positions.clear();
+        }
+    }
+
+    /**
+     * @brief memoryUsage returns the memory of the lists in bytes.
+     * @return the memory of the lists in bytes.
+     */
+    std::size_t memoryUsage() const
+    {
+        std::size_t bytes = mEntries.capacity() * sizeof(Entry);
+
+        for(std::size_t i = 0; i < mEntries.size(); i++)
+        {
+            bytes += mEntries[i].positions.capacity() * sizeof(int);
+        }
+
+        return bytes;
+    }
+
+private:
+
+    /**
+     * @brief The Entry struct is the list of one type id.
+     */
+    struct Entry
+    {
+        Entry(paco::TypeId id, const paco::ResourceAllocator_T<Entry>& allocator)
+            : id(id), positions(allocator)
+        {
+        }
+
+        paco::TypeId id;
+        Positions positions;
+    };
+
+    typedef std::vector<Entry, paco::ResourceAllocator_T<Entry> > Entries;
+
+    /**
+     * @brief lowerBound returns the first entry with a type id not less than id.
+     */
+    Entries::const_iterator lowerBound(paco::TypeId id) const
+    {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), id, [](const Entry& entry, paco::TypeId id)
+        {
+            return entry.id < id;
+        });
+    }
+
+    /**
+     * @brief find returns the entry of a type id, or nullptr.
+     */
+    const Entry* find(paco::TypeId id) const
+    {
+        Entries::const_iterator it = lowerBound(id);
+
+        return it != mEntries.end() && it->id == id ? &*it : nullptr;
+    }
+
+    Entry* find(paco::TypeId id)
+    {
+        return const_cast<Entry*>(static_cast<const TypeIndex*>(this)->find(id));
+    }
+
+    /**
+     * @brief list returns the list of a type id and creates it if needed.
+     */
+    Positions& list(paco::TypeId id)
+    {
+        Entries::const_iterator it = lowerBound(id);
+
+        if(it == mEntries.end() || it->id != id)
+        {
+            // constructed with the allocator of the index, the list of a new type is empty
+            it = mEntries.emplace(it, id, mEntries.get_allocator());
+        }
+
+        return mEntries[it - mEntries.cbegin()].positions;
+    }
+
+    /**
+     * @brief build builds the lists from the type ids of the specification.
+     */
+    void build(const paco::Specification& specification)
+    {
+        mBuilt = true;
+
+        for(std::size_t i = 0; i < specification.mPacketTypes.size(); i++)
+        {
+            list(specification.mPacketTypes[i].typeId()).push_back(i);
+        }
+    }
+
+private:
+
+    /**
+     * @brief mEntries the lists of the types of the container, sorted by type id.
+     */
+    Entries mEntries;
+
+    /**
+     * @brief mBuilt is true once the lists are maintained, see Threshold.
+     */
+    bool mBuilt;
+};
+
+
+/**
+ * @brief The TypedRange_T template class is the range of all elements of type T of a container, see Container::range<T>().
+ * It only refers to the container and yields references to the objects in order, without any further type checks.
+ * Like iterators of a std::vector, the range is invalidated when the container is modified.
+ *
+ * The range refers to the positions kept by the TypeIndex. For containers without built lists, see
+ * TypeIndex::Threshold, it collects the positions of the objects into a small buffer of its own instead.
+ * @tparam T the type of the elements, const T for a range of a const container.
+ */
+template <class T>
+class TypedRange_T
+{
+public:
+
+    typedef typename std::remove_const<T>::type ValueType;
+    typedef typename std::conditional<std::is_const<T>::value, const paco::PacketSlot, paco::PacketSlot>::type SlotType;
+    typedef typename std::conditional<std::is_const<T>::value, const paco::Packet_T<ValueType>, paco::Packet_T<ValueType> >::type PacketType;
+
+    /**
+     * @brief The Iterator class is a forward iterator over the objects of the range.
+     */
+    class Iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ValueType value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        Iterator(SlotType* slots, const int* position)
+            : mSlots(slots), mPosition(position)
+        {
+        }
+
+        T& operator*() const
+        {
+            return static_cast<PacketType*>(mSlots[*mPosition].packet())->dataRef();
+        }
+
+        T* operator->() const
+        {
+            return &**this;
+        }
+
+        Iterator& operator++()
+        {
+            ++mPosition;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++mPosition;
+            return previous;
+        }
+
+        /**
+         * @brief index returns the position of the current object in the container.
+         * @return the index of the object.
+         */
+        int index() const
+        {
+            return *mPosition;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return mPosition == other.mPosition;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return mPosition != other.mPosition;
+        }
+
+    private:
+
+        SlotType* mSlots;
+        const int* mPosition;
+    };
+
+    /**
+     * @brief TypedRange_T constructor.
+     * @param slots the slots of the container.
+     * @param positions the positions of the elements of type T, or nullptr for an empty range.
+     */
+    TypedRange_T(SlotType* slots, const paco::TypeIndex::Positions* positions)
+        : mSlots(slots),
+          mPositions(positions != nullptr ? positions->data() : nullptr),
+          mSize(positions != nullptr ? positions->size() : 0)
+    {
+    }
+
+    /**
+     * @brief TypedRange_T constructor for a container without built lists, collects the positions of the type.
+     * @param slots the slots of the container.
+     * @param specification the specification of the container, with at most TypeIndex::Threshold elements.
+     * @param id the type id of T.
+     */
+    TypedRange_T(SlotType* slots, const paco::Specification& specification, paco::TypeId id)
+        : mSlots(slots), mPositions(nullptr), mSize(0)
+    {
+        for(int i = 0; i < specification.size() && i < paco::TypeIndex::Threshold; i++)
+        {
+            if(specification.at(i).typeId() == id)
+            {
+                mBuffer[mSize++] = i;
+            }
+        }
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(mSlots, data());
+    }
+
+    Iterator end() const
+    {
+        return Iterator(mSlots, data() + mSize);
+    }
+
+    /**
+     * @brief size returns the number of objects in the range.
+     * @return the number of objects.
+     */
+    int size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief isEmpty checks if the range has no objects.
+     * @return true if the range is empty.
+     */
+    bool isEmpty() const
+    {
+        return mSize == 0;
+    }
+
+    /**
+     * @brief operator[] returns the i-th object of the range.
+     * @param i the position in the range, not in the container.
+     * @return the object.
+     */
+    T& operator[](int i) const
+    {
+        return static_cast<PacketType*>(mSlots[data()[i]].packet())->dataRef();
+    }
+
+private:
+
+    /**
+     * @brief data returns the positions, either those of the TypeIndex or the own buffer.
+     */
+    const int* data() const
+    {
+        return mPositions != nullptr ? mPositions : mBuffer;
+    }
+
+    SlotType* mSlots;
+    const int* mPositions;
+    int mSize;
+    int mBuffer[paco::TypeIndex::Threshold];
+};
+
+}
+
+#endif // TYPE_INDEX_H
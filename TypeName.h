@@ -0,0 +1,282 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef TYPE_NAME_H
+#define TYPE_NAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace paco
+{
+
+/**
+ * @brief fnv1a computes the 64 bit FNV-1a hash of a string at compile time.
+ * @param text the string.
+ * @return the hash of the string.
+ */
+constexpr std::uint64_t fnv1a(std::string_view text)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for(std::size_t i = 0; i < text.size(); i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+namespace detail
+{
+
+/**
+ * @brief signature returns the signature of this function as the compiler prints it, which contains the name of T.
+ */
+template <class T>
+constexpr std::string_view signature()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+
+/**
+ * @brief rawTypeName extracts the name of T from signature<T>().
+ *
+ * - gcc:   "constexpr std::string_view paco::detail::signature() [with T = int; std::string_view = ...]"
+ * - clang: "std::string_view paco::detail::signature() [T = int]"
+ * - msvc:  "class std::basic_string_view<...> __cdecl paco::detail::signature<int>(void)"
+ */
+constexpr std::string_view rawTypeName(std::string_view signature)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    std::size_t begin = signature.find("signature<") + 10;
+    std::size_t end = signature.rfind(">(void)");
+#else
+    std::size_t begin = signature.find("T = ") + 4;
+    std::size_t end = signature.find(';', begin);
+
+    if(end == std::string_view::npos)
+    {
+        end = signature.rfind(']');
+    }
+#endif
+
+    return signature.substr(begin, end - begin);
+}
+
+/**
+ * @brief startsWith checks if text contains prefix at a position.
+ */
+constexpr bool startsWith(std::string_view text, std::size_t position, std::string_view prefix)
+{
+    return position <= text.size() && text.substr(position).substr(0, prefix.size()) == prefix;
+}
+
+/**
+ * @brief isIdentifier checks if a character can be part of an identifier.
+ */
+constexpr bool isIdentifier(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+ * @brief skipSpaces returns the first position at or after position that is not a space.
+ */
+constexpr std::size_t skipSpaces(std::string_view text, std::size_t position)
+{
+    while(position < text.size() && text[position] == ' ')
+    {
+        position++;
+    }
+
+    return position;
+}
+
+/**
+ * @brief skipKeyword returns the position after an elaborated type keyword ("class ", "struct ", ...) at position,
+ * or position if there is none.
+ */
+constexpr std::size_t skipKeyword(std::string_view text, std::size_t position)
+{
+    if(position > 0 && isIdentifier(text[position - 1]))
+    {
+        return position;
+    }
+
+    const std::string_view keywords[] = {"class ", "struct ", "enum ", "union "};
+
+    for(std::size_t k = 0; k < 4; k++)
+    {
+        if(startsWith(text, position, keywords[k]))
+        {
+            return position + keywords[k].size();
+        }
+    }
+
+    return position;
+}
+
+/**
+ * @brief skipDefaultArgument returns the position after a defaulted template argument (",std::allocator<...>" or
+ * ",std::char_traits<...>") starting at the comma at position, or position if there is none.
+ * Only msvc prints these arguments, skipping them gives the same names as gcc and clang.
+ */
+constexpr std::size_t skipDefaultArgument(std::string_view text, std::size_t position)
+{
+    std::size_t next = skipSpaces(text, position + 1);
+    next = skipKeyword(text, next);
+
+    if(!startsWith(text, next, "std::allocator<") && !startsWith(text, next, "std::char_traits<"))
+    {
+        return position;
+    }
+
+    int depth = 0;
+
+    for(; next < text.size(); next++)
+    {
+        if(text[next] == '<')
+        {
+            depth++;
+        }
+        else if(text[next] == '>')
+        {
+            depth--;
+
+            if(depth == 0)
+            {
+                return next + 1;
+            }
+        }
+    }
+
+    return position;
+}
+
+/**
+ * @brief The NormalizedName_T template struct holds a normalized type name in a fixed size buffer.
+ */
+template <std::size_t N>
+struct NormalizedName_T
+{
+    char data[N + 1];
+    std::size_t size;
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view(data, size);
+    }
+};
+
+/**
+ * @brief normalize turns a raw type name into the portable form "<name>":
+ * elaborated type keywords, spaces that do not separate two words, defaulted allocator and char_traits arguments
+ * and the inline namespaces std::__cxx11:: and std::__1:: of libstdc++ and libc++ are removed.
+ * @return the normalized name.
+ */
+template <std::size_t N>
+constexpr NormalizedName_T<N> normalize(std::string_view raw)
+{
+    NormalizedName_T<N> name = {};
+    std::size_t size = 0;
+    std::size_t i = 0;
+
+    name.data[size++] = '<';
+
+    while(i < raw.size())
+    {
+        std::size_t skipped = skipKeyword(raw, i);
+
+        if(skipped != i)
+        {
+            i = skipped;
+        }
+        else if(startsWith(raw, i, "std::__cxx11::"))
+        {
+            i += 14;
+            name.data[size++] = 's';
+            name.data[size++] = 't';
+            name.data[size++] = 'd';
+            name.data[size++] = ':';
+            name.data[size++] = ':';
+        }
+        else if(startsWith(raw, i, "std::__1::"))
+        {
+            i += 10;
+            name.data[size++] = 's';
+            name.data[size++] = 't';
+            name.data[size++] = 'd';
+            name.data[size++] = ':';
+            name.data[size++] = ':';
+        }
+        else if(raw[i] == ',' && skipDefaultArgument(raw, i) != i)
+        {
+            i = skipDefaultArgument(raw, i);
+        }
+        else if(raw[i] == ' ' && !(size > 1 && isIdentifier(name.data[size - 1]) && i + 1 < raw.size() && isIdentifier(raw[i + 1])))
+        {
+            i++;
+        }
+        else
+        {
+            name.data[size++] = raw[i++];
+        }
+    }
+
+    name.data[size++] = '>';
+    name.data[size] = '\0';
+    name.size = size;
+
+    return name;
+}
+
+/**
+ * @brief The TypeName_T template struct computes the normalized name of T once, at compile time.
+ */
+template <class T>
+struct TypeName_T
+{
+    static constexpr std::string_view raw = rawTypeName(signature<T>());
+    static constexpr NormalizedName_T<raw.size() + 2> normalized = normalize<raw.size() + 2>(raw);
+};
+
+}
+
+/**
+ * @brief typeName<T> returns the normalized name of T, e.g. "<QList<int>*>", computed at compile time.
+ * The name does not depend on RTTI and is the same for every process built with the same standard library.
+ * @return the normalized name of T.
+ */
+template <class T>
+constexpr std::string_view typeName()
+{
+    return detail::TypeName_T<T>::normalized.view();
+}
+
+/**
+ * @brief typeHash<T> returns the FNV-1a hash of typeName<T>(), computed at compile time.
+ * @return the hash of the name of T.
+ */
+template <class T>
+constexpr std::uint64_t typeHash()
+{
+    return paco::fnv1a(typeName<T>());
+}
+
+}
+
+#endif // TYPE_NAME_H
@@ -0,0 +1,319 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACO_BENCHMARK_H
+#define PACO_BENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace paco
+{
+namespace benchmark
+{
+
+/**
+ * @brief allocationCounter counts the calls of the global operator new, including the aligned overloads, see main.cpp.
+ * @return the process wide allocation counter.
+ */
+std::atomic<std::size_t>& allocationCounter();
+
+/**
+ * @brief keep prevents the compiler from optimizing away the computation of a value.
+ * @param value the value to keep.
+ */
+template <class T>
+inline void keep(const T& value)
+{
+#if __GNUC__
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief budget returns how often an operation on n elements has to be repeated to reach a total amount of work.
+ * @param n the number of elements per repetition.
+ * @param total the total number of elements.
+ * @return the number of repetitions, at least 1.
+ */
+inline std::size_t budget(std::size_t n, std::size_t total)
+{
+    return std::max<std::size_t>(1, total / std::max<std::size_t>(1, n));
+}
+
+
+/**
+ * @brief The Timer class measures the time and the number of allocations of the timed sections of one run.
+ * A run may start and stop the timer several times, e.g. to exclude its setup.
+ */
+class Timer
+{
+public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief Timer constructor.
+     */
+    Timer()
+        : mElapsed(0), mAllocations(0), mStartAllocations(0)
+    {
+    }
+
+    /**
+     * @brief start starts a timed section.
+     */
+    void start()
+    {
+        mStartAllocations = allocationCounter().load(std::memory_order_relaxed);
+        mStart = Clock::now();
+    }
+
+    /**
+     * @brief stop ends a timed section.
+     */
+    void stop()
+    {
+        Clock::time_point end = Clock::now();
+
+        mElapsed += std::chrono::duration<double, std::nano>(end - mStart).count();
+        mAllocations += allocationCounter().load(std::memory_order_relaxed) - mStartAllocations;
+    }
+
+    /**
+     * @brief elapsed returns the time of all timed sections.
+     * @return the time in nanoseconds.
+     */
+    double elapsed() const
+    {
+        return mElapsed;
+    }
+
+    /**
+     * @brief allocations returns the number of allocations of all timed sections.
+     * @return the number of allocations.
+     */
+    std::size_t allocations() const
+    {
+        return mAllocations;
+    }
+
+private:
+
+    Clock::time_point mStart;
+    double mElapsed;
+    std::size_t mAllocations;
+    std::size_t mStartAllocations;
+};
+
+
+/**
+ * @brief The Result struct is one row of the benchmark output.
+ */
+struct Result
+{
+    std::string suite;
+    std::string operation;
+    std::string payload;
+    std::size_t size;
+    double nsPerOp;
+    double allocationsPerOp;
+
+    /**
+     * @brief key identifies the benchmark case, used to match results against a baseline.
+     * @return "suite/operation/payload/size".
+     */
+    std::string key() const
+    {
+        return suite + "/" + operation + "/" + payload + "/" + std::to_string(size);
+    }
+};
+
+
+/**
+ * @brief The Options struct holds the command line options that select and scale the benchmark cases.
+ */
+struct Options
+{
+    Options()
+        : maxSize(1000000), repetitions(5)
+    {
+    }
+
+    /**
+     * @brief filter only cases whose key contains this string are run.
+     */
+    std::string filter;
+
+    /**
+     * @brief maxSize the largest container size of the matrix.
+     */
+    std::size_t maxSize;
+
+    /**
+     * @brief repetitions the number of runs per case, the median is reported.
+     */
+    int repetitions;
+};
+
+
+/**
+ * @brief The Runner class runs benchmark cases and reports their results.
+ */
+class Runner
+{
+public:
+
+    typedef std::function<void(const Result&)> Listener;
+
+    /**
+     * @brief Runner constructor.
+     * @param options the options.
+     * @param listener called for every result, as soon as it is available.
+     */
+    Runner(const Options& options, const Listener& listener)
+        : mOptions(options), mListener(listener)
+    {
+    }
+
+    /**
+     * @brief sizes returns the container sizes of the matrix, 1 to maxSize in powers of ten.
+     * @return the container sizes.
+     */
+    std::vector<std::size_t> sizes() const
+    {
+        std::vector<std::size_t> sizes;
+
+        for(std::size_t size = 1; size <= mOptions.maxSize && size <= 1000000; size *= 10)
+        {
+            sizes.push_back(size);
+        }
+
+        return sizes;
+    }
+
+    /**
+     * @brief enabled checks if a case passes the filter.
+     * @return true if the case has to be run.
+     */
+    bool enabled(const std::string& suite, const std::string& operation, const std::string& payload, std::size_t size) const
+    {
+        Result result;
+        result.suite = suite;
+        result.operation = operation;
+        result.payload = payload;
+        result.size = size;
+
+        return mOptions.filter.empty() || result.key().find(mOptions.filter) != std::string::npos;
+    }
+
+    /**
+     * @brief run runs a case repeatedly and reports the median time per operation.
+     * @param body runs the case once, times its measured part with the timer and returns the number of operations.
+     */
+    template <class F>
+    void run(const std::string& suite, const std::string& operation, const std::string& payload, std::size_t size, F body)
+    {
+        if(!enabled(suite, operation, payload, size))
+        {
+            return;
+        }
+
+        std::vector<double> times;
+        std::vector<double> allocations;
+
+        for(int i = 0; i < std::max(1, mOptions.repetitions); i++)
+        {
+            Timer timer;
+            double operations = (double)std::max<std::size_t>(1, body(timer));
+
+            times.push_back(timer.elapsed() / operations);
+            allocations.push_back(timer.allocations() / operations);
+        }
+
+        Result result;
+        result.suite = suite;
+        result.operation = operation;
+        result.payload = payload;
+        result.size = size;
+        result.nsPerOp = median(times);
+        result.allocationsPerOp = median(allocations);
+
+        record(result);
+    }
+
+    /**
+     * @brief record reports a result that has been measured without run(), e.g. a latency percentile.
+     * @param result the result.
+     */
+    void record(const Result& result)
+    {
+        if(enabled(result.suite, result.operation, result.payload, result.size))
+        {
+            mListener(result);
+        }
+    }
+
+    /**
+     * @brief options returns the options.
+     * @return the options.
+     */
+    const Options& options() const
+    {
+        return mOptions;
+    }
+
+    /**
+     * @brief median returns the median of some values.
+     * @param values the values, reordered.
+     * @return the median.
+     */
+    static double median(std::vector<double>& values)
+    {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0.0 : values[values.size() / 2];
+    }
+
+private:
+
+    Options mOptions;
+    Listener mListener;
+};
+
+
+/**
+ * @brief runContainerBenchmarks runs the operation matrix of Container, Packet and PacketType.
+ */
+void runContainerBenchmarks(Runner& runner);
+
+/**
+ * @brief runPipelineBenchmarks runs the benchmarks of ContainerCodec, ConcurrentContainer, ContainerChannel,
+ * SharedContainer, Pipeline and SharedMemoryRing.
+ */
+void runPipelineBenchmarks(Runner& runner);
+
+/**
+ * @brief runParallelBenchmarks runs paco::parallel::for_each, transform and reduce with 1 to N threads,
+ * and request scoped containers with the global allocator and with memory resources.
+ */
+void runParallelBenchmarks(Runner& runner);
+
+}
+}
+
+#endif // PACO_BENCHMARK_H
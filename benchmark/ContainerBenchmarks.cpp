@@ -0,0 +1,784 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "BatchValidation.h"
+#include "Benchmark.h"
+#include "Container.h"
+#include "Packet.h"
+#include "PacketType.h"
+#include "SlotKey.h"
+#include "SlotMapContainer.h"
+#include "Specification.h"
+#include "SpecificationPattern.h"
+
+namespace paco
+{
+namespace benchmark
+{
+
+namespace
+{
+
+/**
+ * @brief The Payload_T template struct names a payload type and creates its values.
+ */
+template <class T>
+struct Payload_T;
+
+template <>
+struct Payload_T<int>
+{
+    static const char* name() { return "int"; }
+    static int make(std::size_t i) { return (int)i; }
+};
+
+template <>
+struct Payload_T<double>
+{
+    static const char* name() { return "double"; }
+    static double make(std::size_t i) { return i * 0.5; }
+};
+
+template <>
+struct Payload_T<std::string>
+{
+    static const char* name() { return "std::string[32]"; }
+    static std::string make(std::size_t i) { return std::string(32, (char)('a' + i % 26)); }
+};
+
+template <>
+struct Payload_T<QString>
+{
+    static const char* name() { return "QString"; }
+    static QString make(std::size_t) { return QString("package container payload"); }
+};
+
+template <>
+struct Payload_T<std::vector<double> >
+{
+    static const char* name() { return "std::vector<double>[16]"; }
+    static std::vector<double> make(std::size_t i) { return std::vector<double>(16, i * 0.5); }
+};
+
+template <>
+struct Payload_T<std::function<int(int)> >
+{
+    static const char* name() { return "std::function<int(int)>"; }
+    static std::function<int(int)> make(std::size_t i) { return [i](int x) { return x + (int)i; }; }
+};
+
+template <>
+struct Payload_T<QList<QString>*>
+{
+    static const char* name() { return "QList<QString>*"; }
+
+    static QList<QString>* make(std::size_t)
+    {
+        static QList<QString> list;
+        return &list;
+    }
+};
+
+/**
+ * @brief values creates n payload values.
+ */
+template <class T>
+std::vector<T> values(std::size_t n)
+{
+    std::vector<T> values;
+    values.reserve(n);
+
+    for(std::size_t i = 0; i < n; i++)
+    {
+        values.push_back(Payload_T<T>::make(i));
+    }
+
+    return values;
+}
+
+/**
+ * @brief fill appends payload values to a container.
+ */
+template <class T>
+void fill(paco::Container& container, const std::vector<T>& values)
+{
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+        container.append<T>(values[i]);
+    }
+}
+
+/**
+ * @brief Operations are the operations of the matrix.
+ */
+const char* const Operations[] = {"append", "insert", "removeAt", "replace", "at", "get", "equals", "getSpecification", "packet_cast"};
+
+/**
+ * @brief runMatrix runs every operation of the matrix for one payload type and all sizes.
+ */
+template <class T>
+void runMatrix(Runner& runner)
+{
+    const std::string payload = Payload_T<T>::name();
+    const std::string suite = "container";
+
+    std::vector<std::size_t> sizes = runner.sizes();
+
+    for(std::size_t s = 0; s < sizes.size(); s++)
+    {
+        const std::size_t n = sizes[s];
+
+        bool enabled = false;
+        for(std::size_t i = 0; i < sizeof(Operations) / sizeof(Operations[0]); i++)
+        {
+            enabled = enabled || runner.enabled(suite, Operations[i], payload, n);
+        }
+
+        if(!enabled)
+        {
+            continue;
+        }
+
+        std::vector<T> data = values<T>(n);
+
+        runner.run(suite, "append", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+            std::vector<paco::Container> containers(passes);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                fill<T>(containers[p], data);
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run(suite, "insert", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+            std::vector<paco::Container> containers(passes);
+
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                fill<T>(containers[p], data);
+            }
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                containers[p].insert<T>(n / 2, data[p % n]);
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run(suite, "removeAt", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+            std::vector<paco::Container> containers(passes);
+
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                fill<T>(containers[p], data);
+            }
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                containers[p].removeAt(n / 2);
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        paco::Container container;
+        fill<T>(container, data);
+
+        runner.run(suite, "replace", payload, n, [&](Timer& timer)
+        {
+            const std::size_t operations = 100000;
+
+            timer.start();
+            for(std::size_t i = 0; i < operations; i++)
+            {
+                std::size_t index = (i * 7919) % n;
+                container.replace<T>(index, data[index]);
+            }
+            timer.stop();
+
+            return operations;
+        });
+
+        runner.run(suite, "at", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    keep(container.at(i));
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run(suite, "get", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    T value = container.at(i)->get<T>();
+                    keep(value);
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run(suite, "equals", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    bool equal = container.at(i)->packetType().equals<T>();
+                    keep(equal);
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run(suite, "getSpecification", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                paco::Specification specification = container.getSpecification();
+                keep(specification);
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run(suite, "packet_cast", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    keep(paco::packet_cast<paco::Packet_T<T>*>(container.at(i)));
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+    }
+}
+
+/**
+ * @brief runKeyed compares keyed access with indexed access on containers of named ints.
+ * Sizes are limited to 10000 keys because keys are interned for the lifetime of the process.
+ */
+void runKeyed(Runner& runner)
+{
+    std::vector<std::size_t> sizes = runner.sizes();
+
+    for(std::size_t s = 0; s < sizes.size() && sizes[s] <= 10000; s++)
+    {
+        const std::size_t n = sizes[s];
+
+        if(!runner.enabled("container", "get_by_index", "int", n) && !runner.enabled("container", "get_by_key", "int", n)
+                && !runner.enabled("container", "get_by_name", "int", n))
+        {
+            continue;
+        }
+
+        std::vector<paco::SlotKey> keys;
+        std::vector<std::string> names;
+        paco::Container container;
+
+        for(std::size_t i = 0; i < n; i++)
+        {
+            names.push_back("key" + std::to_string(i));
+            keys.push_back(paco::SlotKey(names.back()));
+            container.append<int>(keys.back(), (int)i);
+        }
+
+        runner.run("container", "get_by_index", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    keep(container.at(i)->get_cref<int>());
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run("container", "get_by_key", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    keep(container.get<int>(keys[i]));
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+
+        runner.run("container", "get_by_name", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    keep(container.get<int>(names[i]));
+                }
+            }
+            timer.stop();
+
+            return passes * n;
+        });
+    }
+}
+
+/**
+ * @brief runTypeIndex finds the QList<QString>* objects of containers with mixed objects,
+ * by scanning with equals<T>() and through the per type index.
+ */
+void runTypeIndex(Runner& runner)
+{
+    const std::string payload = "mixed";
+    const std::size_t sizes[] = {1000, 10000};
+
+    for(int s = 0; s < 2; s++)
+    {
+        const std::size_t n = sizes[s];
+
+        if(n > runner.sizes().back())
+        {
+            continue;
+        }
+
+        static QList<QString> list;
+        paco::Container container;
+
+        for(std::size_t i = 0; i < n; i++)
+        {
+            switch(i % 4)
+            {
+            case 0: container.append<int>((int)i); break;
+            case 1: container.append<double>(i * 0.5); break;
+            case 2: container.append<std::string>(std::string(16, 'm')); break;
+            default: container.append<QList<QString>*>(&list); break;
+            }
+        }
+
+        runner.run("type_index", "scan_equals", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(int i = 0; i < container.size(); i++)
+                {
+                    if(container.at(i)->packetType().equals<QList<QString>*>())
+                    {
+                        keep(container.at(i)->get_cref<QList<QString>*>());
+                    }
+                }
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("type_index", "range", payload, n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(QList<QString>* element : container.range<QList<QString>*>())
+                {
+                    keep(element);
+                }
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("type_index", "count", payload, n, [&](Timer& timer)
+        {
+            const std::size_t operations = 1000000;
+
+            timer.start();
+            for(std::size_t i = 0; i < operations; i++)
+            {
+                keep(container.count<QList<QString>*>());
+            }
+            timer.stop();
+
+            return operations;
+        });
+
+        runner.run("type_index", "indexOf", payload, n, [&](Timer& timer)
+        {
+            const std::size_t operations = 1000000;
+
+            timer.start();
+            for(std::size_t i = 0; i < operations; i++)
+            {
+                keep(container.indexOf<QList<QString>*>());
+            }
+            timer.stop();
+
+            return operations;
+        });
+    }
+}
+
+/**
+ * @brief appendDigit appends one of four types to a specification.
+ */
+void appendDigit(paco::Specification& specification, std::size_t digit)
+{
+    switch(digit % 4)
+    {
+    case 0: specification.append<int>(); break;
+    case 1: specification.append<double>(); break;
+    case 2: specification.append<std::string>(); break;
+    default: specification.append<QString>(); break;
+    }
+}
+
+/**
+ * @brief runRouter routes a container among n distinct four element specifications, of which the last one matches.
+ * The router is compared with checking the patterns one after another.
+ */
+void runRouter(Runner& runner)
+{
+    const std::size_t counts[] = {8, 64};
+
+    for(int c = 0; c < 2; c++)
+    {
+        const std::size_t n = counts[c];
+
+        std::vector<paco::Specification> specifications(n);
+        std::vector<paco::SpecificationPattern> patterns;
+        paco::SpecificationRouter router;
+
+        for(std::size_t i = 0; i < n; i++)
+        {
+            for(std::size_t digit = 0, value = i; digit < 4; digit++, value /= 4)
+            {
+                appendDigit(specifications[i], value);
+            }
+
+            patterns.push_back(paco::SpecificationPattern(specifications[i]));
+            router.add(patterns.back());
+        }
+
+        router.compile();
+
+        paco::Container container;
+        for(std::size_t digit = 0, value = n - 1; digit < 4; digit++, value /= 4)
+        {
+            switch(value % 4)
+            {
+            case 0: container.append<int>(1); break;
+            case 1: container.append<double>(1.0); break;
+            case 2: container.append<std::string>(std::string("s")); break;
+            default: container.append<QString>(QString("q")); break;
+            }
+        }
+
+        const std::size_t operations = 1000000;
+
+        runner.run("router", "linear_matches", "Specification", n, [&](Timer& timer)
+        {
+            timer.start();
+            for(std::size_t o = 0; o < operations; o++)
+            {
+                std::size_t i = 0;
+                while(i < n && !container.matches(specifications[i]))
+                {
+                    i++;
+                }
+
+                keep(i);
+            }
+            timer.stop();
+
+            return operations;
+        });
+
+        runner.run("router", "linear_pattern", "SpecificationPattern", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, operations);
+
+            timer.start();
+            for(std::size_t o = 0; o < passes; o++)
+            {
+                std::size_t i = 0;
+                while(i < n && !patterns[i].matches(container))
+                {
+                    i++;
+                }
+
+                keep(i);
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("router", "route", "SpecificationPattern", n, [&](Timer& timer)
+        {
+            timer.start();
+            for(std::size_t o = 0; o < operations; o++)
+            {
+                keep(router.route(container));
+            }
+            timer.stop();
+
+            return operations;
+        });
+    }
+}
+
+/**
+ * @brief runBatchValidation validates a burst of containers with eight objects against a specification,
+ * half of them matching. The scalar loops are compared with the batch validation at every supported instruction set.
+ */
+void runBatchValidation(Runner& runner)
+{
+    const std::size_t n = 4096;
+
+    if(n > runner.sizes().back())
+    {
+        return;
+    }
+
+    paco::Specification specification;
+    std::vector<paco::Container> containers(n);
+    std::vector<const paco::Container*> pointers(n);
+
+    for(std::size_t i = 0; i < n; i++)
+    {
+        for(int k = 0; k < 8; k++)
+        {
+            if(k == 7 && i % 2 == 1)
+            {
+                containers[i].append<float>(1.0f);
+            }
+            else if(k % 2 == 0)
+            {
+                containers[i].append<int>(k);
+            }
+            else
+            {
+                containers[i].append<double>(k);
+            }
+        }
+
+        pointers[i] = &containers[i];
+    }
+
+    specification = containers[0].getSpecification();
+
+    paco::SignatureBatch signatures;
+    signatures.reserve(n, n * 8);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        signatures.append(containers[i]);
+    }
+
+    const std::size_t passes = 200;
+
+    runner.run("batch_validation", "getSpecification_equals", "Container", n, [&](Timer& timer)
+    {
+        timer.start();
+        for(std::size_t p = 0; p < passes; p++)
+        {
+            std::size_t matches = 0;
+            for(std::size_t i = 0; i < n; i++)
+            {
+                matches += containers[i].getSpecification() == specification;
+            }
+            keep(matches);
+        }
+        timer.stop();
+
+        return passes;
+    });
+
+    runner.run("batch_validation", "matches_loop", "Container", n, [&](Timer& timer)
+    {
+        timer.start();
+        for(std::size_t p = 0; p < passes; p++)
+        {
+            std::size_t matches = 0;
+            for(std::size_t i = 0; i < n; i++)
+            {
+                matches += containers[i].matches(specification);
+            }
+            keep(matches);
+        }
+        timer.stop();
+
+        return passes;
+    });
+
+    for(int level = paco::simd::Scalar; level <= paco::simd::detected(); level++)
+    {
+        const std::string name = paco::simd::name((paco::simd::Level)level);
+
+        runner.run("batch_validation", "validateBatch_" + name, "Container", n, [&](Timer& timer)
+        {
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                keep(paco::validateBatch(pointers.data(), n, specification, (paco::simd::Level)level).words());
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("batch_validation", "signatures_" + name, "SignatureBatch", n, [&](Timer& timer)
+        {
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                keep(signatures.validate(specification, (paco::simd::Level)level).words());
+            }
+            timer.stop();
+
+            return passes;
+        });
+    }
+}
+
+/**
+ * @brief runSlotMap measures removing the middle object of a SlotMapContainer by handle,
+ * to be compared with container/removeAt/int.
+ */
+void runSlotMap(Runner& runner)
+{
+    std::vector<std::size_t> sizes = runner.sizes();
+
+    for(std::size_t s = 0; s < sizes.size(); s++)
+    {
+        const std::size_t n = sizes[s];
+
+        runner.run("slot_map", "remove", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+            std::vector<paco::SlotMapContainer> containers(passes);
+            std::vector<paco::SlotHandle> middle(passes);
+
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    paco::SlotHandle handle = containers[p].append<int>((int)i);
+
+                    if(i == n / 2)
+                    {
+                        middle[p] = handle;
+                    }
+                }
+            }
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                containers[p].remove(middle[p]);
+            }
+            timer.stop();
+
+            return passes;
+        });
+    }
+}
+
+}
+
+void runContainerBenchmarks(Runner& runner)
+{
+    runMatrix<int>(runner);
+    runMatrix<double>(runner);
+    runMatrix<std::string>(runner);
+    runMatrix<QString>(runner);
+    runMatrix<std::vector<double> >(runner);
+    runMatrix<std::function<int(int)> >(runner);
+    runMatrix<QList<QString>*>(runner);
+
+    runKeyed(runner);
+    runTypeIndex(runner);
+    runSlotMap(runner);
+    runRouter(runner);
+    runBatchValidation(runner);
+}
+
+}
+}
@@ -0,0 +1,275 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Container.h"
+#include "MemoryResource.h"
+#include "Parallel.h"
+
+namespace paco
+{
+namespace benchmark
+{
+
+namespace
+{
+
+/**
+ * @brief decode stands in for expensive per element work, e.g. decoding a payload.
+ */
+std::uint64_t decode(const std::vector<int>& payload)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for(std::size_t i = 0; i < payload.size(); i++)
+    {
+        hash ^= (std::uint64_t)payload[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief threadCounts returns 1, 2, 4, ... up to the number of hardware threads, which is always included.
+ */
+std::vector<int> threadCounts()
+{
+    int hardware = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> counts;
+
+    for(int threads = 1; threads < hardware; threads *= 2)
+    {
+        counts.push_back(threads);
+    }
+
+    counts.push_back(hardware);
+
+    return counts;
+}
+
+/**
+ * @brief buildRequest fills a container like a request handler would, half of the objects are heap packets.
+ */
+std::uint64_t buildRequest(paco::Container& container)
+{
+    for(int i = 0; i < 32; i++)
+    {
+        if(i % 2 == 0)
+        {
+            container.append<int>(i);
+        }
+        else
+        {
+            std::array<double, 4> values = {{i * 1.0, i * 2.0, i * 3.0, i * 4.0}};
+            container.append<std::array<double, 4> >(values);
+        }
+    }
+
+    return container.at(1)->get_cref<std::array<double, 4> >()[3];
+}
+
+/**
+ * @brief runMemoryResources creates and destroys request scoped containers on 1 to N threads, with the global allocator,
+ * a monotonic arena per request and the pool of each thread.
+ */
+void runMemoryResources(Runner& runner, const std::vector<int>& counts)
+{
+    const std::size_t requests = 20000;
+
+    for(std::size_t t = 0; t < counts.size(); t++)
+    {
+        const int threads = counts[t];
+
+        // every thread handles requests / threads requests, the number of operations is the total
+        auto run = [&](const std::string& operation, std::function<std::uint64_t()> request)
+        {
+            runner.run("memory_resource", operation, "Container", threads, [&](Timer& timer)
+            {
+                std::vector<std::thread> workers;
+                std::vector<std::uint64_t> sums(threads);
+
+                timer.start();
+                for(int w = 0; w < threads; w++)
+                {
+                    workers.push_back(std::thread([&, w]
+                    {
+                        for(std::size_t r = w; r < requests; r += threads)
+                        {
+                            sums[w] += request();
+                        }
+                    }));
+                }
+
+                for(int w = 0; w < threads; w++)
+                {
+                    workers[w].join();
+                }
+                timer.stop();
+
+                keep(sums);
+
+                return requests;
+            });
+        };
+
+        run("global", []
+        {
+            paco::Container container;
+            return buildRequest(container);
+        });
+
+        run("monotonic_arena", []
+        {
+            alignas(std::max_align_t) char buffer[4096];
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+
+            paco::Container container(&arena);
+            return buildRequest(container);
+        });
+
+        run("thread_local_pool", []
+        {
+            paco::Container container(paco::threadLocalPool());
+            return buildRequest(container);
+        });
+    }
+}
+
+}
+
+void runParallelBenchmarks(Runner& runner)
+{
+    const std::size_t elements = 10000;
+    const std::size_t containers = 1000;
+
+    std::vector<std::vector<int> > payloads(elements, std::vector<int>(1000, 7));
+
+    paco::Container container;
+    for(std::size_t i = 0; i < elements; i++)
+    {
+        container.append<int>((int)i);
+        container.append<std::vector<int>*>(&payloads[i]);
+    }
+
+    std::vector<paco::Container> batch(containers);
+    for(std::size_t i = 0; i < containers; i++)
+    {
+        batch[i].append<std::vector<int>*>(&payloads[i]);
+        batch[i].append<std::vector<int>*>(&payloads[elements - 1 - i]);
+    }
+
+    std::vector<int> counts = threadCounts();
+
+    for(std::size_t t = 0; t < counts.size(); t++)
+    {
+        const int threads = counts[t];
+
+        if(!runner.enabled("parallel", "for_each", "std::vector<int>*", threads)
+                && !runner.enabled("parallel", "transform", "std::vector<int>*", threads)
+                && !runner.enabled("parallel", "reduce", "std::vector<int>*", threads)
+                && !runner.enabled("parallel", "reduce_packets", "mixed", threads)
+                && !runner.enabled("parallel", "reduce_containers", "Container", threads))
+        {
+            continue;
+        }
+
+        paco::parallel::ThreadPool pool(threads);
+        paco::parallel::Options options(0, &pool);
+
+        runner.run("parallel", "for_each", "std::vector<int>*", threads, [&](Timer& timer)
+        {
+            std::vector<std::uint64_t> hashes(elements);
+
+            timer.start();
+            paco::parallel::for_each<std::vector<int>*>(container, [&](std::vector<int>* payload)
+            {
+                hashes[payload - payloads.data()] = decode(*payload);
+            }, options);
+            timer.stop();
+
+            keep(hashes);
+
+            return elements;
+        });
+
+        runner.run("parallel", "transform", "std::vector<int>*", threads, [&](Timer& timer)
+        {
+            timer.start();
+            std::vector<std::uint64_t> hashes = paco::parallel::transform<std::vector<int>*>(container, [](std::vector<int>* const& payload)
+            {
+                return decode(*payload);
+            }, options);
+            timer.stop();
+
+            keep(hashes);
+
+            return elements;
+        });
+
+        runner.run("parallel", "reduce", "std::vector<int>*", threads, [&](Timer& timer)
+        {
+            timer.start();
+            std::uint64_t sum = paco::parallel::reduce<std::vector<int>*>(container, std::uint64_t(0), [](std::vector<int>* const& payload)
+            {
+                return decode(*payload);
+            }, [](std::uint64_t a, std::uint64_t b) { return a + b; }, options);
+            timer.stop();
+
+            keep(sum);
+
+            return elements;
+        });
+
+        runner.run("parallel", "reduce_packets", "mixed", threads, [&](Timer& timer)
+        {
+            timer.start();
+            std::uint64_t sum = paco::parallel::reduce(container, std::uint64_t(0), [](const paco::Packet& packet)
+            {
+                const std::vector<int>* const* payload = packet.get_if<std::vector<int>*>();
+                return payload != nullptr ? decode(**payload) : (std::uint64_t)packet.get_cref<int>();
+            }, [](std::uint64_t a, std::uint64_t b) { return a + b; }, options);
+            timer.stop();
+
+            keep(sum);
+
+            return 2 * elements;
+        });
+
+        runner.run("parallel", "reduce_containers", "Container", threads, [&](Timer& timer)
+        {
+            timer.start();
+            std::uint64_t sum = paco::parallel::reduce(batch.begin(), batch.end(), std::uint64_t(0), [](const paco::Container& record)
+            {
+                return decode(*record.at(0)->get_cref<std::vector<int>*>()) + decode(*record.at(1)->get_cref<std::vector<int>*>());
+            }, [](std::uint64_t a, std::uint64_t b) { return a + b; }, options);
+            timer.stop();
+
+            keep(sum);
+
+            return containers;
+        });
+    }
+
+    runMemoryResources(runner, counts);
+}
+
+}
+}
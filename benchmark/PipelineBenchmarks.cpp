@@ -0,0 +1,685 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ConcurrentContainer.h"
+#include "Container.h"
+#include "ContainerChannel.h"
+#include "ContainerCodec.h"
+#include "Pipeline.h"
+#include "SharedContainer.h"
+#include "SharedMemoryRing.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace paco
+{
+namespace benchmark
+{
+
+namespace
+{
+
+/**
+ * @brief The MutexQueue class is the std::mutex + std::deque baseline the channels are compared against.
+ */
+class MutexQueue
+{
+public:
+
+    void push(paco::Container* container)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(container);
+        }
+
+        mCondition.notify_one();
+    }
+
+    paco::Container* pop()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return !mQueue.empty(); });
+
+        paco::Container* container = mQueue.front();
+        mQueue.pop_front();
+
+        return container;
+    }
+
+private:
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<paco::Container*> mQueue;
+};
+
+/**
+ * @brief The ChannelQueue_T template class adapts a ContainerChannel_T to the interface of MutexQueue.
+ */
+template <class Channel>
+class ChannelQueue_T
+{
+public:
+
+    ChannelQueue_T()
+        : mChannel(1024)
+    {
+    }
+
+    void push(paco::Container* container)
+    {
+        mChannel.push(container);
+    }
+
+    paco::Container* pop()
+    {
+        paco::Container* container = nullptr;
+        mChannel.pop(container);
+
+        return container;
+    }
+
+private:
+
+    Channel mChannel;
+};
+
+/**
+ * @brief runLatency measures round trips of one container between two threads and reports latency percentiles.
+ */
+template <class Queue>
+void runLatency(Runner& runner, const std::string& name)
+{
+    const std::size_t roundTrips = 20000;
+    const char* const percentiles[] = {"p50", "p90", "p99", "p999", "max"};
+    const double fractions[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+    bool enabled = false;
+    for(int i = 0; i < 5; i++)
+    {
+        enabled = enabled || runner.enabled("channel", name + "_rtt_" + percentiles[i], "Container*", roundTrips);
+    }
+
+    if(!enabled)
+    {
+        return;
+    }
+
+    Queue requests;
+    Queue responses;
+
+    std::thread echo([&]
+    {
+        for(std::size_t i = 0; i < roundTrips; i++)
+        {
+            responses.push(requests.pop());
+        }
+    });
+
+    paco::Container container;
+    container.append<int>(0);
+
+    std::vector<double> latencies;
+    latencies.reserve(roundTrips);
+
+    for(std::size_t i = 0; i < roundTrips; i++)
+    {
+        Timer::Clock::time_point start = Timer::Clock::now();
+
+        requests.push(&container);
+        keep(responses.pop());
+
+        latencies.push_back(std::chrono::duration<double, std::nano>(Timer::Clock::now() - start).count());
+    }
+
+    echo.join();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    for(int i = 0; i < 5; i++)
+    {
+        Result result;
+        result.suite = "channel";
+        result.operation = name + "_rtt_" + percentiles[i];
+        result.payload = "Container*";
+        result.size = roundTrips;
+        result.nsPerOp = latencies[std::min(latencies.size() - 1, (std::size_t)(fractions[i] * latencies.size()))];
+        result.allocationsPerOp = 0.0;
+
+        runner.record(result);
+    }
+}
+
+/**
+ * @brief runThroughput streams containers from a producer to a consumer, recycling them through the channel.
+ */
+template <class Channel>
+void runThroughput(Runner& runner, const std::string& name, std::size_t batch)
+{
+    const std::size_t messages = 200000;
+
+    runner.run("channel", name + "_throughput_batch" + std::to_string(batch), "Container*", messages, [&](Timer& timer)
+    {
+        Channel channel(1024);
+        std::vector<paco::Container*> popped(batch);
+
+        timer.start();
+
+        std::thread producer([&]
+        {
+            std::vector<paco::Container*> pushed(batch);
+
+            for(std::size_t i = 0; i < messages; i += batch)
+            {
+                for(std::size_t j = 0; j < batch; j++)
+                {
+                    pushed[j] = channel.acquire();
+                    pushed[j]->append<int>((int)(i + j));
+                }
+
+                channel.pushBatch(pushed.data(), batch);
+            }
+
+            channel.close();
+        });
+
+        std::size_t count;
+        while((count = channel.popBatch(popped.data(), batch)) > 0)
+        {
+            for(std::size_t j = 0; j < count; j++)
+            {
+                channel.recycle(popped[j]);
+            }
+        }
+
+        producer.join();
+
+        timer.stop();
+
+        return messages;
+    });
+}
+
+/**
+ * @brief runMutexThroughput is the baseline of runThroughput.
+ */
+void runMutexThroughput(Runner& runner)
+{
+    const std::size_t messages = 200000;
+
+    runner.run("channel", "mutex_throughput_batch1", "Container*", messages, [&](Timer& timer)
+    {
+        MutexQueue queue;
+
+        timer.start();
+
+        std::thread producer([&]
+        {
+            for(std::size_t i = 0; i < messages; i++)
+            {
+                paco::Container* container = new paco::Container();
+                container->append<int>((int)i);
+                queue.push(container);
+            }
+        });
+
+        for(std::size_t i = 0; i < messages; i++)
+        {
+            delete queue.pop();
+        }
+
+        producer.join();
+
+        timer.stop();
+
+        return messages;
+    });
+}
+
+/**
+ * @brief runCodec measures encoding and decoding of containers with n ints and of one vector with n doubles.
+ */
+void runCodec(Runner& runner)
+{
+    paco::ContainerCodec::registerDefaultCodecs();
+    paco::registerCodec<std::vector<double> >(&paco::encodeVector<double>, &paco::decodeVector<double>);
+
+    std::vector<std::size_t> sizes = runner.sizes();
+
+    for(std::size_t s = 0; s < sizes.size(); s++)
+    {
+        const std::size_t n = sizes[s];
+
+        paco::Container ints;
+        for(std::size_t i = 0; i < n; i++)
+        {
+            ints.append<int>((int)i);
+        }
+
+        paco::Container vector;
+        vector.append<std::vector<double> >(std::vector<double>(n, 0.5));
+
+        std::vector<char> encodedInts = paco::ContainerCodec::encode(ints);
+        std::vector<char> encodedVector = paco::ContainerCodec::encode(vector);
+
+        runner.run("codec", "encode", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                paco::PacketWriter writer;
+                paco::ContainerCodec::encode(ints, writer);
+                keep(writer.size());
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("codec", "decode", "int", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 100000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                paco::Container decoded = paco::ContainerCodec::decode(encodedInts.data(), encodedInts.size());
+                keep(decoded);
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("codec", "encode", "std::vector<double>", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                paco::PacketWriter writer;
+                paco::ContainerCodec::encode(vector, writer);
+                keep(writer.size());
+            }
+            timer.stop();
+
+            return passes;
+        });
+
+        runner.run("codec", "decode", "std::vector<double>", n, [&](Timer& timer)
+        {
+            std::size_t passes = budget(n, 1000000);
+
+            timer.start();
+            for(std::size_t p = 0; p < passes; p++)
+            {
+                paco::Container decoded = paco::ContainerCodec::decode(encodedVector.data(), encodedVector.size());
+                keep(decoded);
+            }
+            timer.stop();
+
+            return passes;
+        });
+    }
+}
+
+/**
+ * @brief runConcurrent measures appending from several threads to a ConcurrentContainer and to a Container behind a mutex.
+ */
+void runConcurrent(Runner& runner)
+{
+    const std::size_t appends = 1000000;
+    const std::size_t threadCounts[] = {1, 2, 4, 8};
+
+    for(int t = 0; t < 4; t++)
+    {
+        const std::size_t threads = threadCounts[t];
+
+        runner.run("concurrent", "ConcurrentContainer::append", "int", threads, [&](Timer& timer)
+        {
+            paco::ConcurrentContainer container;
+            std::vector<std::thread> workers;
+
+            timer.start();
+            for(std::size_t i = 0; i < threads; i++)
+            {
+                workers.push_back(std::thread([&]
+                {
+                    for(std::size_t j = 0; j < appends / threads; j++)
+                    {
+                        container.append<int>((int)j);
+                    }
+                }));
+            }
+
+            for(std::size_t i = 0; i < threads; i++)
+            {
+                workers[i].join();
+            }
+            timer.stop();
+
+            return appends / threads * threads;
+        });
+
+        runner.run("concurrent", "mutex_Container::append", "int", threads, [&](Timer& timer)
+        {
+            paco::Container container;
+            std::mutex mutex;
+            std::vector<std::thread> workers;
+
+            timer.start();
+            for(std::size_t i = 0; i < threads; i++)
+            {
+                workers.push_back(std::thread([&]
+                {
+                    for(std::size_t j = 0; j < appends / threads; j++)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        container.append<int>((int)j);
+                    }
+                }));
+            }
+
+            for(std::size_t i = 0; i < threads; i++)
+            {
+                workers[i].join();
+            }
+            timer.stop();
+
+            return appends / threads * threads;
+        });
+    }
+}
+
+/**
+ * @brief runDataflow streams containers through a three stage paco::Pipeline into a sink.
+ */
+void runDataflow(Runner& runner, std::size_t batch)
+{
+    const std::size_t messages = 100000;
+
+    runner.run("dataflow", "three_stages_batch" + std::to_string(batch), "Container*", messages, [&](Timer& timer)
+    {
+        paco::Specification raw;
+        raw.append<int>();
+
+        paco::Specification decoded;
+        decoded.append<int>();
+        decoded.append<double>();
+
+        std::uint64_t sum = 0;
+
+        paco::Pipeline pipeline(1024, batch);
+        int decode = pipeline.addStage("decode", raw, decoded, [](paco::Container& container)
+        {
+            container.append<double>(container.at(0)->get<int>() * 0.5);
+        });
+        int scale = pipeline.addStage("scale", decoded, decoded, [](paco::Container& container)
+        {
+            container.at(1)->get_ref<double>() *= 2.0;
+        });
+        int sink = pipeline.addSink("sink", decoded, [&](paco::Container& container)
+        {
+            sum += (std::uint64_t)container.at(1)->get<double>();
+        });
+        pipeline.connect(decode, scale);
+        pipeline.connect(scale, sink);
+
+        timer.start();
+        pipeline.start();
+
+        for(std::size_t i = 0; i < messages; i++)
+        {
+            paco::Container* container = pipeline.acquire();
+            container->append<int>((int)i);
+            pipeline.push(decode, container);
+        }
+
+        pipeline.wait();
+        timer.stop();
+
+        keep(sum);
+
+        return messages;
+    });
+}
+
+/**
+ * @brief The Sample struct is the flat payload of runSharedMemory.
+ */
+struct Sample
+{
+    std::int64_t timestamp;
+    double values[14];
+};
+
+/**
+ * @brief runSharedMemory passes containers with a flat payload through a SharedMemoryRing, and as baseline encoded
+ * through a local socket and decoded again. Writer and reader are threads of this process, the transport is the same
+ * as between processes.
+ */
+void runSharedMemory(Runner& runner)
+{
+    const std::size_t messages = 100000;
+
+    paco::registerCodec<Sample>();
+
+    paco::Container container;
+    container.append<Sample>(Sample());
+    container.append<int>(1);
+
+    runner.run("shared_memory", "ring", "Sample", messages, [&](Timer& timer)
+    {
+        paco::SharedMemoryRing writer("/paco-benchmark-" + std::to_string(::getpid()), 1 << 20);
+        paco::SharedMemoryRing reader("/paco-benchmark-" + std::to_string(::getpid()));
+        double sum = 0;
+
+        timer.start();
+
+        std::thread consumer([&]
+        {
+            paco::SharedMemoryMessage message;
+
+            while(reader.read(message))
+            {
+                sum += message.get<Sample>(0).values[0];
+                reader.release(message);
+            }
+        });
+
+        for(std::size_t i = 0; i < messages; i++)
+        {
+            writer.write(container);
+        }
+
+        writer.close();
+        consumer.join();
+
+        timer.stop();
+
+        keep(sum);
+
+        return messages;
+    });
+
+    runner.run("shared_memory", "socket_codec", "Sample", messages, [&](Timer& timer)
+    {
+        int sockets[2];
+        if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+        {
+            return std::size_t(0);
+        }
+
+        double sum = 0;
+
+        timer.start();
+
+        std::thread consumer([&]
+        {
+            std::vector<char> buffer;
+            std::uint64_t size;
+
+            while(::read(sockets[1], &size, sizeof(size)) == sizeof(size))
+            {
+                buffer.resize(size);
+
+                for(std::size_t done = 0; done < size; )
+                {
+                    done += ::read(sockets[1], buffer.data() + done, size - done);
+                }
+
+                paco::Container decoded = paco::ContainerCodec::decode(buffer.data(), buffer.size());
+                sum += decoded.at(0)->get_cref<Sample>().values[0];
+            }
+        });
+
+        for(std::size_t i = 0; i < messages; i++)
+        {
+            std::vector<char> bytes = paco::ContainerCodec::encode(container);
+            std::uint64_t size = bytes.size();
+
+            if(::write(sockets[0], &size, sizeof(size)) != sizeof(size) || ::write(sockets[0], bytes.data(), size) != (ssize_t)size)
+            {
+                break;
+            }
+        }
+
+        ::close(sockets[0]);
+        consumer.join();
+        ::close(sockets[1]);
+
+        timer.stop();
+
+        keep(sum);
+
+        return messages;
+    });
+}
+
+/**
+ * @brief runFanOut measures handing one container with a multi megabyte payload to 16 consumers.
+ */
+void runFanOut(Runner& runner)
+{
+    const std::size_t consumers = 16;
+    const std::string payload = "std::vector<char>[4MB]";
+
+    std::vector<char> bytes(4 << 20, 'p');
+
+    runner.run("fanout", "deep_copy", payload, consumers, [&](Timer& timer)
+    {
+        paco::Container source;
+        source.append<int>(0);
+        source.append<std::vector<char> >(bytes);
+
+        const std::size_t passes = 4;
+        std::vector<paco::Container> copies(consumers);
+
+        timer.start();
+        for(std::size_t p = 0; p < passes; p++)
+        {
+            for(std::size_t i = 0; i < consumers; i++)
+            {
+                copies[i].clear();
+                copies[i].append<int>(source.at(0)->get_cref<int>());
+                copies[i].append<std::vector<char> >(source.at(1)->get_cref<std::vector<char> >());
+            }
+        }
+        timer.stop();
+
+        return passes;
+    });
+
+    paco::Container source;
+    source.append<int>(0);
+    source.append<std::vector<char> >(bytes);
+
+    paco::SharedContainer shared(std::move(source));
+
+    runner.run("fanout", "shared_copy", payload, consumers, [&](Timer& timer)
+    {
+        const std::size_t passes = 10000;
+
+        timer.start();
+        for(std::size_t p = 0; p < passes; p++)
+        {
+            std::vector<paco::SharedContainer> copies(consumers, shared);
+            keep(copies);
+        }
+        timer.stop();
+
+        return passes;
+    });
+
+    runner.run("fanout", "shared_copy_replace", payload, consumers, [&](Timer& timer)
+    {
+        const std::size_t passes = 10000;
+
+        timer.start();
+        for(std::size_t p = 0; p < passes; p++)
+        {
+            std::vector<paco::SharedContainer> copies(consumers, shared);
+
+            for(std::size_t i = 0; i < consumers; i++)
+            {
+                copies[i].replace<int>(0, (int)i);
+            }
+
+            keep(copies);
+        }
+        timer.stop();
+
+        return passes;
+    });
+}
+
+}
+
+void runPipelineBenchmarks(Runner& runner)
+{
+    runCodec(runner);
+    runConcurrent(runner);
+
+    runLatency<MutexQueue>(runner, "mutex");
+    runLatency<ChannelQueue_T<paco::SpscContainerChannel> >(runner, "spsc");
+    runLatency<ChannelQueue_T<paco::MpmcContainerChannel> >(runner, "mpmc");
+
+    runMutexThroughput(runner);
+    runThroughput<paco::SpscContainerChannel>(runner, "spsc", 1);
+    runThroughput<paco::SpscContainerChannel>(runner, "spsc", 32);
+    runThroughput<paco::MpmcContainerChannel>(runner, "mpmc", 1);
+    runThroughput<paco::MpmcContainerChannel>(runner, "mpmc", 32);
+
+    runFanOut(runner);
+
+    runDataflow(runner, 1);
+    runDataflow(runner, 32);
+
+    runSharedMemory(runner);
+}
+
+}
+}
@@ -0,0 +1,33 @@
+# Benchmark suite of the Package Container library (paco).
+#
+# Build and run from a separate build directory:
+#
+#   qmake ../benchmark/benchmark.pro CONFIG+=release && make
+#   ./PacoBenchmark --output baseline.csv
+#   ./PacoBenchmark --baseline baseline.csv --threshold 10
+#
+# See main.cpp for all options.
+
+QT += core
+QT -= gui
+
+CONFIG += c++17 console thread
+CONFIG -= app_bundle
+
+TARGET = PacoBenchmark
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+# SharedMemoryRing.h uses POSIX shared memory, which is in librt on older glibc versions.
+unix:!macx: LIBS += -lrt
+
+SOURCES += \
+    main.cpp \
+    ContainerBenchmarks.cpp \
+    ParallelBenchmarks.cpp \
+    PipelineBenchmarks.cpp
+
+HEADERS += \
+    Benchmark.h
@@ -0,0 +1,356 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// PacoBenchmark runs the benchmark suite and writes one CSV row per case:
+//
+//   suite,operation,payload,size,ns_per_op,allocs_per_op
+//
+// size is the container size for the container and codec suites, the number of threads for the concurrent and parallel suites,
+// the number of consumers for the fanout suite and the number of messages for the channel suite.
+//
+// Options:
+//
+//   --filter <text>        only run cases whose "suite/operation/payload/size" contains text
+//   --max-size <n>         largest container size of the matrix, default 1000000
+//   --repetitions <n>      runs per case, the median is reported, default 5
+//   --output <file>        write the CSV to a file instead of stdout
+//   --baseline <file>      compare against a CSV written by an earlier run
+//   --threshold <percent>  a case is a regression if it is slower than the baseline by more than this, default 10
+//
+// With --baseline three columns are added: baseline_ns_per_op, change_percent and status (ok, regression,
+// improvement or new). The exit code is 1 if at least one case regressed.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+namespace paco
+{
+namespace benchmark
+{
+
+std::atomic<std::size_t>& allocationCounter()
+{
+    static std::atomic<std::size_t> counter(0);
+    return counter;
+}
+
+}
+}
+
+namespace
+{
+
+/**
+ * @brief countedAllocate counts and performs an allocation of the replaced operator new.
+ */
+void* countedAllocate(std::size_t size)
+{
+    paco::benchmark::allocationCounter().fetch_add(1, std::memory_order_relaxed);
+
+    if(void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+/**
+ * @brief countedAllocateAligned counts and performs an over-aligned allocation, e.g. of an alignas(64) type.
+ */
+void* countedAllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    paco::benchmark::allocationCounter().fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t bytes = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (size + bytes - 1) / bytes * bytes;
+
+#ifdef _WIN32
+    void* pointer = _aligned_malloc(rounded == 0 ? bytes : rounded, bytes);
+#else
+    void* pointer = std::aligned_alloc(bytes, rounded == 0 ? bytes : rounded);
+#endif
+
+    if(pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+/**
+ * @brief releaseAligned frees an allocation of countedAllocateAligned.
+ */
+void releaseAligned(void* pointer)
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    releaseAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    releaseAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(pointer);
+}
+
+
+namespace
+{
+
+/**
+ * @brief loadBaseline reads the ns_per_op column of a CSV written by an earlier run.
+ * @return the baseline times by case key.
+ */
+std::map<std::string, double> loadBaseline(const std::string& path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream file(path.c_str());
+
+    if(!file)
+    {
+        std::cerr << "cannot read baseline " << path << std::endl;
+        std::exit(2);
+    }
+
+    std::string line;
+    std::getline(file, line); // header
+
+    while(std::getline(file, line))
+    {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+
+        while(std::getline(stream, field, ','))
+        {
+            fields.push_back(field);
+        }
+
+        if(fields.size() >= 5)
+        {
+            paco::benchmark::Result result;
+            result.suite = fields[0];
+            result.operation = fields[1];
+            result.payload = fields[2];
+            result.size = std::strtoull(fields[3].c_str(), nullptr, 10);
+
+            baseline[result.key()] = std::strtod(fields[4].c_str(), nullptr);
+        }
+    }
+
+    return baseline;
+}
+
+void usage()
+{
+    std::cerr << "usage: PacoBenchmark [--filter text] [--max-size n] [--repetitions n] [--output file]"
+                 " [--baseline file] [--threshold percent]" << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    paco::benchmark::Options options;
+    std::string outputPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if(i + 1 >= argc)
+        {
+            usage();
+            return 2;
+        }
+
+        std::string value = argv[++i];
+
+        if(argument == "--filter")
+        {
+            options.filter = value;
+        }
+        else if(argument == "--max-size")
+        {
+            options.maxSize = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(argument == "--repetitions")
+        {
+            options.repetitions = std::atoi(value.c_str());
+        }
+        else if(argument == "--output")
+        {
+            outputPath = value;
+        }
+        else if(argument == "--baseline")
+        {
+            baselinePath = value;
+        }
+        else if(argument == "--threshold")
+        {
+            threshold = std::strtod(value.c_str(), nullptr);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    std::ofstream file;
+    if(!outputPath.empty())
+    {
+        file.open(outputPath.c_str());
+    }
+
+    std::ostream& output = outputPath.empty() ? std::cout : file;
+
+    std::map<std::string, double> baseline;
+    bool compare = !baselinePath.empty();
+
+    if(compare)
+    {
+        baseline = loadBaseline(baselinePath);
+    }
+
+    output << "suite,operation,payload,size,ns_per_op,allocs_per_op";
+    if(compare)
+    {
+        output << ",baseline_ns_per_op,change_percent,status";
+    }
+    output << std::endl;
+
+    std::vector<std::string> regressions;
+
+    paco::benchmark::Runner runner(options, [&](const paco::benchmark::Result& result)
+    {
+        output << result.suite << ',' << result.operation << ',' << result.payload << ',' << result.size << ','
+               << result.nsPerOp << ',' << result.allocationsPerOp;
+
+        if(compare)
+        {
+            std::map<std::string, double>::const_iterator it = baseline.find(result.key());
+
+            if(it == baseline.end() || it->second <= 0.0)
+            {
+                output << ",,,new";
+            }
+            else
+            {
+                double change = 100.0 * (result.nsPerOp - it->second) / it->second;
+                const char* status = "ok";
+
+                if(change > threshold)
+                {
+                    status = "regression";
+                    regressions.push_back(result.key());
+                }
+                else if(change < -threshold)
+                {
+                    status = "improvement";
+                }
+
+                output << ',' << it->second << ',' << change << ',' << status;
+            }
+        }
+
+        output << std::endl;
+    });
+
+    paco::benchmark::runContainerBenchmarks(runner);
+    paco::benchmark::runPipelineBenchmarks(runner);
+    paco::benchmark::runParallelBenchmarks(runner);
+
+    if(!regressions.empty())
+    {
+        std::cerr << regressions.size() << " regression(s) above " << threshold << "%:" << std::endl;
+
+        for(std::size_t i = 0; i < regressions.size(); i++)
+        {
+            std::cerr << "  " << regressions[i] << std::endl;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
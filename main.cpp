@@ -149,5 +149,13 @@ int main(int argc, char *argv[])
         std::cout << std::endl;
     }
 
+
+    //the same with a visitor: every element is dispatched to the lambda matching its type with a single table lookup
+    std::cout << "visiting elements" << std::endl;
+    container.visit([](QList<int>* list){ std::cout << "visited a QList<int>* with " << list->size() << " elements" << std::endl; },
+                    [](QList<QString>* list){ std::cout << "visited a QList<QString>* with " << list->size() << " elements" << std::endl; },
+                    [](int value){ std::cout << "visited an int: '" << value << "'" << std::endl; },
+                    [](paco::Packet& p){ std::cout << "no handler for " << p.packetType().toString().toStdString() << std::endl; });
+
     return 1;
 }
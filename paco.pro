@@ -1,7 +1,7 @@
 QT += core
 QT -= gui
 
-CONFIG += c++11
+CONFIG += c++17
 
 TARGET = EnumTest
 
@@ -20,8 +20,45 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Uncomment to count appends, gets, cast failures, replaces and packet allocations per type,
+# see Instrumentation.h. Disabled instrumentation has no runtime cost.
+#DEFINES += PACO_INSTRUMENTATION
+
+# The core headers do not need Qt when PACO_NO_QT is defined: paco::String is then std::string instead of QString
+# and the QString codec is not registered. ContainerRecording.h still requires QtCore.
+#DEFINES += PACO_NO_QT
+
+# Uncomment to use the scalar kernels of BatchValidation.h only. By default the best of SSE2, AVX2 and AVX-512
+# is selected at runtime when building with GCC or Clang for x86.
+#DEFINES += PACO_NO_SIMD
+
+# SharedMemoryRing.h uses POSIX shared memory, which is in librt on older glibc versions.
+unix:!macx: LIBS += -lrt
+
 HEADERS += \
+    BatchValidation.h \
+    Instrumentation.h \
+    MemoryResource.h \
+    PacoString.h \
+    Parallel.h \
+    Pipeline.h \
     Packet.h \
+    PacketSlot.h \
     PacketType.h \
+    PacketTypeRegistry.h \
+    PacketVisitor.h \
+    SlotKey.h \
+    SlotMapContainer.h \
+    SharedContainer.h \
+    SharedMemoryRing.h \
+    StaticContainer.h \
+    ConcurrentContainer.h \
     Container.h \
-    Specification.h
+    ContainerBatch.h \
+    ContainerChannel.h \
+    ContainerCodec.h \
+    ContainerRecording.h \
+    Specification.h \
+    SpecificationPattern.h \
+    TypeIndex.h \
+    TypeName.h
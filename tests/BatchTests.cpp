@@ -0,0 +1,178 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+#include "Container.h"
+#include "ContainerBatch.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Flaky struct throws when it is copied or moved from an instance marked as failing.
+ */
+struct Flaky
+{
+    explicit Flaky(bool fail)
+        : fail(fail)
+    {
+    }
+
+    Flaky(const Flaky& other)
+        : fail(other.fail)
+    {
+        if(fail)
+        {
+            throw std::runtime_error("Flaky copy");
+        }
+    }
+
+    Flaky(Flaky&& other)
+        : fail(other.fail)
+    {
+        if(fail)
+        {
+            throw std::runtime_error("Flaky move");
+        }
+    }
+
+    Flaky& operator=(const Flaky&) = default;
+
+    bool fail;
+};
+
+paco::Container record(int i)
+{
+    paco::Container container;
+    container.append<int>(i);
+    container.append<double>(i * 0.5);
+    container.append<std::string>(std::to_string(i));
+    container.append<bool>(i % 2 == 0);
+
+    return container;
+}
+
+void columnsAndRoundTrip()
+{
+    paco::ContainerBatch batch = paco::ContainerBatch::create<int, double, std::string, bool>();
+    PACO_CHECK(batch.columns() == 4);
+    PACO_CHECK(batch.specification() == record(0).specification());
+
+    for(int i = 0; i < 100; i++)
+    {
+        if(i % 2 == 0)
+        {
+            batch.append(record(i));
+        }
+        else
+        {
+            paco::Container container = record(i);
+            batch.append(container);
+            PACO_CHECK(container.get<std::string>(2) == std::to_string(i));
+        }
+    }
+
+    PACO_CHECK(batch.rows() == 100);
+
+    paco::ColumnSpan_T<const int> ints = static_cast<const paco::ContainerBatch&>(batch).column<int>(0);
+    paco::ColumnSpan_T<double> doubles = batch.column<double>(1);
+    paco::ColumnSpan_T<bool> bools = batch.column<bool>(3);
+    PACO_CHECK(ints.size() == 100 && doubles.size() == 100 && bools.size() == 100);
+
+    for(int i = 0; i < 100; i++)
+    {
+        PACO_CHECK(ints[i] == i);
+        PACO_CHECK(doubles[i] == i * 0.5);
+        PACO_CHECK(batch.column<std::string>(2)[i] == std::to_string(i));
+        PACO_CHECK(bools[i] == (i % 2 == 0));
+    }
+
+    doubles[7] = 42.0;
+
+    paco::Container seventh = batch.container(7);
+    PACO_CHECK(seventh.specification() == batch.specification());
+    PACO_CHECK(seventh.get<int>(0) == 7 && seventh.get<double>(1) == 42.0);
+    PACO_CHECK(seventh.get<std::string>(2) == "7" && !seventh.get<bool>(3));
+
+    batch.removeAt(0);
+    PACO_CHECK(batch.rows() == 99 && batch.column<int>(0)[0] == 1 && batch.column<std::string>(2).size() == 99);
+
+    PACO_CHECK_THROWS(batch.column<float>(0), std::bad_cast);
+    PACO_CHECK_THROWS(batch.container(99), std::out_of_range);
+
+    paco::Container wrong;
+    wrong.append<int>(1);
+    PACO_CHECK_THROWS(batch.append(wrong), std::bad_cast);
+    PACO_CHECK(batch.rows() == 99);
+
+    batch.clear();
+    PACO_CHECK(batch.rows() == 0 && batch.columns() == 4 && batch.column<int>(0).empty());
+}
+
+void failedAppendKeepsContainer()
+{
+    paco::ContainerBatch batch = paco::ContainerBatch::create<std::string, Flaky>();
+
+    paco::Container good;
+    good.append<std::string>("kept");
+    good.emplace<Flaky>(false);
+    batch.append(std::move(good));
+
+    paco::Container bad;
+    bad.append<std::string>(std::string(100, 'x'));
+    bad.emplace<Flaky>(true);
+
+    PACO_CHECK_THROWS(batch.append(std::move(bad)), std::runtime_error);
+    PACO_CHECK(bad.get<std::string>(0) == std::string(100, 'x'));
+    PACO_CHECK_THROWS(batch.append(bad), std::runtime_error);
+    PACO_CHECK(bad.get<std::string>(0) == std::string(100, 'x'));
+
+    PACO_CHECK(batch.rows() == 1);
+    PACO_CHECK(batch.column<std::string>(0).size() == 1 && batch.column<Flaky>(1).size() == 1);
+    PACO_CHECK(batch.column<std::string>(0)[0] == "kept");
+}
+
+void nonCopyableColumnRejectsCopies()
+{
+    paco::ContainerBatch batch = paco::ContainerBatch::create<std::string, std::unique_ptr<int> >();
+
+    paco::Container container;
+    container.append<std::string>("text");
+    container.append<std::unique_ptr<int> >(std::unique_ptr<int>(new int(3)));
+
+    PACO_CHECK_THROWS(batch.append(container), std::runtime_error);
+    PACO_CHECK(batch.rows() == 0 && batch.column<std::string>(0).empty());
+
+    batch.append(std::move(container));
+    PACO_CHECK(batch.rows() == 1 && *batch.column<std::unique_ptr<int> >(1)[0] == 3);
+    PACO_CHECK(batch.column<std::string>(0)[0] == "text");
+}
+
+}
+
+void runBatchTests(Runner& runner)
+{
+    runner.run("batch/columns_and_round_trip", columnsAndRoundTrip);
+    runner.run("batch/failed_append_keeps_container", failedAppendKeepsContainer);
+    runner.run("batch/non_copyable_column_rejects_copies", nonCopyableColumnRejectsCopies);
+}
+
+}
+}
@@ -0,0 +1,292 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Container.h"
+#include "ContainerChannel.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief checkRingWraparound pushes and pops batches of varying sizes, so the positions wrap many times.
+ */
+template <class Ring>
+void checkRingWraparound()
+{
+    Ring ring(5);
+    PACO_CHECK(ring.capacity() == 8);
+
+    int next = 0;
+    int expected = 0;
+    int items[16];
+
+    for(int round = 0; round < 1000; round++)
+    {
+        std::size_t count = round % 11;
+        std::size_t space = ring.capacity() - ring.size();
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            items[i] = next + (int)i;
+        }
+
+        std::size_t pushed = ring.tryPush(items, count);
+        PACO_CHECK(pushed == std::min(count, space));
+        next += (int)pushed;
+
+        std::size_t popped = ring.tryPop(items, round % 7);
+        for(std::size_t i = 0; i < popped; i++)
+        {
+            PACO_CHECK(items[i] == expected++);
+        }
+    }
+
+    while(std::size_t popped = ring.tryPop(items, 16))
+    {
+        for(std::size_t i = 0; i < popped; i++)
+        {
+            PACO_CHECK(items[i] == expected++);
+        }
+    }
+
+    PACO_CHECK(expected == next);
+    PACO_CHECK(ring.size() == 0);
+}
+
+void spscRingWraparound()
+{
+    checkRingWraparound<paco::SpscRing_T<int> >();
+}
+
+void mpmcRingWraparound()
+{
+    checkRingWraparound<paco::MpmcRing_T<int> >();
+}
+
+/**
+ * @brief numbered returns a container of a channel holding one int.
+ */
+template <class Channel>
+paco::Container* numbered(Channel& channel, int value)
+{
+    paco::Container* container = channel.acquire();
+    container->append<int>(value);
+
+    return container;
+}
+
+void pushBatchPartial()
+{
+    paco::SpscContainerChannel channel(4);
+    paco::Container* batch[6];
+
+    for(int i = 0; i < 6; i++)
+    {
+        batch[i] = numbered(channel, i);
+    }
+
+    PACO_CHECK(channel.tryPushBatch(batch, 6) == 4);
+    PACO_CHECK(channel.size() == 4);
+
+    paco::Container* popped[6];
+    PACO_CHECK(channel.tryPopBatch(popped, 3) == 3);
+    PACO_CHECK(channel.tryPushBatch(batch + 4, 2) == 2);
+
+    PACO_CHECK(channel.tryPopBatch(popped + 3, 6) == 3);
+    for(int i = 0; i < 6; i++)
+    {
+        PACO_CHECK(popped[i]->get<int>(0) == i);
+        channel.recycle(popped[i]);
+    }
+
+    PACO_CHECK(!channel.tryPop(popped[0]));
+}
+
+void closeDrainsAndRejects()
+{
+    paco::MpmcContainerChannel channel(8);
+
+    PACO_CHECK(channel.push(numbered(channel, 1)));
+    PACO_CHECK(channel.push(numbered(channel, 2)));
+    channel.close();
+    PACO_CHECK(channel.isClosed());
+
+    paco::Container* rejected = numbered(channel, 3);
+    PACO_CHECK(!channel.tryPush(rejected));
+    PACO_CHECK(!channel.push(rejected));
+    PACO_CHECK(channel.pushBatch(&rejected, 1) == 0);
+    channel.recycle(rejected);
+
+    paco::Container* container = nullptr;
+    PACO_CHECK(channel.pop(container) && container->get<int>(0) == 1);
+    channel.recycle(container);
+    PACO_CHECK(channel.pop(container) && container->get<int>(0) == 2);
+    channel.recycle(container);
+
+    PACO_CHECK(!channel.pop(container));
+    PACO_CHECK(channel.popBatch(&container, 1) == 0);
+}
+
+void recycleKeepsKeyTable()
+{
+    paco::SpscContainerChannel channel(4);
+
+    paco::Container* container = channel.acquire();
+    for(int i = 0; i < 20; i++)
+    {
+        container->append<int>("key" + std::to_string(i), i);
+    }
+
+    std::size_t filled = container->memoryUsage().storage;
+    channel.recycle(container);
+
+    paco::Container* recycled = channel.acquire();
+    PACO_CHECK(recycled == container);
+    PACO_CHECK(recycled->size() == 0 && !recycled->contains("key0"));
+    PACO_CHECK(recycled->memoryUsage().storage == filled);
+
+    recycled->append<int>("key5", 5);
+    PACO_CHECK(recycled->get<int>("key5") == 5);
+    PACO_CHECK(recycled->memoryUsage().storage == filled);
+
+    channel.recycle(recycled);
+}
+
+void spscChannelKeepsOrder()
+{
+    const int count = 100000;
+
+    paco::SpscContainerChannel channel(64);
+    bool ordered = true;
+
+    std::thread consumer([&]
+    {
+        paco::Container* batch[16];
+        int expected = 0;
+
+        while(std::size_t popped = channel.popBatch(batch, 16))
+        {
+            for(std::size_t i = 0; i < popped; i++)
+            {
+                ordered = ordered && batch[i]->get<int>(0) == expected++;
+                channel.recycle(batch[i]);
+            }
+        }
+
+        ordered = ordered && expected == count;
+    });
+
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(channel.push(numbered(channel, i)));
+    }
+
+    channel.close();
+    consumer.join();
+
+    PACO_CHECK(ordered);
+}
+
+void mpmcChannelStress()
+{
+    const int producers = 4;
+    const int consumers = 4;
+    const int perProducer = 25000;
+
+    paco::MpmcContainerChannel channel(32);
+    std::vector<std::vector<int> > received(consumers);
+    std::vector<std::thread> threads;
+
+    for(int c = 0; c < consumers; c++)
+    {
+        threads.push_back(std::thread([&, c]
+        {
+            paco::Container* container = nullptr;
+
+            while(channel.pop(container))
+            {
+                received[c].push_back(container->get<int>(0));
+                channel.recycle(container);
+            }
+        }));
+    }
+
+    std::vector<std::thread> writers;
+    for(int p = 0; p < producers; p++)
+    {
+        writers.push_back(std::thread([&, p]
+        {
+            for(int i = 0; i < perProducer; i++)
+            {
+                channel.push(numbered(channel, p * perProducer + i));
+            }
+        }));
+    }
+
+    for(std::size_t i = 0; i < writers.size(); i++)
+    {
+        writers[i].join();
+    }
+
+    channel.close();
+
+    for(std::size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    std::vector<int> seen(producers * perProducer, 0);
+    for(int c = 0; c < consumers; c++)
+    {
+        int last[producers] = {-1, -1, -1, -1};
+
+        for(std::size_t i = 0; i < received[c].size(); i++)
+        {
+            int value = received[c][i];
+            seen[value]++;
+
+            // every consumer sees the containers of one producer in the order they were pushed
+            PACO_CHECK(value > last[value / perProducer]);
+            last[value / perProducer] = value;
+        }
+    }
+
+    for(std::size_t i = 0; i < seen.size(); i++)
+    {
+        PACO_CHECK(seen[i] == 1);
+    }
+}
+
+}
+
+void runChannelTests(Runner& runner)
+{
+    runner.run("channel/spsc_ring_wraparound", spscRingWraparound);
+    runner.run("channel/mpmc_ring_wraparound", mpmcRingWraparound);
+    runner.run("channel/push_batch_partial", pushBatchPartial);
+    runner.run("channel/close_drains_and_rejects", closeDrainsAndRejects);
+    runner.run("channel/recycle_keeps_key_table", recycleKeepsKeyTable);
+    runner.run("channel/spsc_keeps_order", spscChannelKeepsOrder);
+    runner.run("channel/mpmc_stress", mpmcChannelStress);
+}
+
+}
+}
@@ -0,0 +1,269 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Container.h"
+#include "ContainerCodec.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Point struct is a flat type without registered codec.
+ */
+struct Point
+{
+    double x;
+    double y;
+};
+
+/**
+ * @brief The Sample struct is a flat type without default constructor, larger than the reference threshold.
+ */
+struct Sample
+{
+    explicit Sample(int value)
+    {
+        for(int i = 0; i < 64; i++)
+        {
+            values[i] = value + i;
+        }
+    }
+
+    int values[64];
+};
+
+/**
+ * @brief The Opaque struct is not flat and has no registered codec.
+ */
+struct Opaque
+{
+    std::string text;
+};
+
+/**
+ * @brief patchHeader encodes a container and overwrites its header with a modified copy.
+ */
+template <class F>
+std::vector<char> patchHeader(const paco::Container& container, F modify)
+{
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+
+    paco::ContainerCodec::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    modify(header);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    return bytes;
+}
+
+void roundTripFundamentals()
+{
+    paco::registerCodec<std::vector<double> >(&paco::encodeVector<double>, &paco::decodeVector<double>);
+
+    paco::Container container;
+    container.append<int>(42);
+    container.append<double>(2.5);
+    container.append<bool>(true);
+    container.append<std::string>("paco");
+    container.append<std::string>(std::string(1000, 'x'));
+    container.append<std::vector<double> >(std::vector<double>(100, 1.5));
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+    paco::Container decoded = paco::ContainerCodec::decode(bytes.data(), bytes.size());
+
+    PACO_CHECK(decoded.size() == container.size());
+    PACO_CHECK(decoded.specification() == container.specification());
+    PACO_CHECK(decoded.at(0)->get<int>() == 42);
+    PACO_CHECK(decoded.at(1)->get<double>() == 2.5);
+    PACO_CHECK(decoded.at(2)->get<bool>());
+    PACO_CHECK(decoded.at(3)->get<std::string>() == "paco");
+    PACO_CHECK(decoded.at(4)->get<std::string>() == std::string(1000, 'x'));
+    PACO_CHECK(decoded.at(5)->get<std::vector<double> >() == std::vector<double>(100, 1.5));
+}
+
+void roundTripEmpty()
+{
+    paco::Container container;
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+    paco::Container decoded = paco::ContainerCodec::decode(bytes.data(), bytes.size());
+
+    PACO_CHECK(bytes.size() == sizeof(paco::ContainerCodec::Header));
+    PACO_CHECK(decoded.size() == 0);
+}
+
+void roundTripUnregisteredFlat()
+{
+    paco::Container container;
+    container.append<Point>(Point{1.0, 2.0});
+    container.append<Sample>(Sample(7));
+    container.append<int>(3);
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+    paco::Container decoded = paco::ContainerCodec::decode(bytes.data(), bytes.size());
+
+    PACO_CHECK(decoded.specification() == container.specification());
+    PACO_CHECK(decoded.at(0)->get<Point>().x == 1.0);
+    PACO_CHECK(decoded.at(0)->get<Point>().y == 2.0);
+    PACO_CHECK(decoded.at(1)->get<Sample>().values[0] == 7);
+    PACO_CHECK(decoded.at(1)->get<Sample>().values[63] == 70);
+    PACO_CHECK(decoded.at(2)->get<int>() == 3);
+}
+
+void encodeInPlace()
+{
+    paco::Container container;
+    container.append<int>(42);
+    container.append<std::string>("paco");
+    container.append<std::string>(std::string(1000, 'x'));
+    container.append<Sample>(Sample(7));
+    container.append<Point>(Point{1.0, 2.0});
+
+    std::vector<char> gathered = paco::ContainerCodec::encode(container);
+    PACO_CHECK(paco::ContainerCodec::encodedSize(container) == gathered.size());
+
+    // the in place output is byte for byte the gathered one, and a too small destination is never overrun
+    std::vector<char> direct(gathered.size() + 8, '?');
+    paco::PacketWriter writer(direct.data(), gathered.size());
+    paco::ContainerCodec::encode(container, writer);
+    PACO_CHECK(writer.size() == gathered.size());
+    PACO_CHECK(std::memcmp(direct.data(), gathered.data(), gathered.size()) == 0);
+    PACO_CHECK(direct[gathered.size()] == '?');
+
+    std::vector<char> copied(writer.size());
+    writer.copyTo(copied.data());
+    PACO_CHECK(copied == gathered);
+
+    paco::PacketWriter small(direct.data(), gathered.size() - 8);
+    PACO_CHECK_THROWS(paco::ContainerCodec::encode(container, small), std::length_error);
+
+    paco::Container empty;
+    PACO_CHECK(paco::ContainerCodec::encodedSize(empty) == sizeof(paco::ContainerCodec::Header));
+}
+
+void rejectUnregisteredOpaque()
+{
+    paco::Container container;
+    container.append<Opaque>(Opaque{"text"});
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::encode(container), std::runtime_error);
+}
+
+void rejectSizeBelowHeader()
+{
+    paco::Container container;
+    container.append<int>(1);
+
+    std::vector<char> bytes = patchHeader(container, [](paco::ContainerCodec::Header& header)
+    {
+        header.size = 0;
+        header.count = 100000;
+    });
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::header(bytes.data(), bytes.size()), std::runtime_error);
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size()), std::runtime_error);
+    PACO_CHECK_THROWS(paco::ContainerCodec::specification(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+void rejectCountBeyondSize()
+{
+    paco::Container container;
+    container.append<int>(1);
+
+    std::vector<char> bytes = patchHeader(container, [](paco::ContainerCodec::Header& header)
+    {
+        header.count = 2;
+    });
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+void rejectTruncated()
+{
+    paco::Container container;
+    container.append<std::string>("truncated");
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size() - 1), std::runtime_error);
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), sizeof(paco::ContainerCodec::Header) - 1), std::runtime_error);
+}
+
+void rejectBadMagic()
+{
+    paco::Container container;
+
+    std::vector<char> bytes = patchHeader(container, [](paco::ContainerCodec::Header& header)
+    {
+        header.magic = 0;
+    });
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+void rejectPayloadOutside()
+{
+    paco::Container container;
+    container.append<double>(1.0);
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+
+    paco::ContainerCodec::Entry entry = paco::ContainerCodec::entry(bytes.data(), 0);
+    entry.offset = bytes.size();
+    std::memcpy(bytes.data() + sizeof(paco::ContainerCodec::Header), &entry, sizeof(entry));
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+void rejectShortFlatPayload()
+{
+    paco::Container container;
+    container.append<Point>(Point{1.0, 2.0});
+
+    std::vector<char> bytes = paco::ContainerCodec::encode(container);
+
+    paco::ContainerCodec::Entry entry = paco::ContainerCodec::entry(bytes.data(), 0);
+    entry.size = sizeof(double);
+    std::memcpy(bytes.data() + sizeof(paco::ContainerCodec::Header), &entry, sizeof(entry));
+
+    PACO_CHECK_THROWS(paco::ContainerCodec::decode(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+}
+
+void runCodecTests(Runner& runner)
+{
+    runner.run("codec/round_trip_fundamentals", roundTripFundamentals);
+    runner.run("codec/round_trip_empty", roundTripEmpty);
+    runner.run("codec/round_trip_unregistered_flat", roundTripUnregisteredFlat);
+    runner.run("codec/encode_in_place", encodeInPlace);
+    runner.run("codec/reject_unregistered_opaque", rejectUnregisteredOpaque);
+    runner.run("codec/reject_size_below_header", rejectSizeBelowHeader);
+    runner.run("codec/reject_count_beyond_size", rejectCountBeyondSize);
+    runner.run("codec/reject_truncated", rejectTruncated);
+    runner.run("codec/reject_bad_magic", rejectBadMagic);
+    runner.run("codec/reject_payload_outside", rejectPayloadOutside);
+    runner.run("codec/reject_short_flat_payload", rejectShortFlatPayload);
+}
+
+}
+}
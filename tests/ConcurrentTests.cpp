@@ -0,0 +1,177 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentContainer.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Throwing struct throws from its constructor for negative values.
+ */
+struct Throwing
+{
+    explicit Throwing(int value)
+        : value(value)
+    {
+        if(value < 0)
+        {
+            throw std::runtime_error("negative value");
+        }
+    }
+
+    int value;
+};
+
+const int Threads = 8;
+const int AppendsPerThread = 20000;
+
+void stressAppend()
+{
+    paco::ConcurrentContainer container;
+    std::atomic<bool> done(false);
+    std::atomic<bool> readerFailed(false);
+
+    // the reader checks that the published prefix never has holes while the writers run
+    std::thread reader([&]()
+    {
+        while(!done.load())
+        {
+            std::size_t published = container.publishedSize();
+
+            for(std::size_t i = 0; i < published; i++)
+            {
+                if(container.at(i) == nullptr)
+                {
+                    readerFailed.store(true);
+                }
+            }
+        }
+    });
+
+    std::vector<std::thread> writers;
+
+    for(int t = 0; t < Threads; t++)
+    {
+        writers.push_back(std::thread([&container, t]()
+        {
+            for(int i = 0; i < AppendsPerThread; i++)
+            {
+                int value = t * AppendsPerThread + i;
+
+                if(i % 4 == 0)
+                {
+                    container.append<std::string>(std::to_string(value));
+                }
+                else
+                {
+                    container.append<int>(value);
+                }
+            }
+        }));
+    }
+
+    for(std::size_t t = 0; t < writers.size(); t++)
+    {
+        writers[t].join();
+    }
+
+    done.store(true);
+    reader.join();
+
+    std::size_t total = Threads * AppendsPerThread;
+
+    PACO_CHECK(!readerFailed.load());
+    PACO_CHECK(container.size() == total);
+    PACO_CHECK(container.publishedSize() == total);
+    PACO_CHECK(container.specification().size() == (int)total);
+
+    std::vector<bool> seen(total, false);
+
+    for(std::size_t i = 0; i < total; i++)
+    {
+        paco::Packet* packet = container.at(i);
+        PACO_CHECK(packet != nullptr);
+
+        int value = packet->is<int>() ? packet->get<int>() : std::stoi(packet->get<std::string>());
+        PACO_CHECK(value >= 0 && value < (int)total && !seen[value]);
+        PACO_CHECK(packet->is<std::string>() == (value % AppendsPerThread % 4 == 0));
+
+        seen[value] = true;
+    }
+
+    PACO_CHECK(std::find(seen.begin(), seen.end(), false) == seen.end());
+}
+
+void throwingConstructorLeavesNoGap()
+{
+    paco::ConcurrentContainer container;
+    std::vector<std::thread> writers;
+    std::atomic<int> thrown(0);
+
+    for(int t = 0; t < Threads; t++)
+    {
+        writers.push_back(std::thread([&container, &thrown]()
+        {
+            for(int i = 0; i < 1000; i++)
+            {
+                try
+                {
+                    container.emplace<Throwing>(i % 3 == 0 ? -1 : i);
+                }
+                catch(const std::runtime_error&)
+                {
+                    thrown++;
+                }
+            }
+        }));
+    }
+
+    for(std::size_t t = 0; t < writers.size(); t++)
+    {
+        writers[t].join();
+    }
+
+    std::size_t total = Threads * 1000 - thrown.load();
+
+    PACO_CHECK(thrown.load() == Threads * 334);
+    PACO_CHECK(container.size() == total);
+    PACO_CHECK(container.publishedSize() == total);
+
+    for(std::size_t i = 0; i < total; i++)
+    {
+        PACO_CHECK(container.at(i) != nullptr && container.at(i)->get_if<Throwing>()->value > 0);
+    }
+}
+
+}
+
+void runConcurrentTests(Runner& runner)
+{
+    runner.run("concurrent/stress_append", stressAppend);
+    runner.run("concurrent/throwing_constructor_leaves_no_gap", throwingConstructorLeavesNoGap);
+}
+
+}
+}
@@ -0,0 +1,393 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Container.h"
+#include "SlotMapContainer.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Fragile struct throws when moved from an instance marked as failing.
+ */
+struct Fragile
+{
+    Fragile(int value, bool fail)
+        : value(value), fail(fail)
+    {
+    }
+
+    Fragile(Fragile&& other)
+        : value(other.value), fail(other.fail)
+    {
+        if(fail)
+        {
+            throw std::runtime_error("Fragile");
+        }
+    }
+
+    int value;
+    bool fail;
+};
+
+/**
+ * @brief The CountingResource class counts the bytes allocated from the global heap through it.
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+
+    CountingResource()
+        : allocated(0), outstanding(0)
+    {
+    }
+
+    std::size_t allocated;
+    std::size_t outstanding;
+
+private:
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        allocated += bytes;
+        outstanding += bytes;
+
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/**
+ * @brief checkTypeIndex compares count<T>(), indexOf<T>() and range<T>() with a scan of the container.
+ */
+template <class T>
+void checkTypeIndex(paco::Container& container)
+{
+    std::vector<int> expected;
+
+    for(int i = 0; i < container.size(); i++)
+    {
+        if(container.at(i)->is<T>())
+        {
+            expected.push_back(i);
+        }
+    }
+
+    PACO_CHECK(container.count<T>() == (int)expected.size());
+    PACO_CHECK(container.indexOf<T>() == (expected.empty() ? -1 : expected.front()));
+
+    paco::TypedRange_T<T> range = container.range<T>();
+    PACO_CHECK(range.size() == (int)expected.size());
+
+    int n = 0;
+    for(typename paco::TypedRange_T<T>::Iterator it = range.begin(); it != range.end(); ++it, n++)
+    {
+        PACO_CHECK(it.index() == expected[n]);
+        PACO_CHECK(&*it == container.at(expected[n])->get_if<T>());
+        PACO_CHECK(&range[n] == &*it);
+    }
+
+    PACO_CHECK(n == (int)expected.size());
+
+    const paco::Container& constContainer = container;
+    PACO_CHECK(constContainer.range<T>().size() == (int)expected.size());
+}
+
+void typeIndexFollowsModifications()
+{
+    std::mt19937 random(7);
+    paco::Container container;
+
+    for(int step = 0; step < 4000; step++)
+    {
+        int size = container.size();
+        int operation = random() % 10;
+        int index = size > 0 ? random() % size : 0;
+
+        if(operation < 4 || size == 0)
+        {
+            if(random() % 2 == 0)
+            {
+                container.append<int>(step);
+            }
+            else
+            {
+                container.append<std::string>(std::to_string(step));
+            }
+        }
+        else if(operation < 6)
+        {
+            container.insert<double>(random() % (size + 1), step);
+        }
+        else if(operation < 8)
+        {
+            container.removeAt(index);
+        }
+        else if(operation < 9)
+        {
+            container.replace<int>(index, step);
+        }
+        else if(step % 500 == 0)
+        {
+            container.clear();
+        }
+
+        checkTypeIndex<int>(container);
+        checkTypeIndex<double>(container);
+        checkTypeIndex<std::string>(container);
+        checkTypeIndex<float>(container);
+    }
+}
+
+void smallContainerAllocatesNoIndex()
+{
+    paco::Container container;
+
+    for(int i = 0; i < paco::TypeIndex::Threshold; i++)
+    {
+        container.append<int>(i);
+    }
+
+    std::size_t storage = container.memoryUsage().storage;
+
+    checkTypeIndex<int>(container);
+    PACO_CHECK(container.memoryUsage().storage == storage);
+
+    container.append<int>(paco::TypeIndex::Threshold);
+    checkTypeIndex<int>(container);
+    PACO_CHECK(container.memoryUsage().storage > storage);
+}
+
+/**
+ * @brief rebuilt returns a fresh specification with the packet types of specification, appended one by one.
+ */
+paco::Specification rebuilt(const paco::Specification& specification)
+{
+    paco::Container container;
+
+    for(int i = 0; i < specification.size(); i++)
+    {
+        if(specification.at(i).typeId() == paco::PacketTypeRegistry::id<int>())
+        {
+            container.append<int>(0);
+        }
+        else if(specification.at(i).typeId() == paco::PacketTypeRegistry::id<double>())
+        {
+            container.append<double>(0.0);
+        }
+        else
+        {
+            container.append<std::string>(std::string());
+        }
+    }
+
+    return container.specification();
+}
+
+void fingerprintFollowsModifications()
+{
+    std::mt19937 random(11);
+    paco::Container container;
+
+    for(int step = 0; step < 2000; step++)
+    {
+        int size = container.size();
+        int operation = random() % 8;
+        int index = size > 0 ? random() % size : 0;
+
+        if(operation < 3 || size == 0)
+        {
+            container.append<int>(step);
+        }
+        else if(operation < 5)
+        {
+            container.insert<std::string>(random() % (size + 1), "text");
+        }
+        else if(operation < 6)
+        {
+            container.removeAt(index);
+        }
+        else
+        {
+            container.replace<double>(index, step);
+        }
+
+        paco::Specification expected = rebuilt(container.specification());
+
+        PACO_CHECK(container.specification().fingerprint() == expected.fingerprint());
+        PACO_CHECK(container.specification() == expected);
+    }
+
+    container.clear();
+    PACO_CHECK(container.specification().fingerprint() == paco::Specification().fingerprint());
+}
+
+void movedFromContainerIsReusable()
+{
+    paco::Specification expected;
+    expected.append<int>();
+
+    paco::Container a;
+    for(int i = 0; i < 2 * paco::TypeIndex::Threshold; i++)
+    {
+        a.append<double>("value" + std::to_string(i), i);
+    }
+
+    paco::Container b(std::move(a));
+    PACO_CHECK(b.size() == 2 * paco::TypeIndex::Threshold);
+    PACO_CHECK(a.size() == 0);
+    PACO_CHECK(a.specification().size() == 0);
+    PACO_CHECK(a.specification().fingerprint() == paco::Specification().fingerprint());
+    PACO_CHECK(!a.contains("value0"));
+
+    a.append<int>(5);
+    PACO_CHECK(a.matches(expected));
+    checkTypeIndex<int>(a);
+    checkTypeIndex<double>(a);
+
+    paco::Container c;
+    c.append<float>(1.0f);
+    c = std::move(b);
+    PACO_CHECK(c.size() == 2 * paco::TypeIndex::Threshold);
+    PACO_CHECK(c.get<double>("value3") == 3.0);
+    PACO_CHECK(b.size() == 0 && b.specification().size() == 0);
+
+    b.append<int>(6);
+    PACO_CHECK(b.matches(expected));
+    PACO_CHECK(b.indexOf<int>() == 0);
+}
+
+void keyIndexUsesMemoryResource()
+{
+    CountingResource keyedResource;
+    CountingResource unkeyedResource;
+
+    {
+        paco::Container keyed(&keyedResource);
+        paco::Container unkeyed(&unkeyedResource);
+
+        for(int i = 0; i < 100; i++)
+        {
+            keyed.append<int>("key" + std::to_string(i), i);
+            unkeyed.append<int>(i);
+        }
+
+        PACO_CHECK(keyed.get<int>("key42") == 42);
+
+        // the only difference is the key table
+        PACO_CHECK(keyedResource.allocated > unkeyedResource.allocated);
+    }
+
+    PACO_CHECK(keyedResource.outstanding == 0);
+}
+
+void nameLookupsDoNotIntern()
+{
+    paco::PacketTypeRegistry& registry = paco::PacketTypeRegistry::instance();
+
+    paco::Container container;
+    container.append<int>("lookup_first", 1);
+    container.append<std::string>(std::string("lookup_second"), "two");
+
+    const std::string second = "lookup_second";
+    const std::string_view first = "lookup_first";
+
+    PACO_CHECK(container.contains("lookup_first") && container.contains(second) && container.contains(first));
+    PACO_CHECK(container.indexOf(second) == 1 && container.indexOf(first) == 0);
+    PACO_CHECK(container.get<int>("lookup_first") == 1 && container.get<std::string>(second) == "two");
+    PACO_CHECK(container.at(first)->get<int>() == 1 && container.get_if<double>(first) == nullptr);
+
+    container.replace<int>("lookup_first", 3);
+    PACO_CHECK(container.get<int>(first) == 3 && container.key(0) == paco::SlotKey("lookup_first"));
+
+    // none of the lookups of a name that was never used as a key may intern it
+    PACO_CHECK(!container.contains("lookup_never_created"));
+    PACO_CHECK(container.indexOf(std::string("lookup_never_created")) == -1);
+    PACO_CHECK(container.get_if<int>(std::string_view("lookup_never_created")) == nullptr);
+    PACO_CHECK_THROWS(container.get<int>("lookup_never_created"), std::out_of_range);
+    PACO_CHECK_THROWS(container.at("lookup_never_created"), std::out_of_range);
+    PACO_CHECK_THROWS(container.replace<int>("lookup_never_created", 4), std::out_of_range);
+    PACO_CHECK(registry.findDescription("lookup_never_created") == nullptr);
+    PACO_CHECK(paco::SlotKey::find("lookup_never_created").isNull());
+
+    try
+    {
+        container.get<int>("lookup_never_created");
+    }
+    catch(const std::out_of_range& e)
+    {
+        PACO_CHECK(std::string(e.what()).find("lookup_never_created") != std::string::npos);
+    }
+
+    // names interned by other containers are found, also after the name table has grown
+    for(int i = 0; i < 100; i++)
+    {
+        paco::SlotKey("lookup_grow" + std::to_string(i));
+    }
+
+    PACO_CHECK(registry.findDescription("lookup_grow99") != nullptr);
+    PACO_CHECK(paco::SlotKey::find("lookup_grow42") == paco::SlotKey("lookup_grow42"));
+    PACO_CHECK(container.indexOf("lookup_first") == 0 && !container.contains("lookup_grow0"));
+}
+
+void slotMapReplaceKeepsObjectOnThrow()
+{
+    paco::SlotMapContainer container;
+    paco::SlotHandle first = container.emplace<Fragile>(1, false);
+    paco::SlotHandle second = container.append<int>(2);
+
+    PACO_CHECK_THROWS(container.replace<Fragile>(first, Fragile(3, true)), std::runtime_error);
+    PACO_CHECK(container.size() == 2);
+    PACO_CHECK(container.get<Fragile>(first).value == 1);
+
+    container.replace<Fragile>(first, Fragile(4, false));
+    PACO_CHECK(container.get<Fragile>(first).value == 4);
+    PACO_CHECK(container.get<int>(second) == 2);
+}
+
+}
+
+void runContainerTests(Runner& runner)
+{
+    runner.run("container/type_index_follows_modifications", typeIndexFollowsModifications);
+    runner.run("container/small_container_allocates_no_index", smallContainerAllocatesNoIndex);
+    runner.run("container/fingerprint_follows_modifications", fingerprintFollowsModifications);
+    runner.run("container/moved_from_container_is_reusable", movedFromContainerIsReusable);
+    runner.run("container/key_index_uses_memory_resource", keyIndexUsesMemoryResource);
+    runner.run("container/name_lookups_do_not_intern", nameLookupsDoNotIntern);
+    runner.run("container/slot_map_replace_keeps_object_on_throw", slotMapReplaceKeepsObjectOnThrow);
+}
+
+}
+}
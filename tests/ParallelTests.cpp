@@ -0,0 +1,85 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdint>
+#include <string>
+
+#include "Container.h"
+#include "Parallel.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+void reducePackets()
+{
+    paco::parallel::ThreadPool pool(4);
+    paco::parallel::Options options(16, &pool);
+
+    paco::Container container;
+    std::uint64_t expected = 0;
+
+    for(int i = 0; i < 1000; i++)
+    {
+        if(i % 3 == 0)
+        {
+            container.append<std::string>(std::string(i % 7, 'x'));
+            expected += i % 7;
+        }
+        else
+        {
+            container.append<int>(i);
+            expected += i;
+        }
+    }
+
+    std::uint64_t sum = paco::parallel::reduce(container, std::uint64_t(0), [](const paco::Packet& packet) -> std::uint64_t
+    {
+        return packet.is<int>() ? packet.get_cref<int>() : packet.get_cref<std::string>().size();
+    }, [](std::uint64_t a, std::uint64_t b) { return a + b; }, options);
+
+    PACO_CHECK(sum == expected);
+
+    int count = paco::parallel::reduce(container, 0, [](const paco::Packet&) { return 1; }, [](int a, int b) { return a + b; });
+    PACO_CHECK(count == container.size());
+
+    paco::Container empty;
+    PACO_CHECK(paco::parallel::reduce(empty, 5, [](const paco::Packet&) { return 1; }, [](int a, int b) { return a + b; }) == 5);
+}
+
+void reduceTypedStillSelected()
+{
+    paco::Container container;
+
+    for(int i = 0; i < 100; i++)
+    {
+        container.append<int>(i);
+        container.append<double>(0.5);
+    }
+
+    int sum = paco::parallel::reduce<int>(container, 0, [](const int& value) { return value; }, [](int a, int b) { return a + b; });
+    PACO_CHECK(sum == 4950);
+}
+
+}
+
+void runParallelTests(Runner& runner)
+{
+    runner.run("parallel/reduce_packets", reducePackets);
+    runner.run("parallel/reduce_typed_still_selected", reduceTypedStillSelected);
+}
+
+}
+}
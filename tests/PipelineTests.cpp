@@ -0,0 +1,360 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#include "Container.h"
+#include "Pipeline.h"
+#include "Specification.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief ints returns the specification of a container holding one int.
+ */
+paco::Specification ints()
+{
+    paco::Specification specification;
+    specification.append<int>();
+
+    return specification;
+}
+
+/**
+ * @brief pushNumber pushes a container holding value into an entry stage, the container is recycled if that fails.
+ */
+bool pushNumber(paco::Pipeline& pipeline, int stage, int value)
+{
+    paco::Container* container = pipeline.acquire();
+    container->append<int>(value);
+
+    try
+    {
+        if(pipeline.push(stage, container))
+        {
+            return true;
+        }
+    }
+    catch(...)
+    {
+        pipeline.recycle(container);
+        throw;
+    }
+
+    pipeline.recycle(container);
+
+    return false;
+}
+
+/**
+ * @brief drain pops all containers that leave the pipeline and returns how often each value arrived.
+ */
+std::vector<int> drain(paco::Pipeline& pipeline, std::size_t values)
+{
+    std::vector<int> seen(values, 0);
+    paco::Container* batch[8];
+
+    while(std::size_t popped = pipeline.popBatch(batch, 8))
+    {
+        for(std::size_t i = 0; i < popped; i++)
+        {
+            int value = batch[i]->get<int>(0);
+
+            if(value >= 0 && value < (int)values)
+            {
+                seen[value]++;
+            }
+
+            pipeline.recycle(batch[i]);
+        }
+    }
+
+    return seen;
+}
+
+void linearGraph()
+{
+    const int count = 20000;
+
+    paco::Pipeline pipeline(16, 4);
+    int twice = pipeline.addStage("twice", ints(), ints(), [](paco::Container& c) { c.replace<int>(0, c.get<int>(0) * 2); });
+    int plusOne = pipeline.addStage("plus_one", ints(), ints(), [](paco::Container& c) { c.replace<int>(0, c.get<int>(0) + 1); }, 3);
+    pipeline.connect(twice, plusOne);
+    pipeline.start();
+
+    std::vector<int> seen;
+    std::thread consumer([&] { seen = drain(pipeline, 2 * count + 1); });
+
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(pushNumber(pipeline, twice, i));
+    }
+
+    pipeline.wait();
+    consumer.join();
+
+    for(int i = 0; i < 2 * count + 1; i++)
+    {
+        PACO_CHECK(seen[i] == i % 2);
+    }
+
+    std::vector<paco::StageStatistics> statistics = pipeline.statistics();
+    PACO_CHECK(statistics.size() == 2 && statistics[1].name == "plus_one" && statistics[1].workers == 3);
+    PACO_CHECK(statistics[0].processed == (std::uint64_t)count && statistics[1].processed == (std::uint64_t)count);
+    PACO_CHECK(statistics[0].queueDepth == 0 && statistics[0].queueCapacity == 16);
+    PACO_CHECK(pipeline.outputDepth() == 0);
+}
+
+void fanInGraph()
+{
+    const int count = 10000;
+
+    std::atomic<std::int64_t> sum(0);
+    std::atomic<int> consumed(0);
+
+    paco::Pipeline pipeline(8, 3);
+    int left = pipeline.addStage("left", ints(), ints(), [](paco::Container&) {});
+    int right = pipeline.addStage("right", ints(), ints(), [](paco::Container& c) { c.replace<int>(0, -c.get<int>(0)); }, 2);
+    int sink = pipeline.addSink("sum", ints(), [&](paco::Container& c) { sum += c.get<int>(0) * 3; consumed++; }, 2);
+    pipeline.connect(left, sink);
+    pipeline.connect(right, sink);
+    pipeline.start();
+
+    std::thread second([&]
+    {
+        for(int i = 0; i < count; i++)
+        {
+            pushNumber(pipeline, right, i);
+        }
+    });
+
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(pushNumber(pipeline, left, 2 * i));
+    }
+
+    second.join();
+    pipeline.wait();
+
+    // sum of 3 * (2i - i) over all i
+    PACO_CHECK(consumed.load() == 2 * count);
+    PACO_CHECK(sum.load() == 3 * (std::int64_t)count * (count - 1) / 2);
+
+    // sinks recycle their containers, nothing leaves the graph
+    paco::Container* container = nullptr;
+    PACO_CHECK(!pipeline.pop(container));
+    PACO_CHECK_THROWS(pushNumber(pipeline, left, 0), std::logic_error);
+}
+
+void throwingStageRethrowsFirst()
+{
+    const int count = 100;
+
+    paco::Pipeline pipeline(1024, 8);
+    int check = pipeline.addStage("check", ints(), ints(), [](paco::Container& c)
+    {
+        if(c.get<int>(0) % 10 == 3)
+        {
+            throw std::runtime_error(std::to_string(c.get<int>(0)));
+        }
+    });
+    pipeline.start();
+
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(pushNumber(pipeline, check, i));
+    }
+
+    std::string message;
+    try
+    {
+        pipeline.wait();
+    }
+    catch(const std::runtime_error& e)
+    {
+        message = e.what();
+    }
+
+    // one worker processes the containers in order, so the first failure is the one of 3
+    PACO_CHECK(message == "3");
+
+    std::vector<int> seen = drain(pipeline, count);
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(seen[i] == (i % 10 == 3 ? 0 : 1));
+    }
+
+    PACO_CHECK(pipeline.statistics()[0].processed == (std::uint64_t)count);
+
+    // the error has been reported, waiting again does not rethrow it
+    pipeline.wait();
+}
+
+void destructionDrainsOutput()
+{
+    std::atomic<int> processed(0);
+
+    {
+        paco::Pipeline pipeline(4, 1);
+        int stage = pipeline.addStage("count", ints(), ints(), [&](paco::Container&) { processed++; });
+        pipeline.start();
+
+        // four fill the output queue, the worker blocks with the fifth and the last three wait in its queue
+        for(int i = 0; i < 8; i++)
+        {
+            PACO_CHECK(pushNumber(pipeline, stage, i));
+        }
+
+        while(pipeline.outputDepth() < 4 || processed.load() < 5)
+        {
+            std::this_thread::yield();
+        }
+
+        // leaving the scope without wait() or pop() must neither hang nor leak
+    }
+
+    PACO_CHECK(processed.load() == 8);
+}
+
+void backpressureBlocksPush()
+{
+    const int count = 50;
+
+    std::atomic<bool> open(false);
+    std::atomic<int> pushed(0);
+
+    paco::Pipeline pipeline(4, 2);
+    int gate = pipeline.addStage("gate", ints(), ints(), [&](paco::Container&)
+    {
+        while(!open.load())
+        {
+            std::this_thread::yield();
+        }
+    });
+    pipeline.start();
+
+    std::thread producer([&]
+    {
+        for(int i = 0; i < count; i++)
+        {
+            pushNumber(pipeline, gate, i);
+            pushed++;
+        }
+    });
+
+    while(pushed.load() < 4)
+    {
+        std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // the closed gate holds at most one batch, the queue in front of it the rest
+    PACO_CHECK(pushed.load() <= 4 + 2);
+    PACO_CHECK(pipeline.statistics()[0].queueDepth == 4);
+
+    open = true;
+
+    std::vector<int> seen;
+    std::thread consumer([&] { seen = drain(pipeline, count); });
+
+    producer.join();
+    pipeline.wait();
+    consumer.join();
+
+    PACO_CHECK(pushed.load() == count);
+    for(int i = 0; i < count; i++)
+    {
+        PACO_CHECK(seen[i] == 1);
+    }
+}
+
+void validateRejectsGraphs()
+{
+    paco::Specification doubles;
+    doubles.append<double>();
+
+    paco::Pipeline::StageFunction nothing = [](paco::Container&) {};
+
+    {
+        paco::Pipeline pipeline;
+        int convert = pipeline.addStage("convert", ints(), doubles, nothing);
+        int store = pipeline.addSink("store", ints(), nothing);
+        pipeline.connect(convert, store);
+        PACO_CHECK_THROWS(pipeline.start(), std::logic_error);
+    }
+
+    {
+        paco::Pipeline pipeline;
+        int entry = pipeline.addStage("entry", ints(), ints(), nothing);
+        int a = pipeline.addStage("a", ints(), ints(), nothing);
+        int b = pipeline.addStage("b", ints(), ints(), nothing);
+        pipeline.connect(entry, a);
+        pipeline.connect(a, b);
+        pipeline.connect(b, a);
+        PACO_CHECK_THROWS(pipeline.start(), std::logic_error);
+    }
+
+    {
+        paco::Pipeline pipeline;
+        int a = pipeline.addStage("a", ints(), ints(), nothing);
+        int b = pipeline.addStage("b", ints(), ints(), nothing);
+        int sink = pipeline.addSink("sink", ints(), nothing);
+        pipeline.connect(a, b);
+
+        PACO_CHECK_THROWS(pipeline.connect(a, sink), std::logic_error);
+        PACO_CHECK_THROWS(pipeline.connect(sink, a), std::logic_error);
+        PACO_CHECK_THROWS(pipeline.connect(b, 7), std::out_of_range);
+        PACO_CHECK_THROWS(pushNumber(pipeline, a, 1), std::logic_error);
+
+        pipeline.connect(b, sink);
+        pipeline.start();
+
+        paco::Container* wrong = pipeline.acquire();
+        wrong->append<double>(1.0);
+        PACO_CHECK_THROWS(pipeline.push(a, wrong), std::bad_cast);
+        pipeline.recycle(wrong);
+
+        PACO_CHECK_THROWS(pushNumber(pipeline, b, 1), std::logic_error);
+        PACO_CHECK_THROWS(pipeline.start(), std::logic_error);
+        PACO_CHECK(pushNumber(pipeline, a, 1));
+
+        pipeline.wait();
+    }
+}
+
+}
+
+void runPipelineTests(Runner& runner)
+{
+    runner.run("pipeline/linear_graph", linearGraph);
+    runner.run("pipeline/fan_in_graph", fanInGraph);
+    runner.run("pipeline/throwing_stage_rethrows_first", throwingStageRethrowsFirst);
+    runner.run("pipeline/destruction_drains_output", destructionDrainsOutput);
+    runner.run("pipeline/backpressure_blocks_push", backpressureBlocksPush);
+    runner.run("pipeline/validate_rejects_graphs", validateRejectsGraphs);
+}
+
+}
+}
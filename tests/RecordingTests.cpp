@@ -0,0 +1,189 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACO_NO_QT
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "Container.h"
+#include "ContainerRecording.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Recording class is a temporary recording that is removed when the test case ends.
+ */
+class Recording
+{
+public:
+
+    explicit Recording(const std::string& name)
+        : mPath((std::filesystem::temp_directory_path() / ("paco_test_" + name + ".rec")).string())
+    {
+        remove();
+    }
+
+    ~Recording()
+    {
+        remove();
+    }
+
+    QString path() const
+    {
+        return QString::fromStdString(mPath);
+    }
+
+    std::string indexPath() const
+    {
+        return mPath + ".index";
+    }
+
+    /**
+     * @brief appendToIndex appends raw bytes to the index file, like an interrupted write.
+     */
+    void appendToIndex(const void* data, std::size_t size) const
+    {
+        std::ofstream file(indexPath().c_str(), std::ios::binary | std::ios::app);
+        file.write((const char*)data, size);
+    }
+
+private:
+
+    void remove()
+    {
+        std::filesystem::remove(mPath);
+        std::filesystem::remove(indexPath());
+    }
+
+    std::string mPath;
+};
+
+paco::Container numbered(int value)
+{
+    paco::Container container;
+    container.append<int>(value);
+    container.append<std::string>(std::to_string(value));
+
+    return container;
+}
+
+void record(const Recording& recording, int first, int last)
+{
+    paco::ContainerRecordWriter writer(recording.path());
+
+    for(int i = first; i < last; i++)
+    {
+        writer.append(numbered(i));
+    }
+
+    writer.flush();
+}
+
+void checkRecorded(const Recording& recording, std::size_t count)
+{
+    paco::ContainerRecordReader reader(recording.path());
+
+    PACO_CHECK(reader.count() == count);
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        paco::Container container = reader.container(i);
+
+        PACO_CHECK(container.at(0)->get<int>() == (int)i);
+        PACO_CHECK(container.at(1)->get<std::string>() == std::to_string(i));
+    }
+}
+
+void continueRecording()
+{
+    Recording recording("continue");
+
+    record(recording, 0, 2);
+    record(recording, 2, 5);
+
+    checkRecorded(recording, 5);
+}
+
+void continueAfterTornEntry()
+{
+    Recording recording("torn_entry");
+
+    record(recording, 0, 2);
+
+    const char torn[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    recording.appendToIndex(torn, sizeof(torn));
+
+    {
+        paco::ContainerRecordWriter writer(recording.path());
+        PACO_CHECK(writer.count() == 2);
+        PACO_CHECK((std::size_t)std::filesystem::file_size(recording.indexPath())
+                   == sizeof(paco::ContainerRecording::FileHeader) + 2 * sizeof(paco::ContainerRecording::Entry));
+    }
+
+    record(recording, 2, 4);
+
+    checkRecorded(recording, 4);
+}
+
+void continueAfterEntryBeyondData()
+{
+    Recording recording("beyond_data");
+
+    record(recording, 0, 3);
+
+    paco::ContainerRecording::Entry entry;
+    entry.offset = 1 << 30;
+    entry.size = 64;
+    entry.fingerprint = 0;
+    recording.appendToIndex(&entry, sizeof(entry));
+
+    record(recording, 3, 4);
+
+    checkRecorded(recording, 4);
+}
+
+void rejectForeignIndex()
+{
+    Recording recording("foreign_index");
+
+    record(recording, 0, 1);
+
+    std::ofstream file(recording.indexPath().c_str(), std::ios::binary | std::ios::trunc);
+    file << "this is not an index file";
+    file.close();
+
+    PACO_CHECK_THROWS(paco::ContainerRecordWriter writer(recording.path()), std::runtime_error);
+}
+
+}
+
+void runRecordingTests(Runner& runner)
+{
+    runner.run("recording/continue", continueRecording);
+    runner.run("recording/continue_after_torn_entry", continueAfterTornEntry);
+    runner.run("recording/continue_after_entry_beyond_data", continueAfterEntryBeyondData);
+    runner.run("recording/reject_foreign_index", rejectForeignIndex);
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,250 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Container.h"
+#include "Specification.h"
+#include "SpecificationPattern.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Unrouted struct is a type no pattern mentions, registered before Marker so its id lies inside the
+ * columns of the router.
+ */
+struct Unrouted
+{
+    int value;
+};
+
+/**
+ * @brief The Marker struct is a type only the last but one pattern mentions, registered after Unrouted.
+ */
+struct Marker
+{
+    int value;
+};
+
+/**
+ * @brief The Late struct is a type that is registered only after the router has been compiled.
+ */
+struct Late
+{
+    int value;
+};
+
+const int Symbols = 8;
+
+/**
+ * @brief appendSymbol appends the packet type numbered symbol to a specification.
+ */
+void appendSymbol(paco::Specification& specification, int symbol)
+{
+    switch(symbol)
+    {
+    case 0: specification.append<int>(); break;
+    case 1: specification.append<double>(); break;
+    case 2: specification.append<float>(); break;
+    case 3: specification.append<std::string>(); break;
+    case 4: specification.append<char>(); break;
+    case 5: specification.append<Marker>(); break;
+    case 6: specification.append<Unrouted>(); break;
+    default: specification.append<Late>(); break;
+    }
+}
+
+/**
+ * @brief patterns returns exact, prefix, any type, optional and repeated patterns that overlap in many ways.
+ */
+std::vector<paco::SpecificationPattern> patterns()
+{
+    paco::PacketTypeRegistry::id<Unrouted>();
+
+    std::vector<paco::SpecificationPattern> patterns;
+
+    paco::Specification exact;
+    exact.append<int>();
+    exact.append<double>();
+    patterns.push_back(paco::SpecificationPattern(exact));
+
+    paco::Specification beginning;
+    beginning.append<int>();
+    beginning.append<std::string>();
+    patterns.push_back(paco::SpecificationPattern::prefix(beginning));
+
+    paco::SpecificationPattern anyThenDouble;
+    anyThenDouble.appendAny();
+    anyThenDouble.append<double>();
+    patterns.push_back(anyThenDouble);
+
+    paco::SpecificationPattern quantified;
+    quantified.append<int>();
+    quantified.appendOptional<float>();
+    quantified.appendRepeated<std::string>();
+    patterns.push_back(quantified);
+
+    paco::SpecificationPattern doubles;
+    doubles.appendRepeated<double>();
+    doubles.appendAny(paco::SpecificationPattern::Optional);
+    patterns.push_back(doubles);
+
+    paco::SpecificationPattern endsWithChar;
+    endsWithChar.appendAny(paco::SpecificationPattern::Repeated);
+    endsWithChar.append<char>();
+    patterns.push_back(endsWithChar);
+
+    paco::SpecificationPattern floatPair;
+    floatPair.append<float>();
+    floatPair.appendAny();
+    floatPair.appendOptional<float>();
+    patterns.push_back(floatPair);
+
+    paco::SpecificationPattern marked;
+    marked.append<Marker>();
+    marked.appendRest();
+    patterns.push_back(marked);
+
+    patterns.push_back(paco::SpecificationPattern());
+
+    return patterns;
+}
+
+/**
+ * @brief firstMatch returns the index of the first pattern matching a specification, or -1, without a router.
+ */
+int firstMatch(const std::vector<paco::SpecificationPattern>& patterns, const paco::Specification& specification)
+{
+    for(std::size_t p = 0; p < patterns.size(); p++)
+    {
+        if(patterns[p].matches(specification))
+        {
+            return p;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief checkAllSpecifications compares a router with the first match for every specification of up to four objects.
+ */
+void checkAllSpecifications(const paco::SpecificationRouter& router, const std::vector<paco::SpecificationPattern>& patterns)
+{
+    std::vector<int> symbols;
+
+    for(int length = 0; length <= 4; length++)
+    {
+        symbols.assign(length, 0);
+
+        while(true)
+        {
+            paco::Specification specification;
+            for(int i = 0; i < length; i++)
+            {
+                appendSymbol(specification, symbols[i]);
+            }
+
+            PACO_CHECK(router.route(specification) == firstMatch(patterns, specification));
+
+            // count to the next sequence of symbols
+            int i = length - 1;
+            while(i >= 0 && ++symbols[i] == Symbols)
+            {
+                symbols[i--] = 0;
+            }
+
+            if(i < 0)
+            {
+                break;
+            }
+        }
+    }
+}
+
+void routeIsFirstMatch()
+{
+    std::vector<paco::SpecificationPattern> forward = patterns();
+    std::vector<paco::SpecificationPattern> backward(forward.rbegin(), forward.rend());
+
+    paco::SpecificationRouter first;
+    paco::SpecificationRouter last;
+
+    for(std::size_t p = 0; p < forward.size(); p++)
+    {
+        PACO_CHECK(first.add(forward[p]) == (int)p);
+        last.add(backward[p]);
+    }
+
+    first.compile();
+    last.compile();
+
+    // Late gets its id only now, after both automata have been built
+    checkAllSpecifications(first, forward);
+    checkAllSpecifications(last, backward);
+
+    paco::Specification empty;
+    PACO_CHECK(first.route(empty) == 4);
+    PACO_CHECK(last.route(empty) == 0);
+}
+
+void dispatchCallsHandler()
+{
+    paco::SpecificationRouter router;
+    PACO_CHECK(router.route(paco::Specification()) == -1);
+
+    int routed = -1;
+    std::vector<paco::SpecificationPattern> all = patterns();
+
+    for(std::size_t p = 0; p < all.size(); p++)
+    {
+        router.add(all[p], [&routed, p](paco::Container&) { routed = p; });
+    }
+
+    PACO_CHECK_THROWS(router.route(paco::Specification()), std::logic_error);
+    router.compile();
+
+    paco::Container container;
+    container.append<int>(1);
+    container.append<std::string>("text");
+    container.append<Late>(Late{2});
+
+    PACO_CHECK(router.dispatch(container) == 1 && routed == 1);
+
+    container.clear();
+    container.append<Unrouted>(Unrouted{3});
+    routed = -1;
+    PACO_CHECK(router.dispatch(container) == 4 && routed == 4);
+
+    container.append<int>(4);
+    container.append<int>(5);
+    routed = -1;
+    PACO_CHECK(router.dispatch(container) == -1 && routed == -1);
+}
+
+}
+
+void runRouterTests(Runner& runner)
+{
+    runner.run("router/route_is_first_match", routeIsFirstMatch);
+    runner.run("router/dispatch_calls_handler", dispatchCallsHandler);
+}
+
+}
+}
@@ -0,0 +1,160 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Container.h"
+#include "SharedContainer.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief original returns a shared container holding an int, a text and a double.
+ */
+paco::SharedContainer original()
+{
+    paco::Container container;
+    container.append<int>(1);
+    container.append<std::string>("text");
+    container.append<double>(2.5);
+
+    return paco::SharedContainer(std::move(container));
+}
+
+/**
+ * @brief checkOriginal checks that a shared container still holds the objects of original().
+ */
+void checkOriginal(const paco::SharedContainer& container)
+{
+    PACO_CHECK(container.size() == 3);
+    PACO_CHECK(container.get<int>(0) == 1);
+    PACO_CHECK(container.get<std::string>(1) == "text");
+    PACO_CHECK(container.get<double>(2) == 2.5);
+    PACO_CHECK(container.specification() == original().specification());
+}
+
+void writeLeavesOtherHandles()
+{
+    paco::SharedContainer a = original();
+    paco::SharedContainer b = a;
+    paco::SharedContainer c = a;
+
+    b.replace<int>(0, 2);
+    PACO_CHECK(b.get<int>(0) == 2);
+    PACO_CHECK(!b.isShared());
+    checkOriginal(a);
+    checkOriginal(c);
+
+    // the unchanged objects are still shared, only the replaced slot has a new packet
+    PACO_CHECK(b.at(1) == a.at(1));
+    PACO_CHECK(b.at(0) != a.at(0));
+
+    c.append<float>(1.0f);
+    c.insert<int>(0, 7);
+    c.removeAt(1);
+    PACO_CHECK(c.size() == 4 && c.get<int>(0) == 7 && c.get<std::string>(1) == "text");
+    checkOriginal(a);
+
+    paco::SharedContainer d = a;
+    d.clear();
+    PACO_CHECK(d.size() == 0 && d.specification().size() == 0);
+    checkOriginal(a);
+    PACO_CHECK(!a.isShared());
+}
+
+void readPreservesSharing()
+{
+    paco::SharedContainer a = original();
+    paco::SharedContainer b = a;
+
+    PACO_CHECK(b.get<int>(0) == 1);
+    PACO_CHECK(b.get_if<std::string>(1) != nullptr);
+    PACO_CHECK(b.get_if<int>(1) == nullptr);
+    PACO_CHECK(b.matches(a.specification()));
+    PACO_CHECK(b.getSpecification() == a.specification());
+
+    paco::SharedPacket packet = b.packet(2);
+    PACO_CHECK(packet.get() == a.at(2));
+
+    PACO_CHECK(a.isShared() && b.isShared());
+    PACO_CHECK(&a.specification() == &b.specification());
+
+    for(int i = 0; i < a.size(); i++)
+    {
+        PACO_CHECK(a.at(i) == b.at(i));
+    }
+}
+
+void concurrentReaders()
+{
+    const int threads = 8;
+
+    const paco::SharedContainer source = original();
+    std::atomic<int> failures(0);
+    std::vector<std::thread> readers;
+
+    for(int t = 0; t < threads; t++)
+    {
+        readers.push_back(std::thread([&, t]
+        {
+            for(int i = 0; i < 10000; i++)
+            {
+                paco::SharedContainer copy = source;
+
+                if(copy.get<int>(0) != 1 || copy.get<std::string>(1) != "text" || copy.at(2) != source.at(2))
+                {
+                    failures++;
+                }
+
+                // a private modification of every other copy must not be visible to the others
+                if(i % 2 == 0)
+                {
+                    copy.replace<int>(0, t);
+
+                    if(copy.get<int>(0) != t || copy.get<double>(2) != 2.5)
+                    {
+                        failures++;
+                    }
+                }
+            }
+        }));
+    }
+
+    for(int t = 0; t < threads; t++)
+    {
+        readers[t].join();
+    }
+
+    PACO_CHECK(failures.load() == 0);
+    PACO_CHECK(!source.isShared());
+    checkOriginal(source);
+}
+
+}
+
+void runSharedContainerTests(Runner& runner)
+{
+    runner.run("shared_container/write_leaves_other_handles", writeLeavesOtherHandles);
+    runner.run("shared_container/read_preserves_sharing", readPreservesSharing);
+    runner.run("shared_container/concurrent_readers", concurrentReaders);
+}
+
+}
+}
@@ -0,0 +1,195 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Container.h"
+#include "ContainerCodec.h"
+#include "SharedMemoryRing.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+/**
+ * @brief The Frame struct is a flat type without registered codec, read in place by the reader.
+ */
+struct Frame
+{
+    std::int64_t sequence;
+    double values[4];
+};
+
+/**
+ * @brief ringName returns a segment name unique to this process and test case.
+ */
+std::string ringName(const std::string& name)
+{
+    return "/paco-test-" + name + "-" + std::to_string(::getpid());
+}
+
+/**
+ * @brief message builds the i-th message, its text grows and shrinks so records wrap at varying offsets.
+ */
+paco::Container message(int i, std::size_t maxText)
+{
+    Frame frame;
+    frame.sequence = i;
+    for(int v = 0; v < 4; v++)
+    {
+        frame.values[v] = i * 0.5 + v;
+    }
+
+    paco::Container container;
+    container.append<Frame>(frame);
+    container.append<int>(i);
+    container.append<std::string>(std::string((std::size_t)i * 131 % maxText, (char)('a' + i % 26)));
+
+    return container;
+}
+
+/**
+ * @brief readMessages is the reader process, it returns the exit status, 0 if all messages were read correctly.
+ */
+int readMessages(const std::string& name, int count, std::size_t maxText)
+{
+    try
+    {
+        paco::SharedMemoryRing ring(name);
+        paco::SharedMemoryMessage received;
+        int i = 0;
+
+        while(ring.read(received))
+        {
+            paco::Container expected = message(i, maxText);
+            paco::Container decoded = received.toContainer();
+
+            if(received.get<Frame>(0).sequence != i
+                    || received.get<Frame>(0).values[3] != expected.at(0)->get<Frame>().values[3]
+                    || decoded.at(1)->get<int>() != i
+                    || decoded.at(2)->get<std::string>() != expected.at(2)->get<std::string>())
+            {
+                return 2;
+            }
+
+            ring.release(received);
+            i++;
+        }
+
+        return i == count ? 0 : 3;
+    }
+    catch(...)
+    {
+        return 4;
+    }
+}
+
+void forkWriterReader()
+{
+    const int count = 5000;
+    const std::size_t maxText = 1500;
+    const std::string name = ringName("fork");
+
+    paco::SharedMemoryRing ring(name, 4096);
+
+    pid_t child = ::fork();
+    PACO_CHECK(child >= 0);
+
+    if(child == 0)
+    {
+        ::_exit(readMessages(name, count, maxText));
+    }
+
+    bool written = true;
+    for(int i = 0; i < count && written; i++)
+    {
+        written = ring.write(message(i, maxText));
+    }
+
+    ring.close();
+
+    int status = 0;
+    PACO_CHECK(::waitpid(child, &status, 0) == child);
+    PACO_CHECK(written);
+    PACO_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+/**
+ * @brief textOfSize returns a container whose encoded size is size rounded up to 8 bytes, at least that of an empty text.
+ */
+paco::Container textOfSize(std::size_t size)
+{
+    paco::Container container;
+    container.append<std::string>(std::string());
+
+    std::size_t empty = paco::ContainerCodec::encode(container).size();
+    container.replace<std::string>(0, std::string(size - empty, 'x'));
+
+    return container;
+}
+
+void oversizedMessageThrows()
+{
+    paco::SharedMemoryRing ring(ringName("oversized"), 4096);
+    paco::SharedMemoryMessage received;
+
+    // a 1456 byte record moves the head, a record of 2.9 KB would then never fit and the writer would spin
+    PACO_CHECK(ring.tryWrite(textOfSize(1456 - sizeof(std::uint64_t))));
+    PACO_CHECK(ring.tryRead(received));
+    ring.release(received);
+
+    PACO_CHECK_THROWS(ring.tryWrite(textOfSize(2900)), std::length_error);
+    PACO_CHECK_THROWS(ring.write(textOfSize(2900)), std::length_error);
+    PACO_CHECK_THROWS(ring.tryWrite(textOfSize(2048 - sizeof(std::uint64_t) + 1)), std::length_error);
+}
+
+void halfCapacityFitsAnywhere()
+{
+    const std::size_t largest = 2048 - sizeof(std::uint64_t);
+
+    paco::SharedMemoryRing ring(ringName("half"), 4096);
+    paco::SharedMemoryMessage received;
+
+    // the largest allowed message fits into the empty ring at every head position
+    for(std::size_t size = 64; size <= largest; size += 8)
+    {
+        PACO_CHECK(ring.tryWrite(textOfSize(size)));
+        PACO_CHECK(ring.tryRead(received));
+        ring.release(received);
+
+        PACO_CHECK(ring.tryWrite(textOfSize(largest)));
+        PACO_CHECK(ring.tryRead(received));
+        PACO_CHECK(received.byteSize() == largest);
+        ring.release(received);
+    }
+}
+
+}
+
+void runSharedMemoryTests(Runner& runner)
+{
+    runner.run("shared_memory/fork_writer_reader", forkWriterReader);
+    runner.run("shared_memory/oversized_message_throws", oversizedMessageThrows);
+    runner.run("shared_memory/half_capacity_fits_anywhere", halfCapacityFitsAnywhere);
+}
+
+}
+}
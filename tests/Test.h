@@ -0,0 +1,222 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PACO_TEST_H
+#define PACO_TEST_H
+
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief PACO_CHECK fails the running test case if a condition is false.
+ */
+#define PACO_CHECK(condition) \
+    paco::test::check((condition), #condition, __FILE__, __LINE__)
+
+/**
+ * @brief PACO_CHECK_THROWS fails the running test case unless a statement throws the exception type.
+ */
+#define PACO_CHECK_THROWS(statement, exception) \
+    do \
+    { \
+        bool thrown = false; \
+        try \
+        { \
+            statement; \
+        } \
+        catch(const exception&) \
+        { \
+            thrown = true; \
+        } \
+        paco::test::check(thrown, #statement " throws " #exception, __FILE__, __LINE__); \
+    } \
+    while(false)
+
+namespace paco
+{
+namespace test
+{
+
+/**
+ * @brief The Failure class is thrown by a failed check and ends the running test case.
+ */
+class Failure : public std::exception
+{
+public:
+
+    /**
+     * @brief Failure constructor.
+     * @param message the failed expression and its location.
+     */
+    explicit Failure(const std::string& message)
+        : mMessage(message)
+    {
+    }
+
+    virtual const char* what() const noexcept
+    {
+        return mMessage.c_str();
+    }
+
+private:
+
+    std::string mMessage;
+};
+
+/**
+ * @brief check throws a Failure if a condition is false, usually called through PACO_CHECK.
+ * @param condition the checked condition.
+ * @param expression the source text of the condition.
+ * @param file the source file.
+ * @param line the source line.
+ */
+inline void check(bool condition, const char* expression, const char* file, int line)
+{
+    if(!condition)
+    {
+        throw Failure(std::string(file) + ":" + std::to_string(line) + ": " + expression);
+    }
+}
+
+
+/**
+ * @brief The Runner class runs test cases, reports each result and counts the failures.
+ */
+class Runner
+{
+public:
+
+    /**
+     * @brief Runner constructor.
+     * @param filter only test cases whose name contains the filter are run.
+     */
+    explicit Runner(const std::string& filter)
+        : mFilter(filter), mPassed(0), mFailed(0)
+    {
+    }
+
+    /**
+     * @brief run runs one test case. A test case fails if it throws, e.g. from a failed PACO_CHECK.
+     * @param name the name of the test case, "suite/case".
+     * @param function the test case.
+     */
+    void run(const std::string& name, const std::function<void()>& function)
+    {
+        if(name.find(mFilter) == std::string::npos)
+        {
+            return;
+        }
+
+        try
+        {
+            function();
+
+            std::cout << "PASS " << name << std::endl;
+            mPassed++;
+        }
+        catch(const std::exception& exception)
+        {
+            std::cout << "FAIL " << name << ": " << exception.what() << std::endl;
+            mFailed++;
+        }
+    }
+
+    /**
+     * @brief passed returns the number of passed test cases.
+     * @return the number of passed test cases.
+     */
+    int passed() const
+    {
+        return mPassed;
+    }
+
+    /**
+     * @brief failed returns the number of failed test cases.
+     * @return the number of failed test cases.
+     */
+    int failed() const
+    {
+        return mFailed;
+    }
+
+private:
+
+    std::string mFilter;
+    int mPassed;
+    int mFailed;
+};
+
+
+/**
+ * @brief runCodecTests runs the round trip and malformed input tests of ContainerCodec.
+ */
+void runCodecTests(Runner& runner);
+
+/**
+ * @brief runContainerTests runs the tests of Container and its type index.
+ */
+void runContainerTests(Runner& runner);
+
+/**
+ * @brief runConcurrentTests runs the multi-threaded stress tests of ConcurrentContainer.
+ */
+void runConcurrentTests(Runner& runner);
+
+/**
+ * @brief runBatchTests runs the tests of ContainerBatch.
+ */
+void runBatchTests(Runner& runner);
+
+/**
+ * @brief runChannelTests runs the tests of the rings and ContainerChannel_T, with producer and consumer threads.
+ */
+void runChannelTests(Runner& runner);
+
+/**
+ * @brief runParallelTests runs the tests of the algorithms of paco::parallel.
+ */
+void runParallelTests(Runner& runner);
+
+/**
+ * @brief runPipelineTests runs the tests of Pipeline, with stages on worker threads.
+ */
+void runPipelineTests(Runner& runner);
+
+/**
+ * @brief runRouterTests runs the tests of SpecificationPattern and SpecificationRouter.
+ */
+void runRouterTests(Runner& runner);
+
+/**
+ * @brief runSharedContainerTests runs the copy-on-write tests of SharedContainer.
+ */
+void runSharedContainerTests(Runner& runner);
+
+/**
+ * @brief runSharedMemoryTests runs the tests of SharedMemoryRing, with a reader in a forked process.
+ */
+void runSharedMemoryTests(Runner& runner);
+
+/**
+ * @brief runValidationTests runs the tests of the batch validation at every instruction set the CPU supports.
+ */
+void runValidationTests(Runner& runner);
+
+/**
+ * @brief runRecordingTests runs the tests of ContainerRecordWriter and ContainerRecordReader, not available with PACO_NO_QT.
+ */
+void runRecordingTests(Runner& runner);
+
+}
+}
+
+#endif // PACO_TEST_H
@@ -0,0 +1,215 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BatchValidation.h"
+#include "Container.h"
+#include "Specification.h"
+#include "Test.h"
+
+namespace paco
+{
+namespace test
+{
+
+namespace
+{
+
+const std::size_t MaxBatch = 130;
+const int MaxSignature = 17;
+
+/**
+ * @brief appendObject appends an object of the type numbered symbol to a container.
+ */
+void appendObject(paco::Container& container, int symbol)
+{
+    switch(symbol % 6)
+    {
+    case 0: container.append<int>(1); break;
+    case 1: container.append<double>(2.0); break;
+    case 2: container.append<float>(3.0f); break;
+    case 3: container.append<char>('4'); break;
+    case 4: container.append<std::string>("5"); break;
+    default: container.append<bool>(true); break;
+    }
+}
+
+/**
+ * @brief specimen returns the container of the first length objects of the base signature.
+ */
+paco::Container specimen(int length)
+{
+    paco::Container container;
+    for(int i = 0; i < length; i++)
+    {
+        appendObject(container, i * 5 + 1);
+    }
+
+    return container;
+}
+
+/**
+ * @brief sameAsScalar checks that a mask equals the one of the scalar level bit for bit.
+ */
+bool sameAsScalar(const paco::MatchMask& mask, const paco::MatchMask& scalar)
+{
+    return mask.size() == scalar.size() && mask.words() == scalar.words();
+}
+
+void kernelsMatchScalar()
+{
+    std::mt19937_64 random(17);
+
+    for(int level = paco::simd::Scalar; level <= paco::simd::detected(); level++)
+    {
+        for(std::size_t count = 0; count <= MaxBatch; count++)
+        {
+            // one element in front, so the kernels load from an address that is not 16 byte aligned,
+            // and values that equal 42 in only one 32 bit half, which SSE2 compares separately
+            std::vector<std::uint64_t> values(count + 1);
+            for(std::size_t i = 0; i < values.size(); i++)
+            {
+                switch(random() % 5)
+                {
+                case 0: values[i] = 42; break;
+                case 1: values[i] = 42 | (random() << 32 | 1ull << 32); break;
+                case 2: values[i] = 43 + random() % 1000; break;
+                case 3: values[i] = 42ull << 32; break;
+                default: values[i] = random(); break;
+                }
+            }
+
+            std::vector<std::uint64_t> words((count + 63) / 64, 0);
+            std::vector<std::uint64_t> scalar((count + 63) / 64, 0);
+
+            paco::simd::Kernels::matchWords((paco::simd::Level)level, values.data() + 1, count, 42, words.data());
+            paco::simd::Kernels::matchWords(paco::simd::Scalar, values.data() + 1, count, 42, scalar.data());
+            PACO_CHECK(words == scalar);
+        }
+
+        paco::simd::Kernels::EqualIds equalIds = paco::simd::Kernels::equalIds((paco::simd::Level)level);
+
+        for(int length = 0; length <= MaxSignature; length++)
+        {
+            // exactly sized arrays, so a read behind the last id is reported by the address sanitizer
+            std::unique_ptr<std::int32_t[]> lhs(new std::int32_t[length + 1]);
+            std::unique_ptr<std::int32_t[]> rhs(new std::int32_t[length + 1]);
+
+            for(int i = 0; i < length; i++)
+            {
+                lhs[i + 1] = rhs[i + 1] = i * 3 + 1;
+            }
+
+            PACO_CHECK(equalIds(lhs.get() + 1, rhs.get() + 1, length));
+
+            for(int differs = 0; differs < length; differs++)
+            {
+                rhs[differs + 1]++;
+                PACO_CHECK(!equalIds(lhs.get() + 1, rhs.get() + 1, length));
+                PACO_CHECK(!paco::simd::Kernels::equalIds(paco::simd::Scalar)(lhs.get() + 1, rhs.get() + 1, length));
+                rhs[differs + 1]--;
+            }
+        }
+    }
+}
+
+void batchesMatchScalar()
+{
+    std::mt19937 random(5);
+
+    std::vector<paco::Specification> specifications;
+    for(int length = 0; length <= MaxSignature; length++)
+    {
+        specifications.push_back(specimen(length).specification());
+    }
+
+    for(std::size_t count = 0; count <= MaxBatch; count++)
+    {
+        // every signature length, half of them the base signature, the others with one object of another type
+        std::vector<paco::Container> containers;
+        std::vector<const paco::Container*> pointers;
+        paco::SignatureBatch signatures;
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            int length = random() % (MaxSignature + 1);
+            paco::Container container = specimen(length);
+
+            if(length > 0 && random() % 2 == 0)
+            {
+                int position = random() % length;
+                paco::Container changed;
+
+                for(int o = 0; o < length; o++)
+                {
+                    appendObject(changed, o * 5 + 1 + (o == position ? 1 + random() % 5 : 0));
+                }
+
+                container = std::move(changed);
+            }
+
+            containers.push_back(std::move(container));
+        }
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            pointers.push_back(&containers[i]);
+            signatures.append(containers[i]);
+        }
+
+        std::vector<paco::MatchMask> scalarBatches = paco::validateBatch(pointers.data(), count, specifications, paco::simd::Scalar);
+
+        for(std::size_t s = 0; s < specifications.size(); s++)
+        {
+            const paco::Specification& specification = specifications[s];
+            paco::MatchMask scalar = paco::validateBatch(pointers.data(), count, specification, paco::simd::Scalar);
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                PACO_CHECK(scalar.test(i) == containers[i].matches(specification));
+            }
+
+            PACO_CHECK(sameAsScalar(scalarBatches[s], scalar));
+
+            for(int level = paco::simd::Scalar; level <= paco::simd::detected(); level++)
+            {
+                PACO_CHECK(sameAsScalar(paco::validateBatch(pointers.data(), count, specification, (paco::simd::Level)level), scalar));
+                PACO_CHECK(sameAsScalar(signatures.validate(specification, (paco::simd::Level)level), scalar));
+            }
+        }
+
+        for(int level = paco::simd::Scalar; level <= paco::simd::detected(); level++)
+        {
+            std::vector<paco::MatchMask> batches = paco::validateBatch(pointers.data(), count, specifications, (paco::simd::Level)level);
+
+            for(std::size_t s = 0; s < specifications.size(); s++)
+            {
+                PACO_CHECK(sameAsScalar(batches[s], scalarBatches[s]));
+            }
+        }
+    }
+}
+
+}
+
+void runValidationTests(Runner& runner)
+{
+    runner.run("validation/kernels_match_scalar", kernelsMatchScalar);
+    runner.run("validation/batches_match_scalar", batchesMatchScalar);
+}
+
+}
+}
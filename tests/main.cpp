@@ -0,0 +1,66 @@
+// Package Container library (paco)
+
+// Copyright 2017 (c) Thomas Pollok (tom dot pollok at gmail dot com)
+
+// https://github.com/tompollok/paco
+
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// PacoTest runs the test suite and prints one line per test case:
+//
+//   PASS suite/case
+//   FAIL suite/case: file:line: expression
+//
+// Options:
+//
+//   --filter <text>  only run test cases whose name contains text
+//
+// The exit code is 1 if at least one test case failed.
+
+#include <iostream>
+#include <string>
+
+#include "Test.h"
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if(argument == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: PacoTest [--filter text]" << std::endl;
+            return 2;
+        }
+    }
+
+    paco::test::Runner runner(filter);
+
+    paco::test::runCodecTests(runner);
+    paco::test::runContainerTests(runner);
+    paco::test::runConcurrentTests(runner);
+    paco::test::runBatchTests(runner);
+    paco::test::runChannelTests(runner);
+    paco::test::runParallelTests(runner);
+    paco::test::runPipelineTests(runner);
+    paco::test::runRouterTests(runner);
+    paco::test::runSharedContainerTests(runner);
+    paco::test::runSharedMemoryTests(runner);
+    paco::test::runValidationTests(runner);
+#ifndef PACO_NO_QT
+    paco::test::runRecordingTests(runner);
+#endif
+
+    std::cout << runner.passed() << " passed, " << runner.failed() << " failed" << std::endl;
+
+    return runner.failed() == 0 ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+# Test suite of the Package Container library (paco).
+#
+# Build and run from a separate build directory:
+#
+#   qmake ../tests/tests.pro && make check
+#
+# See main.cpp for all options.
+
+QT += core
+QT -= gui
+
+CONFIG += c++17 console thread testcase
+CONFIG -= app_bundle
+
+TARGET = PacoTest
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+# SharedMemoryTests.cpp uses POSIX shared memory, which is in librt on older glibc versions.
+unix:!macx: LIBS += -lrt
+
+SOURCES += \
+    main.cpp \
+    BatchTests.cpp \
+    ChannelTests.cpp \
+    CodecTests.cpp \
+    ConcurrentTests.cpp \
+    ContainerTests.cpp \
+    ParallelTests.cpp \
+    PipelineTests.cpp \
+    RecordingTests.cpp \
+    RouterTests.cpp \
+    SharedContainerTests.cpp \
+    SharedMemoryTests.cpp \
+    ValidationTests.cpp
+
+HEADERS += \
+    Test.h